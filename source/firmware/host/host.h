@@ -0,0 +1,72 @@
+/* host.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/* Virtual clock (the Galileo Gen2 values) */
+#define HOST_CYCLES_PER_SEC		400000000	// Quark X1000 at 400 MHz
+#define HOST_TICKS_PER_SEC		100
+#define HOST_NSEC_PER_TICK		(1000000000LL / HOST_TICKS_PER_SEC)
+
+/* Run controls */
+#define HOST_RUN_MS				60000		// default simulated run time
+#define HOST_INPUT_MAX			4096		// recorded input lines
+#define HOST_BENCH_SLOWER_DIV		4		// report a kernel as slower past 1/4 (25%) more time
+
+/* One line of the input recording: the control values from 'ms' onward */
+struct HOST_INPUT_S {
+	uint32_t ms;			// simulated time, in mSec
+	int32_t  analog_x;		// raw ADC values (0..1023)
+	int32_t  analog_y;
+	int32_t  analog_z;
+	uint8_t  button_a;		// raw pin levels (1 = pressed)
+	uint8_t  button_b;
+};
+
+struct HOST_I2C_STATS_S {
+	uint32_t writes;		// write transactions
+	uint32_t reads;			// read transactions
+	uint32_t bytes;			// payload bytes (without the address byte)
+};
+
+/* Options */
+extern uint32_t host_run_ms;
+extern bool host_verbose;
+extern bool host_realtime_clock;
+
+/* host_kernel.c */
+uint64_t host_clock_ns();
+uint32_t host_clock_ms();
+void host_clock_skip(uint64_t ns);
+void host_kernel_init();
+bool host_in_isr();
+void host_isr_enter();
+void host_isr_exit();
+
+/* host_devices.c */
+void host_devices_init();
+bool host_inputs_load(const char *filename);
+void host_devices_update();
+uint64_t host_devices_next_ns();
+void host_devices_report();
+
+/* host_main.c */
+void host_exit();
+bool host_record_save(const char *filename);
+bool host_record_load(const char *filename);
@@ -0,0 +1,624 @@
+/* host_devices.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - Stand-in devices for the host build, behind the same driver calls as the
+ *    Galileo (see include/)
+ *  - Inputs: the ADC channels and the button pins replay an input recording,
+ *    one line per change: "<ms> <x> <y> <z> <button_a> <button_b>", in raw ADC
+ *    values and pin levels. The ADC conversion completes at once, calling the
+ *    firmware's callback as the ISR would. A change of the RED button's level
+ *    is delivered to the GPIO callback when the clock reaches it
+ *  - Outputs: the i2c transactions are delivered by address to a simulator of
+ *    each slave:
+ *      Grove LCD       : an in-memory 2x16 panel, decoding the AIP31068 control
+ *                        bytes, so the screen can be printed and compared
+ *      Grove RGB       : the backlight color registers
+ *      LED backpack    : the HT16K33 display RAM
+ *      Motor board     : the tower step positions, and the move progress
+ *                        (a move takes the frame period it was sent with)
+ *      Display board   : the last message
+ *  - An unknown address does not answer, like a missing slave
+ */
+
+#include <zephyr.h>
+
+#include <i2c.h>
+#include <gpio.h>
+#include <pwm.h>
+#include <adc.h>
+#include "groveLCD.h"
+#include "groveLCDUtils.h"
+#include "galileo2ADCPWM.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_space.h"
+#include "rocket_lcd.h"
+#include "rocket_button.h"
+#include "host.h"
+
+/* device bindings (setup.c on the target) */
+static struct device host_dev_i2c = { "I2C_0" };
+static struct device host_dev_gpio = { "GPIO_DW_0" };
+static struct device host_dev_pwm = { "PWM_0" };
+static struct device host_dev_adc = { "ADC_0" };
+static struct device host_dev_pinmux = { "PINMUX" };
+
+struct device *gpio07;
+struct device *pwm;
+struct device *adc;
+struct device *pinmux;
+
+/* recorded inputs */
+static struct HOST_INPUT_S host_input[HOST_INPUT_MAX];
+static uint32_t host_input_count = 0;
+static uint32_t host_input_next = 0;
+static struct HOST_INPUT_S host_input_now;
+
+/* GPIO and ADC callbacks */
+static gpio_callback_t host_gpio_callback = NULL;
+static bool host_gpio_enabled = false;
+static adc_callback_t host_adc_callback = NULL;
+static uint32_t host_adc_conversions = 0;
+
+/* Grove LCD */
+#define HOST_LCD_DDRAM_ROW	40		// DDRAM bytes per row
+#define HOST_LCD_CO			0x80	// control byte: another control byte follows the item
+#define HOST_LCD_RS			0x40	// control byte: the item is data, not a command
+static char host_lcd[LCD_ROW_MAX][HOST_LCD_DDRAM_ROW];
+static char host_lcd_shown[LCD_ROW_MAX][LCD_COL_MAX];
+static uint8_t host_lcd_row = 0;
+static uint8_t host_lcd_col = 0;
+static uint8_t host_lcd_rgb[3];
+
+/* HT16K33 */
+#define HOST_BACKPACK_RAM	16
+static uint8_t host_backpack[HOST_BACKPACK_RAM];
+
+/* Motor board */
+static int32_t host_motor_steps[4];
+static int32_t host_ground_steps[ROCKET_GROUND_MAX];
+static uint32_t host_motor_move_start = 0;
+static uint32_t host_motor_move_ms = 0;
+static uint8_t host_motor_sequence = 0;
+
+/* Display board */
+#define HOST_DISPLAY_MAX	32
+static uint8_t host_display[HOST_DISPLAY_MAX];
+static uint32_t host_display_len = 0;
+
+/* pan and tilt */
+static uint8_t host_pan = 0;
+static uint8_t host_tilt = 0;
+
+/* traffic by slave */
+#define HOST_I2C_ADDR_MAX	128
+static struct HOST_I2C_STATS_S host_i2c[HOST_I2C_ADDR_MAX];
+static uint32_t host_i2c_missing = 0;
+
+/*
+ * host_devices_init : bind the devices, idle inputs
+ *
+ */
+
+void host_devices_init() {
+	i2c = &host_dev_i2c;
+	gpio07 = &host_dev_gpio;
+	pwm = &host_dev_pwm;
+	adc = &host_dev_adc;
+	pinmux = &host_dev_pinmux;
+
+	host_input_now.ms = 0;
+	host_input_now.analog_x = JOYSTICK_X_MID;
+	host_input_now.analog_y = JOYSTICK_Y_MID;
+	host_input_now.analog_z = JOYSTICK_Z_INVERT ? (1023 - JOYSTICK_Z_MID) : JOYSTICK_Z_MID;
+	host_input_now.button_a = 0;
+	host_input_now.button_b = 0;
+
+	memset(host_lcd,' ',sizeof(host_lcd));
+	memset(host_lcd_shown,' ',sizeof(host_lcd_shown));
+	memset(host_i2c,0,sizeof(host_i2c));
+}
+
+/*
+ * host_inputs_load : read an input recording
+ *
+ */
+
+bool host_inputs_load(const char *filename) {
+	struct HOST_INPUT_S *in;
+	char line[128];
+	uint32_t line_count = 0;
+	FILE *fp;
+	int a,b;
+
+	fp = fopen(filename,"r");
+	if (NULL == fp) {
+		printf("HOST: cannot open '%s'\n",filename);
+		return false;
+	}
+
+	host_input_count = 0;
+	while (fgets(line,sizeof(line),fp)) {
+		line_count++;
+		if (('#' == line[0]) || ('\n' == line[0]))
+			continue;
+		if (host_input_count >= HOST_INPUT_MAX) {
+			printf("HOST: %s: more than %d inputs\n",filename,HOST_INPUT_MAX);
+			break;
+		}
+		in = &host_input[host_input_count];
+		if (6 != sscanf(line,"%u %d %d %d %d %d",&in->ms,&in->analog_x,&in->analog_y,&in->analog_z,&a,&b)) {
+			printf("HOST: %s:%d: expected '<ms> <x> <y> <z> <button_a> <button_b>'\n",filename,line_count);
+			continue;
+		}
+		in->button_a = (0 != a);
+		in->button_b = (0 != b);
+		host_input_count++;
+	}
+	fclose(fp);
+	host_input_next = 0;
+	return true;
+}
+
+/*
+ * host_devices_update : apply the recorded inputs up to now, and raise the button interrupt
+ *
+ */
+
+void host_devices_update() {
+	uint32_t now = host_clock_ms();
+	uint8_t button_a_prev = host_input_now.button_a;
+
+	while ((host_input_next < host_input_count) && (host_input[host_input_next].ms <= now)) {
+		host_input_now = host_input[host_input_next++];
+	}
+
+	if ((button_a_prev != host_input_now.button_a) && host_gpio_enabled && host_gpio_callback) {
+		host_isr_enter();
+		host_gpio_callback(gpio07,BUTTON_A_GPIO);
+		host_isr_exit();
+	}
+}
+
+/*
+ * host_devices_next_ns : time of the next recorded input change (or never)
+ *
+ */
+
+uint64_t host_devices_next_ns() {
+	if (host_input_next >= host_input_count)
+		return UINT64_MAX;
+	return (uint64_t) host_input[host_input_next].ms * 1000000ULL;
+}
+
+/*
+ * GPIO
+ *
+ */
+
+int gpioInputGet(int pin) {
+	if (INPUT_A_PIN == pin)
+		return host_input_now.button_a;
+	if (INPUT_B_PIN == pin)
+		return host_input_now.button_b;
+	return 0;
+}
+
+void gpioOutputSet(int pin, int value) {
+}
+
+int gpio_pin_configure(struct device *port, uint32_t pin, int flags) {
+	return DEV_OK;
+}
+
+int gpio_pin_read(struct device *port, uint32_t pin, uint32_t *value) {
+	*value = (BUTTON_A_GPIO == pin) ? host_input_now.button_a : 0;
+	return DEV_OK;
+}
+
+int gpio_pin_write(struct device *port, uint32_t pin, uint32_t value) {
+	return DEV_OK;
+}
+
+int gpio_set_callback(struct device *port, gpio_callback_t callback) {
+	host_gpio_callback = callback;
+	return DEV_OK;
+}
+
+int gpio_pin_enable_callback(struct device *port, uint32_t pin) {
+	if (BUTTON_A_GPIO == pin)
+		host_gpio_enabled = true;
+	return DEV_OK;
+}
+
+int gpio_pin_disable_callback(struct device *port, uint32_t pin) {
+	if (BUTTON_A_GPIO == pin)
+		host_gpio_enabled = false;
+	return DEV_OK;
+}
+
+/*
+ * ADC
+ *
+ */
+
+void adc_enable(struct device *dev) {
+}
+
+void adc_disable(struct device *dev) {
+}
+
+void adc_set_callback(struct device *dev, adc_callback_t callback) {
+	host_adc_callback = callback;
+}
+
+int adc_read(struct device *dev, struct adc_seq_table *seq_table) {
+	uint16_t value;
+	uint32_t j;
+	uint8_t i;
+
+	for (i=0;i<seq_table->num_entries;i++) {
+		switch (seq_table->entries[i].channel_id) {
+			case JOYSTICK_X_PORT : value = host_input_now.analog_x; break;
+			case JOYSTICK_Y_PORT : value = host_input_now.analog_y; break;
+			case JOYSTICK_Z_PORT : value = host_input_now.analog_z; break;
+			default              : value = 0;
+		}
+		// every sample of the buffer (its length is in bytes)
+		for (j=0;(j + sizeof(value))<=seq_table->entries[i].buffer_length;j+=sizeof(value)) {
+			memcpy(&seq_table->entries[i].buffer[j],&value,sizeof(value));
+		}
+	}
+	host_adc_conversions++;
+
+	if (host_adc_callback) {
+		host_isr_enter();
+		host_adc_callback(dev,ADC_CB_DONE);
+		host_isr_exit();
+	}
+	return DEV_OK;
+}
+
+/*
+ * PWM
+ *
+ */
+
+int pwm_pin_set_duty_cycle(struct device *dev, uint32_t pin, uint8_t duty) {
+	if (PWM_PAN_PWM == pin)
+		host_pan = duty;
+	if (PWM_TILT_PWM == pin)
+		host_tilt = duty;
+	return DEV_OK;
+}
+
+/*
+ * host_lcd_print : print the panel
+ *
+ */
+
+static void host_lcd_print() {
+	printf("HOST: LCD |%.*s|\n",LCD_COL_MAX,host_lcd[0]);
+	printf("HOST:     |%.*s|\n",LCD_COL_MAX,host_lcd[1]);
+}
+
+/*
+ * host_lcd_command : HD44780 command
+ *
+ */
+
+static void host_lcd_command(uint8_t command) {
+	if (command & LCD_SET_DDRAM) {
+		host_lcd_row = (command & LCD_ROW_OFFSET) ? 1 : 0;
+		host_lcd_col = (command & ~(LCD_SET_DDRAM | LCD_ROW_OFFSET)) % HOST_LCD_DDRAM_ROW;
+	} else if (LCD_CLEAR == command) {
+		memset(host_lcd,' ',sizeof(host_lcd));
+		host_lcd_row = 0;
+		host_lcd_col = 0;
+	} else if (LCD_RETURN_HOME == command) {
+		host_lcd_row = 0;
+		host_lcd_col = 0;
+	}
+}
+
+/*
+ * host_lcd_data : HD44780 data write at the cursor
+ *
+ */
+
+static void host_lcd_data(uint8_t data) {
+	host_lcd[host_lcd_row][host_lcd_col] = data;
+	host_lcd_col = (host_lcd_col + 1) % HOST_LCD_DDRAM_ROW;
+}
+
+/*
+ * host_lcd_write : AIP31068 transaction, a control byte before each item
+ *
+ */
+
+static void host_lcd_write(uint8_t *buf, uint32_t len) {
+	uint32_t i = 0;
+	uint8_t control;
+	bool data;
+
+	while (i < len) {
+		control = buf[i++];
+		data = (0 != (control & HOST_LCD_RS));
+		if (control & HOST_LCD_CO) {
+			// one item, then another control byte
+			if (i < len) {
+				if (data) host_lcd_data(buf[i]); else host_lcd_command(buf[i]);
+				i++;
+			}
+		} else {
+			// the rest of the transaction
+			for (;i<len;i++) {
+				if (data) host_lcd_data(buf[i]); else host_lcd_command(buf[i]);
+			}
+		}
+	}
+
+	if (host_verbose) {
+		uint8_t row;
+
+		for (row=0;row<LCD_ROW_MAX;row++) {
+			if (memcmp(host_lcd_shown[row],host_lcd[row],LCD_COL_MAX)) {
+				memcpy(host_lcd_shown,host_lcd,sizeof(host_lcd_shown));
+				printf("HOST: %6d ms\n",host_clock_ms());
+				host_lcd_print();
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * Grove LCD library
+ *
+ */
+
+void groveLcdInit(struct device *dev) {
+	host_lcd_command(LCD_CLEAR);
+	memset(host_lcd_rgb,0xff,sizeof(host_lcd_rgb));
+}
+
+void groveLcdCommand(struct device *dev, uint8_t command) {
+	host_lcd_command(command);
+}
+
+void groveLcdClear(struct device *dev) {
+	host_lcd_command(LCD_CLEAR);
+}
+
+void groveLcdColorSet(struct device *dev, uint8_t red, uint8_t green, uint8_t blue) {
+	host_lcd_rgb[0] = red;
+	host_lcd_rgb[1] = green;
+	host_lcd_rgb[2] = blue;
+	host_i2c[GROVE_RGB_I2C_ADDRESS].writes += 3;
+	host_i2c[GROVE_RGB_I2C_ADDRESS].bytes += 6;
+}
+
+void groveLcdCursorSet(struct device *dev, uint8_t col, uint8_t row) {
+	host_lcd_command(LCD_SET_DDRAM | ((row * LCD_ROW_OFFSET) + col));
+}
+
+void groveLcdCursor(struct device *dev, uint8_t on) {
+}
+
+void groveLcdBlink(struct device *dev, uint8_t on) {
+}
+
+void groveLcdPrint(struct device *dev, uint8_t col, uint8_t row, char *text, int len) {
+	int i;
+
+	groveLcdCursorSet(dev,col,row);
+	for (i=0;i<len;i++)
+		host_lcd_data(text[i]);
+}
+
+/*
+ * host_motor_write : Rocket motor board command
+ *
+ */
+
+static void host_motor_write(uint8_t *buf, uint32_t len) {
+	uint8_t i,motor;
+
+	if ((ROCKET_MOTOR_CMD_NEXT == buf[0]) && (len >= 11)) {
+		for (i=0;i<4;i++)
+			host_motor_steps[i] += (int16_t) ((buf[1+(i*2)] << 8) | buf[2+(i*2)]);
+		host_motor_move_start = host_clock_ms();
+		host_motor_move_ms = (buf[9] << 8) | buf[10];
+	} else if (('l' == buf[0]) && (len >= 9)) {
+		// tower positions are unsigned microsteps
+		for (i=0;i<4;i++)
+			host_motor_steps[i] = (uint16_t) ((buf[1+(i*2)] << 8) | buf[2+(i*2)]);
+	} else if ((buf[0] >= '0') && (buf[0] <= '9') && (len >= 4)) {
+		motor = ((buf[0] - '0') * 10) + (buf[1] - '0');
+		if ((motor >= 4) && (motor < (4 + ROCKET_GROUND_MAX)))
+			host_ground_steps[motor-4] = (buf[2] << 8) | buf[3];
+	}
+}
+
+/*
+ * host_motor_progress : percent done of the current move
+ *
+ */
+
+static uint8_t host_motor_progress() {
+	uint32_t elapsed = host_clock_ms() - host_motor_move_start;
+
+	if ((0 == host_motor_move_ms) || (elapsed >= host_motor_move_ms))
+		return 100;
+	return (uint8_t) ((elapsed * 100) / host_motor_move_ms);
+}
+
+/*
+ * host_motor_status : build the motor board's status frame
+ *
+ *  The model applies moves at once, so the locations are the destinations
+ *
+ */
+
+static void host_motor_status_put16(uint8_t *frame, uint8_t offset, uint16_t value) {
+	frame[offset]   = (uint8_t) (value >> 8);
+	frame[offset+1] = (uint8_t) value;
+}
+
+static void host_motor_status(uint8_t *frame) {
+	uint32_t elapsed = host_clock_ms() - host_motor_move_start;
+	uint8_t sum=0;
+	int i;
+
+	memset(frame,0,ROCKET_MOTOR_STATUS_LEN);
+	frame[ROCKET_MOTOR_STATUS_PROGRESS] = host_motor_progress();
+	frame[ROCKET_MOTOR_STATUS_VERSION_OFFSET] = ROCKET_MOTOR_STATUS_VERSION;
+	frame[ROCKET_MOTOR_STATUS_SEQUENCE] = host_motor_sequence++;
+	frame[ROCKET_MOTOR_STATUS_FLAGS] = ROCKET_MOTOR_FLAG_ROCKET_POWER | ROCKET_MOTOR_FLAG_GROUND_POWER;
+	if (elapsed < host_motor_move_ms) {
+		frame[ROCKET_MOTOR_STATUS_FLAGS] |= ROCKET_MOTOR_FLAG_ROCKET_MOVING;
+		host_motor_status_put16(frame,ROCKET_MOTOR_STATUS_ROCKET_REMAIN,(uint16_t) (host_motor_move_ms - elapsed));
+	}
+	for (i=0;i<4;i++) {
+		host_motor_status_put16(frame,ROCKET_MOTOR_STATUS_LOCATION    + (i*2),(uint16_t) host_motor_steps[i]);
+		host_motor_status_put16(frame,ROCKET_MOTOR_STATUS_DESTINATION + (i*2),(uint16_t) host_motor_steps[i]);
+	}
+	for (i=0;i<(ROCKET_MOTOR_STATUS_LEN-1);i++)
+		sum += frame[i];
+	frame[ROCKET_MOTOR_STATUS_CHECKSUM] = (uint8_t) (0 - sum);
+}
+
+/*
+ * I2C
+ *
+ */
+
+int i2c_write(struct device *dev, uint8_t *buf, uint32_t len, uint16_t addr) {
+	uint32_t i;
+
+	if (addr >= HOST_I2C_ADDR_MAX)
+		return DEV_NO_RESPONSE;
+
+	switch (addr) {
+		case GROVE_LCD_I2C_ADDRESS :
+			host_lcd_write(buf,len);
+			break;
+		case GROVE_RGB_I2C_ADDRESS :
+			// register, value: the color registers are 2..4
+			if ((len >= 2) && (buf[0] >= 2) && (buf[0] <= 4))
+				host_lcd_rgb[buf[0]-2] = buf[1];
+			break;
+		case LED_BACKPACK_I2C_ADDRESS :
+			// display RAM from the address pointer (0x00..0x0F, wrapping), otherwise a command
+			if (buf[0] < HOST_BACKPACK_RAM) {
+				for (i=1;i<len;i++)
+					host_backpack[(buf[0]+i-1) % HOST_BACKPACK_RAM] = buf[i];
+			}
+			break;
+		case ROCKET_MOTOR_I2C_ADDRESS :
+			host_motor_write(buf,len);
+			break;
+		case ROCKET_DISPLAY_I2C_ADDRESS :
+			host_display_len = (len < HOST_DISPLAY_MAX) ? len : HOST_DISPLAY_MAX;
+			memcpy(host_display,buf,host_display_len);
+			break;
+		default :
+			host_i2c_missing++;
+			return DEV_NO_RESPONSE;
+	}
+
+	host_i2c[addr].writes++;
+	host_i2c[addr].bytes += len;
+	return DEV_OK;
+}
+
+int i2c_read(struct device *dev, uint8_t *buf, uint32_t len, uint16_t addr) {
+	uint8_t frame[ROCKET_MOTOR_STATUS_LEN];
+
+	if ((addr >= HOST_I2C_ADDR_MAX) || (ROCKET_MOTOR_I2C_ADDRESS != addr)) {
+		host_i2c_missing++;
+		return DEV_NO_RESPONSE;
+	}
+
+	// the motor board returns (the start of) its status frame, then zeros
+	host_motor_status(frame);
+	memset(buf,0,len);
+	memcpy(buf,frame,(len < ROCKET_MOTOR_STATUS_LEN) ? len : ROCKET_MOTOR_STATUS_LEN);
+
+	host_i2c[addr].reads++;
+	host_i2c[addr].bytes += len;
+	return DEV_OK;
+}
+
+int i2c_polling_write(struct device *dev, uint8_t *buf, uint32_t len, uint16_t addr) {
+	return i2c_write(dev,buf,len,addr);
+}
+
+int i2c_polling_read(struct device *dev, uint8_t *buf, uint32_t len, uint16_t addr) {
+	return i2c_read(dev,buf,len,addr);
+}
+
+/*
+ * setup : the host devices need no pin configuration
+ *
+ */
+
+int setup(void) {
+	return DEV_OK;
+}
+
+/*
+ * host_devices_report : final device state and bus traffic
+ *
+ */
+
+void host_devices_report() {
+	uint32_t addr;
+	uint8_t i;
+
+	host_lcd_print();
+	printf("HOST: LCD RGB = %d,%d,%d\n",host_lcd_rgb[0],host_lcd_rgb[1],host_lcd_rgb[2]);
+	printf("HOST: Backpack RAM =");
+	for (i=0;i<10;i++)
+		printf(" %02x",host_backpack[i]);
+	printf("\n");
+	printf("HOST: Motor steps = %d,%d,%d,%d (progress %d%%)\n",
+		host_motor_steps[0],host_motor_steps[1],host_motor_steps[2],host_motor_steps[3],
+		host_motor_progress());
+	printf("HOST: Display board = '%.*s' (%d bytes)\n",host_display_len,host_display,host_display_len);
+	printf("HOST: Pan/Tilt = %d,%d\n",host_pan,host_tilt);
+	printf("HOST: ADC conversions = %d, inputs replayed = %d of %d\n",
+		host_adc_conversions,host_input_next,host_input_count);
+	for (addr=0;addr<HOST_I2C_ADDR_MAX;addr++) {
+		if (host_i2c[addr].writes || host_i2c[addr].reads) {
+			printf("HOST: i2c 0x%02x: writes=%d reads=%d bytes=%d\n",
+				addr,host_i2c[addr].writes,host_i2c[addr].reads,host_i2c[addr].bytes);
+		}
+	}
+	if (host_i2c_missing)
+		printf("HOST: i2c transactions to missing slaves = %d\n",host_i2c_missing);
+}
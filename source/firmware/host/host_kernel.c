@@ -0,0 +1,442 @@
+/* host_kernel.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - The host build runs the firmware as a single task, with IO_TASKS_ENABLE and
+ *    DEBUG_LOG_DEFERRED off (see ROCKET_HOST in rocket.h), so the microkernel
+ *    objects only need to keep their counts, never to switch tasks
+ *  - The virtual clock is the host's monotonic clock plus all of the time
+ *    skipped so far. A sleep, a timer wait, or a wait with a timeout skips
+ *    ahead rather than waiting, so the frame loop runs as fast as the host can
+ *    compute it, while the profiler still measures the real compute time
+ *  - With host_realtime_clock false only the skips advance the clock, so a run
+ *    is repeatable to the cycle
+ *  - A skip stops at each recorded input change on the way, so that the GPIO
+ *    interrupt for it is delivered at its time, and ends the run at host_run_ms
+ *    or at the end of a replayed recording
+ *  - A wait that nothing could ever satisfy (e.g. an unlimited wait on an
+ *    event) would hang the single task, so it is reported and fails instead
+ */
+
+#include <zephyr.h>
+#include <atomic.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "rocket.h"
+#include "rocket_record.h"
+#include "host.h"
+
+/* mdef objects */
+#define HOST_EVENT_MAX	4
+#define HOST_SEM_MAX	4
+
+const ktask_group_t EXE = 0;
+const ktask_group_t PIPE = 1;
+const kevent_t ADCREADY = 0;
+const kmutex_t I2CBUS = 0;
+const ksem_t FRAMEREADY = 0;
+
+int32_t sys_clock_ticks_per_sec = HOST_TICKS_PER_SEC;
+int sys_clock_hw_cycles_per_sec = HOST_CYCLES_PER_SEC;
+
+static bool host_event[HOST_EVENT_MAX];
+static uint32_t host_sem[HOST_SEM_MAX];
+static uint32_t host_mutex_depth = 0;
+static uint32_t host_isr_depth = 0;
+
+static struct timespec host_clock_start;
+static uint64_t host_clock_skipped = 0;
+
+/*
+ * host_kernel_init : start the virtual clock
+ *
+ */
+
+void host_kernel_init() {
+	clock_gettime(CLOCK_MONOTONIC,&host_clock_start);
+	host_clock_skipped = 0;
+	memset(host_event,0,sizeof(host_event));
+	memset(host_sem,0,sizeof(host_sem));
+}
+
+/*
+ * host_clock_ns : virtual time since the start, in nSec
+ *
+ */
+
+uint64_t host_clock_ns() {
+	struct timespec now;
+	uint64_t ns = host_clock_skipped;
+
+	if (host_realtime_clock) {
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		ns += ((uint64_t) (now.tv_sec - host_clock_start.tv_sec) * 1000000000ULL) +
+			  (uint64_t) now.tv_nsec - (uint64_t) host_clock_start.tv_nsec;
+	}
+	return ns;
+}
+
+uint32_t host_clock_ms() {
+	return (uint32_t) (host_clock_ns() / 1000000ULL);
+}
+
+/*
+ * host_clock_skip : advance the virtual clock instead of waiting
+ *
+ */
+
+void host_clock_skip(uint64_t ns) {
+	uint64_t until = host_clock_ns() + ns;
+	uint64_t now,next;
+
+	// stop at each recorded input change on the way, so that none is missed
+	host_devices_update();
+	while (1) {
+		now = host_clock_ns();
+		if (now >= until)
+			break;
+		next = host_devices_next_ns();
+		if (next > until)
+			next = until;
+		if (next > now)
+			host_clock_skipped += next - now;
+		host_devices_update();
+	}
+	if ((host_clock_ms() >= host_run_ms) || (RECORD_DONE == r_record.mode))
+		host_exit();
+}
+
+/*
+ * host_clock_skip_ticks : advance the virtual clock to the start of a later tick
+ *
+ */
+
+static void host_clock_skip_ticks(int32_t ticks) {
+	uint64_t now = host_clock_ns();
+	uint64_t until = ((now / HOST_NSEC_PER_TICK) + ticks) * HOST_NSEC_PER_TICK;
+
+	if (ticks <= 0)
+		return;
+	host_clock_skip(until - now);
+}
+
+/*
+ * clock
+ *
+ */
+
+uint32_t sys_cycle_get_32(void) {
+	return (uint32_t) ((host_clock_ns() * (HOST_CYCLES_PER_SEC / 1000000ULL)) / 1000ULL);
+}
+
+uint32_t task_cycle_get_32(void) {
+	return sys_cycle_get_32();
+}
+
+int64_t task_tick_get(void) {
+	return (int64_t) (host_clock_ns() / HOST_NSEC_PER_TICK);
+}
+
+uint32_t task_tick_get_32(void) {
+	return (uint32_t) task_tick_get();
+}
+
+/*
+ * tasks
+ *
+ */
+
+void task_sleep(int32_t ticks) {
+	host_clock_skip_ticks(ticks);
+}
+
+ktask_t task_id_get(void) {
+	return 0;
+}
+
+void task_group_start(ktask_group_t group) {
+	// there are no other tasks on the host
+	printf("HOST: task group %d not started\n",group);
+}
+
+int sys_execution_context_type_get(void) {
+	return host_isr_depth ? NANO_CTX_ISR : NANO_CTX_TASK;
+}
+
+bool host_in_isr() {
+	return host_isr_depth > 0;
+}
+
+void host_isr_enter() {
+	host_isr_depth++;
+}
+
+void host_isr_exit() {
+	host_isr_depth--;
+}
+
+/*
+ * events
+ *
+ */
+
+int task_event_send(kevent_t event) {
+	host_event[event] = true;
+	return RC_OK;
+}
+
+void isr_event_send(kevent_t event) {
+	host_event[event] = true;
+}
+
+int task_event_recv(kevent_t event) {
+	if (!host_event[event])
+		return RC_FAIL;
+	host_event[event] = false;
+	return RC_OK;
+}
+
+int task_event_recv_wait_timeout(kevent_t event, int32_t ticks) {
+	if (host_event[event]) {
+		host_event[event] = false;
+		return RC_OK;
+	}
+	if (TICKS_UNLIMITED == ticks) {
+		printf("HOST: wait on event %d that nothing can send\n",event);
+		return RC_FAIL;
+	}
+	host_clock_skip_ticks(ticks);
+	return task_event_recv(event);
+}
+
+int task_event_recv_wait(kevent_t event) {
+	return task_event_recv_wait_timeout(event,TICKS_UNLIMITED);
+}
+
+/*
+ * mutexes and semaphores
+ *
+ */
+
+int task_mutex_lock(kmutex_t mutex, int32_t ticks) {
+	host_mutex_depth++;
+	return RC_OK;
+}
+
+void task_mutex_unlock(kmutex_t mutex) {
+	host_mutex_depth--;
+}
+
+void task_sem_give(ksem_t sem) {
+	host_sem[sem]++;
+}
+
+void isr_sem_give(ksem_t sem) {
+	host_sem[sem]++;
+}
+
+int task_sem_take(ksem_t sem, int32_t ticks) {
+	if (0 == host_sem[sem]) {
+		if (TICKS_UNLIMITED == ticks) {
+			printf("HOST: wait on semaphore %d that nothing can give\n",sem);
+			return RC_FAIL;
+		}
+		host_clock_skip_ticks(ticks);
+		if (0 == host_sem[sem])
+			return RC_TIME;
+	}
+	host_sem[sem]--;
+	return RC_OK;
+}
+
+/*
+ * interrupts
+ *
+ */
+
+unsigned int irq_lock(void) {
+	return 0;
+}
+
+void irq_unlock(unsigned int key) {
+}
+
+/*
+ * nanokernel FIFO
+ *
+ */
+
+void nano_fifo_init(struct nano_fifo *fifo) {
+	fifo->head = NULL;
+	fifo->tail = NULL;
+}
+
+void nano_fifo_put(struct nano_fifo *fifo, void *data) {
+	*(void **) data = NULL;
+	if (NULL == fifo->tail) {
+		fifo->head = data;
+	} else {
+		*(void **) fifo->tail = data;
+	}
+	fifo->tail = data;
+}
+
+void nano_task_fifo_put(struct nano_fifo *fifo, void *data) {
+	nano_fifo_put(fifo,data);
+}
+
+void nano_isr_fifo_put(struct nano_fifo *fifo, void *data) {
+	nano_fifo_put(fifo,data);
+}
+
+void *nano_fifo_get(struct nano_fifo *fifo, int32_t ticks) {
+	void *data = fifo->head;
+
+	if (NULL == data) {
+		host_clock_skip_ticks(ticks);
+		return NULL;
+	}
+	fifo->head = *(void **) data;
+	if (NULL == fifo->head)
+		fifo->tail = NULL;
+	return data;
+}
+
+void *nano_task_fifo_get(struct nano_fifo *fifo, int32_t ticks) {
+	return nano_fifo_get(fifo,ticks);
+}
+
+/*
+ * nanokernel semaphore
+ *
+ */
+
+void nano_sem_init(struct nano_sem *sem) {
+	sem->count = 0;
+}
+
+void nano_task_sem_give(struct nano_sem *sem) {
+	sem->count++;
+}
+
+void nano_fiber_sem_give(struct nano_sem *sem) {
+	sem->count++;
+}
+
+void nano_isr_sem_give(struct nano_sem *sem) {
+	sem->count++;
+}
+
+int nano_task_sem_take(struct nano_sem *sem, int32_t ticks) {
+	if (0 == sem->count) {
+		host_clock_skip_ticks(ticks);
+		if (0 == sem->count)
+			return 0;
+	}
+	sem->count--;
+	return 1;
+}
+
+/*
+ * nanokernel timer
+ *
+ */
+
+void nano_timer_init(struct nano_timer *timer, void *data) {
+	timer->user_data = data;
+	timer->running = false;
+}
+
+void nano_timer_start(struct nano_timer *timer, int ticks) {
+	timer->expiry = task_tick_get_32() + ticks;
+	timer->running = true;
+}
+
+void nano_task_timer_start(struct nano_timer *timer, int ticks) {
+	nano_timer_start(timer,ticks);
+}
+
+void nano_task_timer_stop(struct nano_timer *timer) {
+	timer->running = false;
+}
+
+void *nano_timer_test(struct nano_timer *timer, int32_t ticks) {
+	int32_t remaining;
+
+	if (!timer->running)
+		return NULL;
+	remaining = (int32_t) (timer->expiry - task_tick_get_32());
+	if (remaining > 0) {
+		if (TICKS_NONE == ticks)
+			return NULL;
+		if ((TICKS_UNLIMITED == ticks) || (ticks > remaining))
+			ticks = remaining;
+		host_clock_skip_ticks(ticks);
+		if ((int32_t) (timer->expiry - task_tick_get_32()) > 0)
+			return NULL;
+	}
+	timer->running = false;
+	return timer->user_data;
+}
+
+void *nano_task_timer_test(struct nano_timer *timer, int32_t ticks) {
+	return nano_timer_test(timer,ticks);
+}
+
+/*
+ * atomics
+ *
+ */
+
+atomic_val_t atomic_add(atomic_t *target, atomic_val_t value) {
+	atomic_val_t old = *target;
+	*target += value;
+	return old;
+}
+
+atomic_val_t atomic_inc(atomic_t *target) {
+	return atomic_add(target,1);
+}
+
+atomic_val_t atomic_dec(atomic_t *target) {
+	return atomic_add(target,-1);
+}
+
+atomic_val_t atomic_get(const atomic_t *target) {
+	return *target;
+}
+
+atomic_val_t atomic_set(atomic_t *target, atomic_val_t value) {
+	atomic_val_t old = *target;
+	*target = value;
+	return old;
+}
+
+int atomic_cas(atomic_t *target, atomic_val_t old_value, atomic_val_t new_value) {
+	if (*target != old_value)
+		return 0;
+	*target = new_value;
+	return 1;
+}
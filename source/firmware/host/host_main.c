@@ -0,0 +1,294 @@
+/* host_main.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - Runs the firmware's main() (built as rocket_main, see Makefile) on the
+ *    host, against the stand-in kernel and devices
+ *  - The run ends when the virtual clock reaches the requested time, from
+ *    inside the firmware's frame wait, with a report of the simulated versus
+ *    the wall clock time, the firmware's own profile, and the device state
+ *  - A session can be recorded (-r) and replayed (-p, see rocket_record.c); a
+ *    replay needs no input recording, ends with its last frame, and exits
+ *    non-zero if its output diverged from the recorded session
+ *  - The kernel benchmarks (-b, see rocket_bench.c) run instead of the game,
+ *    on the real clock, and are compared with the previous results in the CSV
+ *    file before it is rewritten
+ */
+
+#include <zephyr.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rocket.h"
+#include "rocket_hist.h"
+#include "rocket_frame.h"
+#include "rocket_lcd.h"
+#include "rocket_profile.h"
+#include "rocket_record.h"
+#include "rocket_bench.h"
+#include "host.h"
+
+uint32_t host_run_ms = HOST_RUN_MS;
+bool host_verbose = false;
+bool host_realtime_clock = true;
+
+static struct timespec host_wall_start;
+static const char *host_record_file = NULL;
+
+void rocket_main();
+
+/*
+ * host_usage : command line help
+ *
+ */
+
+static void host_usage(const char *name) {
+	printf("usage: %s [-t seconds] [-i inputs.txt] [-r|-p session.rec] [-b bench.csv] [-d] [-v]\n",name);
+	printf("  -t seconds    simulated run time (default %d)\n",HOST_RUN_MS / 1000);
+	printf("  -i inputs.txt input recording: '<ms> <x> <y> <z> <button_a> <button_b>' per line\n");
+	printf("  -r session.rec record the session's inputs and output CRCs\n");
+	printf("  -p session.rec replay a recorded session and check its output\n");
+	printf("  -b bench.csv  benchmark the math and space kernels, compare with and rewrite the CSV\n");
+	printf("  -d            deterministic clock: only sleeps and waits advance it\n");
+	printf("  -v            print the LCD whenever it changes\n");
+}
+
+/*
+ * host_record_save : write the captured session
+ *
+ */
+
+bool host_record_save(const char *filename) {
+	FILE *fp = fopen(filename,"wb");
+	bool ok;
+
+	if (NULL == fp) {
+		printf("HOST: can not write '%s'\n",filename);
+		return false;
+	}
+	ok = (1 == fwrite(&r_record.header,sizeof(r_record.header),1,fp)) &&
+		 (r_record.header.runs == fwrite(r_record.run_buf,sizeof(struct RECORD_RUN_S),r_record.header.runs,fp)) &&
+		 (r_record.header.frame_crcs == fwrite(r_record.frame_crc,sizeof(uint32_t),r_record.header.frame_crcs,fp));
+	fclose(fp);
+	if (!ok)
+		printf("HOST: write error on '%s'\n",filename);
+	return ok;
+}
+
+/*
+ * host_record_load : read a session to replay
+ *
+ */
+
+bool host_record_load(const char *filename) {
+	FILE *fp = fopen(filename,"rb");
+	uint32_t runs = 0;
+	uint32_t frame_crcs = 0;
+
+	if (NULL == fp) {
+		printf("HOST: can not read '%s'\n",filename);
+		return false;
+	}
+	if ((1 == fread(&r_record.header,sizeof(r_record.header),1,fp)) &&
+		(r_record.header.runs <= RECORD_RUN_MAX) &&
+		(r_record.header.frame_crcs <= RECORD_FRAME_MAX)) {
+		runs = fread(r_record.run_buf,sizeof(struct RECORD_RUN_S),r_record.header.runs,fp);
+		frame_crcs = fread(r_record.frame_crc,sizeof(uint32_t),r_record.header.frame_crcs,fp);
+	}
+	fclose(fp);
+	if (!record_replay_start(runs,frame_crcs)) {
+		printf("HOST: '%s' is not a complete session recording\n",filename);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * host_bench : run the kernel benchmarks, compare with the previous results, save
+ *
+ *  Returns false if a kernel's check value changed, i.e. it now computes a
+ *  different answer; a slower kernel is only reported, as host timing is noisy
+ *
+ */
+
+static bool host_bench(const char *filename) {
+	char line[128],name[64];
+	uint32_t calls,ns_mean,ns_worst,check;
+	bool changed = false;
+	FILE *fp;
+	uint8_t i;
+
+	init_main();
+	bench_run();
+	bench_report();
+
+	// compare with the previous run
+	fp = fopen(filename,"r");
+	if (NULL != fp) {
+		printf("\nHOST: compared with the previous '%s'\n",filename);
+		while (NULL != fgets(line,sizeof(line),fp)) {
+			if (5 != sscanf(line,"%63[^,],%u,%u,%u,%x",name,&calls,&ns_mean,&ns_worst,&check))
+				continue;
+			for (i=0;i<BENCH_KERNEL_MAX;i++) {
+				if (strcmp(name,r_bench[i].name))
+					continue;
+				printf("HOST: %-30s %8d -> %8d ns%s%s\n",
+					name,ns_mean,r_bench[i].ns_mean,
+					(r_bench[i].ns_mean > (ns_mean + (ns_mean / HOST_BENCH_SLOWER_DIV))) ? "  SLOWER" : "",
+					(r_bench[i].check != check) ? "  CHANGED" : "");
+				if (r_bench[i].check != check)
+					changed = true;
+			}
+		}
+		fclose(fp);
+	}
+
+	fp = fopen(filename,"w");
+	if (NULL == fp) {
+		printf("HOST: can not write '%s'\n",filename);
+		return false;
+	}
+	fprintf(fp,"kernel,calls,ns_mean,ns_worst,check\n");
+	for (i=0;i<BENCH_KERNEL_MAX;i++) {
+		fprintf(fp,"%s,%u,%u,%u,%08x\n",
+			r_bench[i].name,
+			r_bench[i].calls,
+			r_bench[i].ns_mean,
+			r_bench[i].ns_worst,
+			r_bench[i].check);
+	}
+	fclose(fp);
+	return !changed;
+}
+
+/*
+ * host_exit : end of the simulated run
+ *
+ */
+
+void host_exit() {
+	struct timespec now;
+	uint64_t wall_us;
+	uint32_t sim_ms = host_clock_ms();
+
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	wall_us = ((uint64_t) (now.tv_sec - host_wall_start.tv_sec) * 1000000ULL) +
+			  (((int64_t) now.tv_nsec - (int64_t) host_wall_start.tv_nsec) / 1000);
+
+	printf("\nHOST: simulated %d ms in %d us of wall time (%d frames, %dx real time)\n",
+		sim_ms,
+		(uint32_t) wall_us,
+		r_frame_stats.frames,
+		wall_us ? (uint32_t) ((sim_ms * 1000ULL) / wall_us) : 0);
+	profile_dump();
+	host_devices_report();
+	lcd_fb_report();
+	record_report();
+
+	if ((RECORD_CAPTURE == r_record.mode) || (RECORD_FULL == r_record.mode)) {
+		if (RECORD_FULL == r_record.mode)
+			printf("HOST: the recording is full, saved up to frame %d\n",r_record.frame);
+		if (!host_record_save(host_record_file))
+			exit(1);
+		printf("HOST: recorded %d frames into '%s'\n",r_record.frame,host_record_file);
+	} else if ((RECORD_REPLAY == r_record.mode) || (RECORD_DONE == r_record.mode)) {
+		if (RECORD_DONE != r_record.mode) {
+			printf("HOST: REPLAY INCOMPLETE at frame %d of %d\n",r_record.frame,r_record.header.frames);
+			exit(1);
+		}
+		if ((0 < r_record.mismatches) || (r_record.crc != r_record.header.crc)) {
+			printf("HOST: REPLAY DIVERGED at frame %d%s\n",
+				r_record.mismatch_frame,
+				r_record.mismatch_run ? " (or earlier in its run)" : "");
+			exit(1);
+		}
+		printf("HOST: replay matched, %d frames\n",r_record.frame);
+	}
+	fflush(stdout);
+	exit(0);
+}
+
+/*
+ * main : run the firmware on the host
+ *
+ */
+
+int main(int argc, char **argv) {
+	const char *inputs = NULL;
+	const char *replay = NULL;
+	const char *bench = NULL;
+	bool run_time_set = false;
+	int i;
+
+	for (i=1;i<argc;i++) {
+		if (!strcmp(argv[i],"-t") && ((i+1) < argc)) {
+			host_run_ms = (uint32_t) atoi(argv[++i]) * 1000;
+			run_time_set = true;
+		} else if (!strcmp(argv[i],"-i") && ((i+1) < argc)) {
+			inputs = argv[++i];
+		} else if (!strcmp(argv[i],"-r") && ((i+1) < argc)) {
+			host_record_file = argv[++i];
+		} else if (!strcmp(argv[i],"-p") && ((i+1) < argc)) {
+			replay = argv[++i];
+		} else if (!strcmp(argv[i],"-b") && ((i+1) < argc)) {
+			bench = argv[++i];
+		} else if (!strcmp(argv[i],"-d")) {
+			host_realtime_clock = false;
+		} else if (!strcmp(argv[i],"-v")) {
+			host_verbose = true;
+		} else {
+			host_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC,&host_wall_start);
+	host_kernel_init();
+
+	// the benchmarks need the real clock, and no game
+	if (bench) {
+		host_realtime_clock = true;
+		return host_bench(bench) ? 0 : 1;
+	}
+	host_devices_init();
+	if (inputs && !host_inputs_load(inputs))
+		return 1;
+
+	// rocket_main() sets up r_game, the recording modes start from here
+	if (replay) {
+		if (!host_record_load(replay))
+			return 1;
+		// the replay ends with its last frame
+		if (!run_time_set)
+			host_run_ms = 0xffffffff;
+	} else if (host_record_file) {
+		record_capture_start();
+	}
+
+	rocket_main();
+
+	// the firmware only returns if its setup failed
+	return 1;
+}
@@ -0,0 +1,50 @@
+/* adc.h - Rocket Lander Game (host build) */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+#ifndef __HOST_ADC_H__
+#define __HOST_ADC_H__
+
+enum adc_callback_type {
+	ADC_CB_DONE = 0,
+	ADC_CB_ERROR
+};
+
+typedef void (*adc_callback_t)(struct device *dev, enum adc_callback_type cb_type);
+
+struct adc_seq_entry {
+	int32_t sampling_delay;
+	uint8_t *buffer;
+	uint32_t buffer_length;
+	uint8_t channel_id;
+};
+
+struct adc_seq_table {
+	struct adc_seq_entry *entries;
+	uint8_t num_entries;
+};
+
+/* the conversion completes at once, from the recorded inputs (see host_devices.c) */
+void adc_enable(struct device *dev);
+void adc_disable(struct device *dev);
+void adc_set_callback(struct device *dev, adc_callback_t callback);
+int adc_read(struct device *dev, struct adc_seq_table *seq_table);
+
+#endif /* __HOST_ADC_H__ */
@@ -0,0 +1,36 @@
+/* atomic.h - Rocket Lander Game (host build) */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+#ifndef __HOST_ATOMIC_H__
+#define __HOST_ATOMIC_H__
+
+typedef int atomic_t;
+typedef int atomic_val_t;
+
+/* one task, so the host atomics are plain operations (see host_kernel.c) */
+atomic_val_t atomic_add(atomic_t *target, atomic_val_t value);
+atomic_val_t atomic_inc(atomic_t *target);
+atomic_val_t atomic_dec(atomic_t *target);
+atomic_val_t atomic_get(const atomic_t *target);
+atomic_val_t atomic_set(atomic_t *target, atomic_val_t value);
+int atomic_cas(atomic_t *target, atomic_val_t old_value, atomic_val_t new_value);
+
+#endif /* __HOST_ATOMIC_H__ */
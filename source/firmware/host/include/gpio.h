@@ -0,0 +1,43 @@
+/* gpio.h - Rocket Lander Game (host build) */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+#ifndef __HOST_GPIO_H__
+#define __HOST_GPIO_H__
+
+#define GPIO_DIR_IN				(0 << 0)
+#define GPIO_DIR_OUT			(1 << 0)
+#define GPIO_INT				(1 << 1)
+#define GPIO_INT_ACTIVE_LOW		(0 << 2)
+#define GPIO_INT_ACTIVE_HIGH	(1 << 2)
+#define GPIO_INT_LEVEL			(0 << 5)
+#define GPIO_INT_EDGE			(1 << 5)
+#define GPIO_INT_DOUBLE_EDGE	(1 << 7)
+
+typedef void (*gpio_callback_t)(struct device *port, uint32_t pin);
+
+int gpio_pin_configure(struct device *port, uint32_t pin, int flags);
+int gpio_pin_read(struct device *port, uint32_t pin, uint32_t *value);
+int gpio_pin_write(struct device *port, uint32_t pin, uint32_t value);
+int gpio_set_callback(struct device *port, gpio_callback_t callback);
+int gpio_pin_enable_callback(struct device *port, uint32_t pin);
+int gpio_pin_disable_callback(struct device *port, uint32_t pin);
+
+#endif /* __HOST_GPIO_H__ */
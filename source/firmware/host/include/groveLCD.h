@@ -0,0 +1,39 @@
+/* groveLCD.h - Rocket Lander Game (host build) */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+#ifndef __HOST_GROVELCD_H__
+#define __HOST_GROVELCD_H__
+
+/* HD44780 commands */
+#define LCD_CLEAR			0x01
+#define LCD_RETURN_HOME		0x02
+
+/* the panel is the in-memory LCD (see host_devices.c) */
+void groveLcdInit(struct device *dev);
+void groveLcdCommand(struct device *dev, uint8_t command);
+void groveLcdClear(struct device *dev);
+void groveLcdColorSet(struct device *dev, uint8_t red, uint8_t green, uint8_t blue);
+void groveLcdCursorSet(struct device *dev, uint8_t col, uint8_t row);
+void groveLcdCursor(struct device *dev, uint8_t on);
+void groveLcdBlink(struct device *dev, uint8_t on);
+void groveLcdPrint(struct device *dev, uint8_t col, uint8_t row, char *text, int len);
+
+#endif /* __HOST_GROVELCD_H__ */
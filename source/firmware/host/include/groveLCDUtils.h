@@ -0,0 +1,29 @@
+/* groveLCDUtils.h - Rocket Lander Game (host build) */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+#ifndef __HOST_GROVELCDUTILS_H__
+#define __HOST_GROVELCDUTILS_H__
+
+/* Arduino numbered pins, from the recorded inputs (see host_devices.c) */
+int gpioInputGet(int pin);
+void gpioOutputSet(int pin, int value);
+
+#endif /* __HOST_GROVELCDUTILS_H__ */
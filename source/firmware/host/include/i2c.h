@@ -0,0 +1,31 @@
+/* i2c.h - Rocket Lander Game (host build) */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+#ifndef __HOST_I2C_H__
+#define __HOST_I2C_H__
+
+/* transactions are delivered to the slave simulators (see host_devices.c) */
+int i2c_write(struct device *dev, uint8_t *buf, uint32_t len, uint16_t addr);
+int i2c_read(struct device *dev, uint8_t *buf, uint32_t len, uint16_t addr);
+int i2c_polling_write(struct device *dev, uint8_t *buf, uint32_t len, uint16_t addr);
+int i2c_polling_read(struct device *dev, uint8_t *buf, uint32_t len, uint16_t addr);
+
+#endif /* __HOST_I2C_H__ */
@@ -0,0 +1,151 @@
+/* zephyr.h - Rocket Lander Game (host build) */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - Stand-in for the Zephyr 1.x microkernel API used by the firmware, so that
+ *    the firmware sources build unchanged for a Linux host (see ../Makefile)
+ *  - There is one task. The clock is virtual: it runs with the host's clock,
+ *    but sleeps and timer waits skip ahead instead of waiting, so the game
+ *    loop runs as fast as the host can compute it (see host_kernel.c)
+ *  - The mdef objects (tasks groups, events, mutexes, semaphores) are plain
+ *    numbers, as generated by sysgen for the target
+ */
+
+#ifndef __HOST_ZEPHYR_H__
+#define __HOST_ZEPHYR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <atomic.h>
+
+/* devices */
+struct device {
+	const char *name;
+};
+
+/* return codes */
+#define DEV_OK				0
+#define DEV_FAIL			1
+#define DEV_INVALID_OP		4
+#define DEV_NO_RESPONSE		6
+
+#define RC_OK				0
+#define RC_FAIL				1
+#define RC_TIME				2
+
+#define TICKS_UNLIMITED		(-1)
+#define TICKS_NONE			0
+
+/* execution context */
+#define NANO_CTX_ISR		0
+#define NANO_CTX_FIBER		1
+#define NANO_CTX_TASK		2
+
+#define __noinit
+
+/* mdef objects (see prj.mdef) */
+typedef int ktask_t;
+typedef int ktask_group_t;
+typedef int kevent_t;
+typedef int kmutex_t;
+typedef int ksem_t;
+
+extern const ktask_group_t EXE;
+extern const ktask_group_t PIPE;
+extern const kevent_t ADCREADY;
+extern const kmutex_t I2CBUS;
+extern const ksem_t FRAMEREADY;
+
+/* clock */
+extern int32_t sys_clock_ticks_per_sec;
+extern int sys_clock_hw_cycles_per_sec;
+
+uint32_t sys_cycle_get_32(void);
+uint32_t task_cycle_get_32(void);
+uint32_t task_tick_get_32(void);
+int64_t task_tick_get(void);
+
+/* tasks */
+void task_sleep(int32_t ticks);
+ktask_t task_id_get(void);
+void task_group_start(ktask_group_t group);
+int sys_execution_context_type_get(void);
+
+/* microkernel objects */
+int task_event_send(kevent_t event);
+void isr_event_send(kevent_t event);
+int task_event_recv(kevent_t event);
+int task_event_recv_wait(kevent_t event);
+int task_event_recv_wait_timeout(kevent_t event, int32_t ticks);
+
+int task_mutex_lock(kmutex_t mutex, int32_t ticks);
+void task_mutex_unlock(kmutex_t mutex);
+
+void task_sem_give(ksem_t sem);
+void isr_sem_give(ksem_t sem);
+int task_sem_take(ksem_t sem, int32_t ticks);
+
+/* interrupts */
+unsigned int irq_lock(void);
+void irq_unlock(unsigned int key);
+
+/* nanokernel FIFO: the first word of each item is the link */
+struct nano_fifo {
+	void *head;
+	void *tail;
+};
+
+void nano_fifo_init(struct nano_fifo *fifo);
+void nano_fifo_put(struct nano_fifo *fifo, void *data);
+void nano_task_fifo_put(struct nano_fifo *fifo, void *data);
+void nano_isr_fifo_put(struct nano_fifo *fifo, void *data);
+void *nano_fifo_get(struct nano_fifo *fifo, int32_t ticks);
+void *nano_task_fifo_get(struct nano_fifo *fifo, int32_t ticks);
+
+/* nanokernel semaphore */
+struct nano_sem {
+	uint32_t count;
+};
+
+void nano_sem_init(struct nano_sem *sem);
+void nano_task_sem_give(struct nano_sem *sem);
+void nano_fiber_sem_give(struct nano_sem *sem);
+void nano_isr_sem_give(struct nano_sem *sem);
+int nano_task_sem_take(struct nano_sem *sem, int32_t ticks);
+
+/* nanokernel timer */
+struct nano_timer {
+	void *user_data;
+	uint32_t expiry;		// tick at which the timer expires
+	bool running;
+};
+
+void nano_timer_init(struct nano_timer *timer, void *data);
+void nano_timer_start(struct nano_timer *timer, int ticks);
+void nano_task_timer_start(struct nano_timer *timer, int ticks);
+void nano_task_timer_stop(struct nano_timer *timer);
+void *nano_timer_test(struct nano_timer *timer, int32_t ticks);
+void *nano_task_timer_test(struct nano_timer *timer, int32_t ticks);
+
+#endif /* __HOST_ZEPHYR_H__ */
@@ -32,7 +32,7 @@
 #include <i2c.h>
 #include <stdint.h>
 
-#undef ENABLE_LED_FLOAT
+#include "rocket_segment.h"
 
 #ifndef _BV
   #define _BV(bit) (1<<(bit))
@@ -43,6 +43,13 @@ static uint16_t displaybuffer[8];
 static struct device * i2c;
 static uint8_t position = 0;
 
+// Shadow of the HT16K33 display RAM, so that bp_writeDisplay() only sends
+// the changed address range (the RAM content is unknown until first written)
+static uint8_t displayshadow[HT16K33_RAM_SIZE];
+static boolean displayshadow_valid = false;
+
+struct BP_STATS_S bp_stats;
+
 /* LED segment bit values:
      01
    20  02
@@ -106,6 +113,7 @@ void bp_begin() {
 
   // Wire.begin();
   position = 0;
+  bp_invalidate();
 
   // Wire.beginTransmission(i2c_addr);
   // Wire.write(0x21);  // turn on oscillator
@@ -117,9 +125,14 @@ void bp_begin() {
   bp_setBrightness(15); // max brightness
 }
 
+void bp_invalidate(void) {
+  displayshadow_valid = false;
+}
+
 void bp_writeDisplay(void) {
-  uint8_t buf[17] = {0};
-  uint8_t idx = 1;
+  uint8_t ram[HT16K33_RAM_SIZE];
+  uint8_t buf[HT16K33_RAM_SIZE+1];
+  uint8_t first,last,len;
   // Wire.beginTransmission(i2c_addr);
   // Wire.write((uint8_t)0x00); // start at address $00
   
@@ -128,14 +141,42 @@ void bp_writeDisplay(void) {
   //   Wire.write(displaybuffer[i] >> 8);    
   // Wire.endTransmission();
   
-  for (uint8_t i=0; i<=8; i++) {
-    buf[idx] = displaybuffer[i] & 0xFF;
-    idx++;
-    buf[idx] = displaybuffer[i] >> 8;
-    idx++;
+  for (uint8_t i=0; i<8; i++) {
+    ram[(i*2)  ] = displaybuffer[i] & 0xFF;
+    ram[(i*2)+1] = displaybuffer[i] >> 8;
   }
-  
-  i2c_polling_write(i2c, buf, sizeof (buf), i2c_addr);
+
+  bp_stats.updates++;
+  bp_stats.bytes_full += HT16K33_RAM_SIZE + 2;
+
+  // find the changed address range, all of it if the panel is unknown
+  first = 0;
+  last = HT16K33_RAM_SIZE - 1;
+  if (displayshadow_valid) {
+    while ((first < HT16K33_RAM_SIZE) && (ram[first] == displayshadow[first])) first++;
+    if (first == HT16K33_RAM_SIZE)
+      return;
+    while (ram[last] == displayshadow[last]) last--;
+  }
+
+  // one transaction: the starting RAM address, then the changed bytes
+  len = last - first + 1;
+  buf[0] = first;
+  for (uint8_t i=0; i<len; i++) {
+    buf[i+1] = ram[first+i];
+  }
+
+  if (0 == i2c_polling_write(i2c, buf, len + 1, i2c_addr)) {
+    for (uint8_t i=first; i<=last; i++) {
+      displayshadow[i] = ram[i];
+    }
+    displayshadow_valid = true;
+  } else {
+    displayshadow_valid = false;
+  }
+
+  bp_stats.writes++;
+  bp_stats.bytes_sent += len + 2;
 }
 
 void bp_clear(void) {
@@ -150,53 +191,19 @@ void bp_clear(void) {
 //   position = 0;
 // }
 
-#ifdef ENABLE_LED_FLOAT
-void seg_print(unsigned long n, int base)
-{
-  if (base == 0) seg_write(n);
-  else seg_printNumber(n, base);
-}
-
-
-void  seg_println(unsigned int n, int base)
-{
-  seg_print(n, base);
-  // seg_println();
-  position = 0;
-}
-
-static size_t seg_write(uint8_t c) {
-
-  uint8_t r = 0;
-
-  if (c == '\n') position = 0;
-  if (c == '\r') position = 0;
-
-  if ((c >= '0') && (c <= '9')) {
-    seg_writeDigitNum(position, c-'0', false);
-    r = 1;
-  }
-
-  position++;
-  if (position == 2) position++;
-
-  return r;
-}
-#endif
-
 static void seg_writeDigitRaw(uint8_t d, uint8_t bitmask) {
   if (d > 4) return;
   displaybuffer[d] = bitmask;
 }
 
-static void seg_drawColon(boolean state) {
+void seg_drawColon(boolean state) {
   if (state)
     displaybuffer[2] = 0x2;
   else
     displaybuffer[2] = 0;
 }
 
-static void seg_writeColon(void) {
+void seg_writeColon(void) {
 //     Wire.beginTransmission(i2c_addr);
 //     Wire.write((uint8_t)0x04); // start at address $02
     
@@ -217,93 +224,20 @@ void seg_writeDigitNum(uint8_t d, uint8_t num, boolean dot) {
   seg_writeDigitRaw(d, numbertable[num] | (dot << 7));
 }
 
-void seg_writeNumber(uint32_t n) {
-  uint32_t i,pos;
-  
-	for (i=4,pos=4;i>0;i--,pos--) {
-		if (2 == pos) pos--; // skip colon position
-		seg_writeDigitNum(pos, n % 10, false);
-		n /= 10;
-	}
-	bp_writeDisplay();
+// the four digits, left to right, around the colon position
+void seg_writeSegments(const uint8_t *segments) {
+  seg_writeDigitRaw(0, segments[0]);
+  seg_writeDigitRaw(1, segments[1]);
+  seg_writeDigitRaw(3, segments[2]);
+  seg_writeDigitRaw(4, segments[3]);
+  bp_writeDisplay();
 }
 
-#ifdef ENABLE_LED_FLOAT
-
-// void seg_print(long n, int base)
-// {
-//   seg_printNumber(n, base);
-// }
+// integer rendering without division loops or floating point (see rocket_segment.c)
+void seg_writeNumber(uint32_t n) {
+  uint8_t segments[SEGMENT_DIGITS];
 
-void seg_printNumber(long n, uint8_t base)
-{
-    seg_printFloat(n, 0, base);
+  segment_render((n > SEGMENT_VALUE_MAX) ? SEGMENT_VALUE_MAX : n, 0, SEGMENT_ZEROS, segments);
+  seg_writeSegments(segments);
 }
 
-void seg_printFloat(double n, uint8_t fracDigits, uint8_t base) 
-{ 
-  uint8_t numericDigits = 4;   // available digits on display
-  boolean isNegative = false;  // true if the number is negative
-  
-  // is the number negative?
-  if(n < 0) {
-    isNegative = true;  // need to draw sign later
-    --numericDigits;    // the sign will take up one digit
-    n *= -1;            // pretend the number is positive
-  }
-  
-  // calculate the factor required to shift all fractional digits
-  // into the integer part of the number
-  double toIntFactor = 1.0;
-  for(int i = 0; i < fracDigits; ++i) toIntFactor *= base;
-  
-  // create integer containing digits to display by applying
-  // shifting factor and rounding adjustment
-  uint32_t displayNumber = n * toIntFactor + 0.5;
-  
-  // calculate upper bound on displayNumber given
-  // available digits on display
-  uint32_t tooBig = 1;
-  for(int i = 0; i < numericDigits; ++i) tooBig *= base;
-  
-  // if displayNumber is too large, try fewer fractional digits
-  while(displayNumber >= tooBig) {
-    --fracDigits;
-    toIntFactor /= base;
-    displayNumber = n * toIntFactor + 0.5;
-  }
-  
-  // did toIntFactor shift the decimal off the display?
-  if (toIntFactor < 1) {
-    seg_printError();
-  } else {
-    // otherwise, display the number
-    int8_t displayPos = 4;
-    
-    if (displayNumber)  //if displayNumber is not 0
-    {
-      for(uint8_t i = 0; displayNumber || i <= fracDigits; ++i) {
-        boolean displayDecimal = (fracDigits != 0 && i == fracDigits);
-        seg_writeDigitNum(displayPos--, displayNumber % base, displayDecimal);
-        if(displayPos == 2) seg_writeDigitRaw(displayPos--, 0x00);
-        displayNumber /= base;
-      }
-    }
-    else {
-      seg_writeDigitNum(displayPos--, 0, false);
-    }
-  
-    // display negative sign if negative
-    if(isNegative) seg_writeDigitRaw(displayPos--, 0x40);
-  
-    // clear remaining display positions
-    while(displayPos >= 0) seg_writeDigitRaw(displayPos--, 0x00);
-  }
-}
-
-void seg_printError(void) {
-  for(uint8_t i = 0; i < SEVENSEG_DIGITS; ++i) {
-    seg_writeDigitRaw(i, (i == 2 ? 0x00 : 0x40));
-  }
-}
-#endif
@@ -63,6 +63,18 @@ typedef char boolean;
 
 #define SEVENSEG_DIGITS 5
 
+#define HT16K33_RAM_SIZE 16	// display RAM bytes, addresses 0x00..0x0F
+
+// Bus traffic of bp_writeDisplay() (bytes include the i2c address byte)
+struct BP_STATS_S {
+  uint32_t updates;     // bp_writeDisplay() calls
+  uint32_t writes;      // calls that needed a transaction
+  uint32_t bytes_sent;  // bus bytes sent
+  uint32_t bytes_full;  // bus bytes the full RAM image writes would have sent
+};
+
+extern struct BP_STATS_S bp_stats;
+
 
 // // this is the raw HT16K33 controller
 // class Adafruit_LEDBackpack {
@@ -125,6 +137,7 @@ typedef char boolean;
 void bp_begin (void);
 void bp_setdevice (zephyr_dev);
 void bp_writeDisplay (void);
+void bp_invalidate (void);
 void bp_clear (void);
 
 //void setup (zephyr_dev dev);
@@ -135,16 +148,11 @@ void bp_clear (void);
 void seg_writeDigitNum(uint8_t d, uint8_t num, boolean dot);
 
 void seg_writeNumber(uint32_t n);
-
-#ifdef ENABLE_LED_FLOAT
-void seg_print(unsigned long n, int base);
-void seg_println (unsigned int n, int base);
-void seg_printFloat(double n, uint8_t fracDigits, uint8_t base);
-void seg_printError(void);
-#endif
+void seg_writeSegments(const uint8_t *segments);
 
 //void seg_writeDigitRaw(uint8_t d, uint8_t bitmask);
-//void seg_drawColon(boolean state);
+void seg_drawColon(boolean state);
+void seg_writeColon(void);
 
 #endif // Adafruit_LEDBackpack_h
 
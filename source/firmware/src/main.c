@@ -38,7 +38,7 @@
  *
  * Main manages:
  *   - I/O bringup
- *   - Main loop (at 1/5 second)
+ *   - Main loop (at 1/5 second by default), as the physics task
  *   - Core I/O inputs (buttons and slider)
  *   - Rocket Display daughter board management
  *
@@ -59,6 +59,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdio.h>
 
 #include <gpio.h>
 #include <pwm.h>
@@ -68,6 +69,18 @@
 #include "rocket.h"
 #include "rocket_space.h"
 #include "rocket_state.h"
+#include "rocket_lcd.h"
+#include "rocket_log.h"
+#include "rocket_io.h"
+#include "rocket_adc.h"
+#include "rocket_button.h"
+#include "rocket_hist.h"
+#include "rocket_frame.h"
+#include "rocket_profile.h"
+#include "rocket_checkpoint.h"
+#include "rocket_math.h"
+#include "rocket_record.h"
+#include "rocket_segment.h"
 
 /*
  * Game Variables
@@ -86,15 +99,28 @@ bool self_test = false;
  */
 
 void log(char *message) {
+	uint32_t len;
+
 	if (verbose) {
-		PRINT(message);
+		// hand the text to the deferred logger, in pieces that fit an entry
+		for (len=strlen(message);len>0;) {
+			log_text_event(LOG_LEVEL_INF,LOG_F_TEXT,message);
+			if (len <= LOG_TEXT_MAX)
+				break;
+			message += LOG_TEXT_MAX;
+			len -= LOG_TEXT_MAX;
+		}
 	}
 }
 
 void log_val(char *format, void *val) {
-	char buffer[1000];
-	sprintf(buffer,format,val);
-	log(buffer);
+	char buffer[LOG_VAL_MAX];
+
+	if (verbose) {
+		// format here, but print from the deferred logger (as for log())
+		snprintf(buffer,sizeof(buffer),format,val);
+		log(buffer);
+	}
 }
 
 int32_t abs(int32_t val) {
@@ -104,32 +130,6 @@ int32_t abs(int32_t val) {
 		return -val;
 }
 
-/*
- * Checkpoint support: capture check points as the code executes, latest and previous
- *
- *  This provides a passive context when the code gets lost, especially if the
- *  OS is in an idle state and there is no stack trace available back
- *  into the code.
- *
- *  The checkpoint value is in decimal (the native format of the debugger), where
- *  the 6 digits are:   xxxxxx
- *                          ^^= the sub-checkpoints in a given sub-routine
- *                        ^^  = the sub-routine
- *                      ^^    = the file
- */
-
- /* checkpoints to help track where code code got lost without a thread to pause */
-void checkpoint_v(int32_t check_num, int32_t check_value) {
-	r_game.check_point_prev = r_game.check_point_now;
-	r_game.check_point_now  = check_num;
-	r_game.check_point_value = check_value;
-}
-
-void checkpoint(int32_t check_num) {
-	checkpoint_v(check_num,0);
-}
-
-
 /*
  * Hardware definitions
  *
@@ -143,43 +143,6 @@ struct device *i2c;
 #define LCD_MESSAGE2 "    Hello!      "
 
 
-/* ADC Definitions */
-
-/* Buffer holds ADC conversion result for A0 .. A2 */
-static uint16_t seq_buffer[ADC_MAX] = { 0 , 0 , 0};
-struct adc_seq_entry sample[] = {
-    {
-        .sampling_delay = 1,
-        .channel_id     = JOYSTICK_X_PORT,
-        .buffer         = (uint8_t*) &seq_buffer[0],
-        .buffer_length  = 1,
-    },
-    {
-        .sampling_delay = 1,
-        .channel_id     = JOYSTICK_Y_PORT,
-        .buffer         = (uint8_t*) &seq_buffer[1],
-        .buffer_length  = 1,
-    },
-	{
-        .sampling_delay = 1,
-        .channel_id     = JOYSTICK_Z_PORT,
-        .buffer         = (uint8_t*) &seq_buffer[2],
-        .buffer_length  = 1,
-    },
-};
-
-struct adc_seq_table table =
-{
-    .entries     = sample,
-    .num_entries = 3,
-};
-
-void adcCallback
-    (
-    struct device *dev,
-    enum adc_callback_type cb_type
-    );
-
 /*
  * init_hardware
  *
@@ -188,18 +151,21 @@ void adcCallback
 void init_hardware() {
 
 	/* Init the I/O pins */
+	button_init();
 	if (IO_JOYSTICK_ENABLE) {
-		adc_set_callback(adc, adcCallback);
+		adc_init();
 	}
 
 	/* Init the LCD RGB */
+	lcd_fb_init();
 	if (IO_LCD_ENABLE) {
 		groveLcdInit(i2c);
 
 		groveLcdCommand(i2c, LCD_CLEAR);
 		groveLcdColorSet(i2c, 0, 100, 200);
-		groveLcdPrint(i2c, 0, 0, LCD_MESSAGE1, strlen(LCD_MESSAGE1));
-		groveLcdPrint(i2c, 1, 0, "                   ",19);
+		lcd_fb_line(0, LCD_MESSAGE1);
+		lcd_fb_line(1, "");
+		lcd_fb_flush();
 	}
 
 	/* Init the X-Y-Z table */
@@ -229,61 +195,39 @@ void init_hardware() {
  }
 
 /*
- * scan_controls : read the control inputs
+ * scan_controls : read the control inputs into the given control record
  *
  */
 
-void scan_controls () {
-    int32_t rc;
-
+void scan_controls (struct ROCKET_CONTROL_S *control) {
 	checkpoint(200);
 
 	if (IO_BUTTONS_ENABLE) {
-		r_control.button_a = gpioInputGet(INPUT_A_PIN);
+		// the edges are queued for state_loop(), these are the debounced levels
+		button_scan();
 		checkpoint(201);
-		r_control.button_b = gpioInputGet(INPUT_B_PIN);
+		control->button_a = button_level(BUTTON_A);
+		control->button_b = button_level(BUTTON_B);
 	}
 	checkpoint(202);
 
 	if (IO_JOYSTICK_ENABLE) {
-        rc = adc_read(adc, &table);
-		checkpoint(203);
-        if (DEV_OK != rc)
-            {
-            PRINT("ERROR: ADC read error! (%d)\n", rc);
-            }
-        else
-            {
-            /* PRINT("ADCREADY...); */
-            task_event_recv_wait(ADCREADY);
-            /* PRINT("DONE\n); */
-			if (DEBUG_TIMING_ENABLE) {
-				// TODO #################### How much time is spent waiting?
-            }
-        }
+		// the filtered values from the background sampling (see rocket_adc.c)
+		adc_snapshot(&control->analog_x, &control->analog_y, &control->analog_z);
 		checkpoint(204);
-        r_control.analog_x = seq_buffer[0];
-        r_control.analog_y = seq_buffer[1];
-        r_control.analog_z = seq_buffer[2];
 
 		if (IO_ADAFRUIT_JOYSTICK_ENABLE) {
 			// map toggle resister array to equivalent reostat values
 			// Center values (no closed switches) are pulled to ground
-			if      (r_control.analog_x<                100) r_control.analog_x = JOYSTICK_X_MID;
-			else if (JOYSTICK_HIGH_MIN < r_control.analog_x) r_control.analog_x = JOYSTICK_X_MID + JOYSTICK_DELTA_XY_MIN + 40;
-			else if (JOYSTICK_LOW_MIN  > r_control.analog_x) r_control.analog_x = JOYSTICK_X_MID - JOYSTICK_DELTA_XY_MIN - 40;
-			else                                             r_control.analog_x = JOYSTICK_X_MID;
-			if      (r_control.analog_y<                100) r_control.analog_y = JOYSTICK_Y_MID;
-			else if (JOYSTICK_HIGH_MIN < r_control.analog_y) r_control.analog_y = JOYSTICK_Y_MID + JOYSTICK_DELTA_XY_MIN + 40;
-			else if (JOYSTICK_LOW_MIN  > r_control.analog_y) r_control.analog_y = JOYSTICK_Y_MID - JOYSTICK_DELTA_XY_MIN - 40;
-			else                                             r_control.analog_y = JOYSTICK_Y_MID;
-		}
-
-		/* is slider 'upside down' ? */
-		if (JOYSTICK_Z_INVERT) {
-			r_control.analog_z = 1023 - r_control.analog_z;
+			if      (control->analog_x<                100) control->analog_x = JOYSTICK_X_MID;
+			else if (JOYSTICK_HIGH_MIN < control->analog_x) control->analog_x = JOYSTICK_X_MID + JOYSTICK_DELTA_XY_MIN + 40;
+			else if (JOYSTICK_LOW_MIN  > control->analog_x) control->analog_x = JOYSTICK_X_MID - JOYSTICK_DELTA_XY_MIN - 40;
+			else                                             control->analog_x = JOYSTICK_X_MID;
+			if      (control->analog_y<                100) control->analog_y = JOYSTICK_Y_MID;
+			else if (JOYSTICK_HIGH_MIN < control->analog_y) control->analog_y = JOYSTICK_Y_MID + JOYSTICK_DELTA_XY_MIN + 40;
+			else if (JOYSTICK_LOW_MIN  > control->analog_y) control->analog_y = JOYSTICK_Y_MID - JOYSTICK_DELTA_XY_MIN - 40;
+			else                                             control->analog_y = JOYSTICK_Y_MID;
 		}
-
  	}
 	checkpoint(205);
 }
@@ -294,11 +238,25 @@ void scan_controls () {
  */
 
 void send_LED_Backpack(uint32_t x) {
+	uint32_t prof_cycles = prof_start();
+
 	checkpoint(401);
 	if (IO_LED_BACKPACK_ENABLE) {
-		seg_writeNumber(x);
+		io_out_value(IO_OUT_BACKPACK,x);
 	}
 	checkpoint(402);
+	prof_stop(PROF_BACKPACK,prof_cycles);
+}
+
+static void report_LED_Backpack() {
+	if (0 == bp_stats.updates)
+		return;
+
+	PRINT("*** Backpack(%d updates, %d sent): bytes/update = %d (full refresh = %d)\n",
+		bp_stats.updates,
+		bp_stats.writes,
+		bp_stats.bytes_sent / bp_stats.updates,
+		bp_stats.bytes_full / bp_stats.updates);
 }
 
 
@@ -308,45 +266,40 @@ void send_LED_Backpack(uint32_t x) {
  */
 
 void send_rocket_display(uint8_t *buffer,uint8_t i2c_len) {
+	uint32_t prof_cycles = prof_start();
+
 	if (IO_REMOTE_ENABLE) {
-		i2c_polling_write (i2c, buffer, i2c_len, ROCKET_DISPLAY_I2C_ADDRESS);
+		io_out_i2c(ROCKET_DISPLAY_I2C_ADDRESS, buffer, i2c_len, IO_PRIO_DISPLAY, NULL);
 	}
+	prof_stop(PROF_DISPLAY,prof_cycles);
 }
 
+// the display board's TM1637 LEDs take the rendered segments (see rocket_segment.c)
 void send_Led1(uint32_t value) {
-	static uint32_t value_prev = 9999;
-
+	static uint32_t value_prev = 99999;
 	uint8_t buf[10];
-	uint32_t i;
 
 	if (value_prev == value) return;
 	value_prev = value;
 
 	if (IO_LEDS_REMOTE_ENABLE) {
 		buf[0]='1';
-		for (i=4;i>0;i--) {
-			buf[i]=value % 10;
-			value /= 10;
-		}
-		send_rocket_display(buf,5);
+		segment_render((value > SEGMENT_VALUE_MAX) ? SEGMENT_VALUE_MAX : value, 0, SEGMENT_ZEROS, &buf[1]);
+		send_rocket_display(buf,1+SEGMENT_DIGITS);
 	}
 }
 
 void send_Led2(uint32_t value) {
-	static uint32_t value_prev = 9999;
+	static uint32_t value_prev = 99999;
 	uint8_t buf[10];
-	uint32_t i;
 
 	if (value_prev == value) return;
 	value_prev = value;
 
 	if (IO_LEDS_REMOTE_ENABLE) {
 		buf[0]='2';
-		for (i=4;i>0;i--) {
-			buf[i]=value % 10;
-			value /= 10;
-		}
-		send_rocket_display(buf,5);
+		segment_render((value > SEGMENT_VALUE_MAX) ? SEGMENT_VALUE_MAX : value, 0, SEGMENT_ZEROS, &buf[1]);
+		send_rocket_display(buf,1+SEGMENT_DIGITS);
 	}
 }
 
@@ -392,7 +345,7 @@ void send_Sound(uint32_t value) {
 	value_prev = value;
 
 	if (IO_SOUND_REMOTE_ENABLE) {
-		PRINT("** Sound: %d ***",value);
+		RLOG_INF(LOG_F_SOUND,value);
 		buf[0]='s';
 		buf[1]=(uint8_t) value;
 		send_rocket_display(buf,2);
@@ -400,23 +353,42 @@ void send_Sound(uint32_t value) {
 }
 
 // pan and tilt: 0 .. 255
+//   called by the physics task and by the output task's antenna update,
+//   so the previous values are only tested and set under a lock
 void send_Pan_Tilt(uint32_t pan,uint32_t tilt) {
 	static uint32_t pan_prev = 9999;
 	static uint32_t tilt_prev = 9999;
 
-	if ((pan_prev == pan) && (tilt_prev == tilt)) return;
-	pan_prev = pan;
-	tilt_prev = tilt;
-
 	if (IO_TRACKER_LOCAL_ENABLE) {
 		uint32_t percent;
+		uint32_t prof_cycles = prof_start();
+		// the Galileo2 PWM controller is on the i2c bus (if busy, retry with the next update)
+		if (!io_bus_trylock())
+			return;
+		if ((pan_prev == pan) && (tilt_prev == tilt)) {
+			io_bus_unlock();
+			return;
+		}
+		pan_prev = pan;
+		tilt_prev = tilt;
         percent = (100 * pan)/256;
         pwm_pin_set_duty_cycle(pwm, PWM_PAN_PWM, percent);
         percent = (100 * tilt)/256;
         pwm_pin_set_duty_cycle(pwm, PWM_TILT_PWM, percent);
+		io_bus_unlock();
+		prof_stop(PROF_PAN_TILT,prof_cycles);
 	} else if (IO_TRACKER_REMOTE_ENABLE) {
 		uint8_t buf[10];
+		unsigned int key;
 
+		key = irq_lock();
+		if ((pan_prev == pan) && (tilt_prev == tilt)) {
+			irq_unlock(key);
+			return;
+		}
+		pan_prev = pan;
+		tilt_prev = tilt;
+		irq_unlock(key);
 		buf[0]='p';
 		buf[1]=(uint8_t) pan;
 		buf[2]=(uint8_t) tilt;
@@ -516,12 +488,12 @@ void init_main() {
     r_game.fuel_option = GAME_FUEL_NOLIMIT /*GAME_FUEL_NORMAL*/;
     r_game.gravity_option = GAME_GRAVITY_NONE /* GAME_GRAVITY_NORMAL */;
     r_game.start_option = GAME_START_RANDOM /* GAME_START_CENTER */;
+    r_game.frame_ms = SLEEPTIME;
+    r_game.frame_dt_ms = SLEEPTIME;
 
 	// set initial game controls
 	r_control.button_a=0;
 	r_control.button_b=0;
-	r_control.button_a_prev=false;
-    r_control.button_b_prev=false;
 
 	r_control.analog_x=JOYSTICK_X_MID;
 	r_control.analog_y=JOYSTICK_Y_MID;
@@ -534,42 +506,53 @@ void init_main() {
  *
  */
 
- void main_time_test(uint32_t time_start,uint32_t time_stop,uint32_t time_cycle_start,uint32_t time_cycle_stop) {
-	static uint32_t time_sum = 0L;
-	static uint32_t time_cnt = 0L;
-	static uint32_t time_cycle_sum = 0L;
-	static uint32_t time_cycle_cnt = 0L;
-	static uint32_t time_max3 = 0L;
-	static uint32_t time_max2 = 0L;
-	static uint32_t time_max1 = 0L;
+ void main_time_test(uint32_t time_cycle_start,uint32_t time_cycle_stop) {
+	static uint32_t frame_cycle_sum = 0L;
+	static uint32_t frame_cycle_max = 0L;
+	static uint32_t frame_cnt = 0L;
+	static uint32_t report_cnt = 0L;
+	static int32_t frame_ms = 0L;
 
-	uint32_t time_diff = 0;
+	uint32_t frame_cycles;
 
-	if (DEBUG_TIMING_ENABLE) {
-		time_cnt++;
-		if (time_cnt > 0) {
-			time_diff = time_stop - time_start;
-			time_sum += time_diff;
-			if (time_cycle_stop > time_cycle_start) {
-				time_cycle_cnt++;
-				time_cycle_sum += time_cycle_stop - time_cycle_start;
-			}
-
-			if (time_diff > time_max3) {
-			    time_max1 = time_max2;
-			    time_max2 = time_max3;
-			    time_max3 = time_diff;
-			} else if (time_diff > time_max2) {
-			    time_max1 = time_max2;
-			    time_max2 = time_diff;
-			} else if (time_diff > time_max1) {
-			    time_max1 = time_diff;
-			}
+	// the per-phase profile is always on (it is cheap), the reports are not
+	prof_stop(PROF_FRAME,time_cycle_start);
 
-			// display time ave every 64 * 1/5 second ~= 13 seconds
-			if (0x0000 == (time_cnt & 0x003f)) {
-				//PRINT("*** Main_Time(%ld) = %ld:%ld / %ld, %ld < %ld < %ld\n",time_cnt,time_sum/time_cnt,time_cycle_sum/time_cycle_cnt,sys_clock_ticks_per_sec,time_max3,time_max2,time_max1);
+	if (DEBUG_TIMING_ENABLE) {
+		// restart the headroom window when the frame rate changes
+		if (frame_ms != r_game.frame_ms) {
+			frame_ms = r_game.frame_ms;
+			frame_cycle_sum = 0L;
+			frame_cycle_max = 0L;
+			frame_cnt = 0L;
+		}
+		frame_cnt++;
+		frame_cycle_sum += time_cycle_stop - time_cycle_start;
+		if ((time_cycle_stop - time_cycle_start) > frame_cycle_max)
+			frame_cycle_max = time_cycle_stop - time_cycle_start;
+
+		// display the reports every 64 frames (~= 13 seconds at 5 Hz)
+		if (0x0000 == (++report_cnt & 0x003f)) {
+			lcd_fb_report();
+			report_LED_Backpack();
+			io_report();
+			adc_report();
+			button_report();
+			frame_report();
+			record_report();
+
+			// report the per-frame CPU use at the current frame rate
+			frame_cycles = (sys_clock_hw_cycles_per_sec / 1000) * frame_ms;
+			if ((0 < frame_cnt) && (0 < frame_cycles)) {
+				PRINT("*** Frame(%d Hz,%d ms): busy ave=%d%% max=%d%%, headroom=%d%%\n",
+					FRAMES_PER_SECOND,frame_ms,
+					(frame_cycle_sum / frame_cnt) / (frame_cycles / 100),
+					frame_cycle_max / (frame_cycles / 100),
+					100 - (frame_cycle_max / (frame_cycles / 100)));
 			}
+			frame_cycle_sum = 0L;
+			frame_cycle_max = 0L;
+			frame_cnt = 0L;
 		}
 	}
 }
@@ -577,9 +560,10 @@ void init_main() {
 
 void main() {
     bool flag = false;
-   	uint32_t time_start,time_stop;
-	uint32_t time_cycle_start,time_cycle_stop;
+	uint32_t time_cycle_start,time_cycle_stop,prof_cycles;
+	uint32_t periods;
 
+	checkpoint_init();
 	checkpoint(101);
 
 	init_main();
@@ -597,6 +581,12 @@ void main() {
 
 	checkpoint(102);
 
+	// Seed the game's random numbers, from the recording when replaying
+	if (DEBUG_RECORD_ENABLE) {
+		record_capture_start();
+	}
+	rocket_rand_seed(record_seed(task_cycle_get_32()));
+
 	// Start the initial state
 	if (IO_BUTTON_BRINGUP) {
 		goto_state("S_Init");
@@ -604,66 +594,81 @@ void main() {
 		goto_state("S_Start");
 	}
 
+	// Start the input and output tasks, the input task now paces the frames
+	profile_reset();
+	frame_sched_init();
+	io_init();
+	io_start();
+
     while (1)
         {
 		checkpoint(110);
 
+		if (IO_TASKS_ENABLE) {
+			/* wait for the input task to release the next frame */
+			periods = io_frame_wait();
+			checkpoint(117);
+		} else {
+			/* wait for the next frame deadline */
+			periods = frame_sched_wait();
+			checkpoint(114);
+		}
+
 		/* get the time at start of loop */
-	   	time_start = task_tick_get_32();
 	   	time_cycle_start = task_cycle_get_32();
 
-        /* Blink the on-board LED */
-        if (flag)
-            {
-            gpioOutputSet(GREEN_LED, 1);
-            flag = false;
-            }
-        else
-            {
-            gpioOutputSet(GREEN_LED, 0);
-            flag = true;
-            }
+        /* Blink the on-board LED (skipped if the bus is busy) */
+		if (io_bus_trylock()) {
+	        if (flag)
+	            {
+	            gpioOutputSet(GREEN_LED, 1);
+	            flag = false;
+	            }
+	        else
+	            {
+	            gpioOutputSet(GREEN_LED, 0);
+	            flag = true;
+	            }
+			io_bus_unlock();
+		}
 		checkpoint(111);
 
 		/* fetch the control states */
-		scan_controls();
+		prof_cycles = prof_start();
+		if (IO_TASKS_ENABLE) {
+			io_control_fetch(&r_control);
+		} else {
+			scan_controls(&r_control);
+		}
+		r_control.button_event = button_event(state_button_hold());
+		prof_stop(PROF_SCAN,prof_cycles);
 		checkpoint(112);
 
+		/* capture or replay this frame's inputs and time step */
+		periods = record_frame(periods);
+		frame_physics_step(periods);
+
 		/* Process Buttons (default mode is toggle) */
+		prof_cycles = prof_start();
 		state_loop();
+		prof_stop(PROF_STATE,prof_cycles);
+		record_frame_end();
 		checkpoint(113);
 
-        /* wait a while to loop again, less the time spent in loop */
-	   	time_stop = task_tick_get_32();
+		/* send the frame's LCD changes */
+		prof_cycles = prof_start();
+		lcd_fb_flush();
+		prof_stop(PROF_LCD,prof_cycles);
+		checkpoint(116);
+
+		/* hand the frame's rocket position to the output task */
+		if (IO_TASKS_ENABLE) {
+			io_space_publish(&r_space);
+		}
+		checkpoint(118);
+
 	   	time_cycle_stop = task_cycle_get_32();
-		main_time_test(time_start,time_stop,time_cycle_start,time_cycle_stop);
-	   	if (time_stop < time_start) {
-	   		/* time counter looped, use default delay */
-	        task_sleep(SLEEPTICKS - 1);
-	   	} else if (SLEEPTICKS <= (time_stop - time_start)) {
-	        /* no sleep for the busy */
-	   	} else {
-			checkpoint_v(114,time_stop - time_start);
-	   		/* sleep the balance, rounding down one tick */
-	        task_sleep(SLEEPTICKS - (time_stop - time_start));
-        }
+		main_time_test(time_cycle_start,time_cycle_stop);
 		checkpoint(115);
     }
 }
-
-/*
- * @brief Callback, which is invoked when ADC gets new data
- *
- * @param dev ADC device structure
- * @param cb_type can be ADC_CB_DONE or ADC_CB_ERROR
- */
-void adcCallback (struct device *dev, enum adc_callback_type cb_type) {
-	checkpoint(301);
-    if (dev == adc && cb_type == ADC_CB_DONE)
-        {
-		checkpoint(302);
-        isr_event_send(ADCREADY);
-		checkpoint(303);
-		}
-	checkpoint(304);
-}
@@ -45,9 +45,27 @@ typedef char boolean;
 #define IO_TRACKER_REMOTE_ENABLE	false	// enable the remote Pan&Tilt 'antenae' device
 #define IO_LEDRGB_REMOTE_ENABLE		false	// enable the remote LED_RGB 'antenae status' device
 
+#define IO_TASKS_ENABLE				true	// run input, physics, and output as separate tasks (see rocket_io.c)
+#define IO_I2C_INTERRUPT_ENABLE		true	// the output task uses the interrupt driven i2c transfers (else polling)
+
 // Debugging
 #define DEBUG_TIMING_ENABLE			false	// enable the timing measurements for QOS
+#define DEBUG_PROFILE_ENABLE		true	// enable the per-phase frame profiler (see rocket_profile.c)
+#define DEBUG_CHECKPOINT_RING_ENABLE true	// record the recent checkpoints in a flight recorder ring (see rocket_checkpoint.c)
+#define DEBUG_RECORD_ENABLE			false	// capture the game session inputs into RAM, for replay on the host (see rocket_record.c)
 #define DEBUG_GAME_AT_START			false	// for game play testing, assume rocket already at start position
+#define DEBUG_TRACE_ENABLE			true	// enable the state machine transition and callback timing tracer
+#define DEBUG_LOG_DEFERRED			true	// log entries are formatted and printed by the low priority LOGGER task
+#define DEBUG_LOG_LEVEL				2		// compile-time log filter: 0=none, 1=errors, 2=info, 3=debug
+
+// Host build (see ../host): the firmware runs as one task on a virtual clock,
+// so the frame pipeline and the logger run inline in the main loop
+#ifdef ROCKET_HOST
+#undef  IO_TASKS_ENABLE
+#define IO_TASKS_ENABLE				false
+#undef  DEBUG_LOG_DEFERRED
+#define DEBUG_LOG_DEFERRED			false
+#endif
 
 // Specific installed joystick hardware
 #define IO_GROVE_JOYSTICK_ENABLE 	false	// enable the Grove thumb-joystick on the A0/A1 port
@@ -55,12 +73,18 @@ typedef char boolean;
 
 // Time Controls
 
-/* specify main loop delay (in ms); compute equivalent in ticks */
-/* Assume loop of 1/5 seconds */
+/* specify the default main loop period (in ms), the build-time frame rate */
+/* The period is selectable at run time (Options > Rate) via r_game.frame_ms, */
+/* and must divide one second evenly: 200=5Hz, 40=25Hz, 20=50Hz, 10=100Hz    */
+#ifndef SLEEPTIME
 #define SLEEPTIME  200
-#define SLEEPTICKS (SLEEPTIME * sys_clock_ticks_per_sec / 1000)
-#define TIME_LOOPS_PER_SECOND	5
-#define FRAMES_PER_SECOND		5
+#endif
+#define FRAME_MS_MIN	10		// shortest supported frame period (mSec)
+#define FRAME_MS_MAX	200		// longest supported frame period (mSec)
+
+/* compute the current frame period in ticks, and the current frame rate */
+#define SLEEPTICKS (r_game.frame_ms * sys_clock_ticks_per_sec / 1000)
+#define FRAMES_PER_SECOND		(1000 / r_game.frame_ms)
 
 /* Specific loop count timeouts per action */
 #define XYZ_CONTROL_COUNT		1
@@ -72,6 +96,11 @@ typedef char boolean;
 #define ROCKET_DISPLAY_I2C_ADDRESS 18
 #define ROCKET_MOTOR_I2C_ADDRESS   19
 
+// Local i2c devices
+
+#define LED_BACKPACK_I2C_ADDRESS   0x70
+#define GROVE_RGB_I2C_ADDRESS      0x62
+
 // Game Options
 
 #define GAME_Z_LAND			1
@@ -198,21 +227,23 @@ struct ROCKET_GAME_S {
 	int32_t	check_point_now;	// runtime checkpointd
 	int32_t	check_point_prev;	// runtime checkpoint previous
 	int32_t	check_point_value;	// runtime checkpoint value snapshot
+	int32_t	frame_ms;			// selected main loop period, in mSec
+	int32_t	frame_dt_ms;		// this frame's physics time step, in mSec (see rocket_frame.c)
+	uint32_t game_time_ms;		// sum of the physics time steps, the clock for the game timers
 };
 
 struct ROCKET_CONTROL_S {
 	int32_t	button_a;		// button inputs
 	int32_t	button_b;
 
-	bool button_a_prev;		// Previous value for toggle detection
-    bool button_b_prev;
-
 	int32_t	analog_x;		// analog inputs
 	int32_t	analog_y;
 	int32_t	analog_z;
 
-	uint8_t	lcd_line0[20];	// LCD display
-	uint8_t	lcd_line1[20];
+	int32_t	button_event;	// this frame's decided button event (BUTTON_EVENT_*)
+
+	char	lcd_line0[20];	// LCD display
+	char	lcd_line1[20];
 
 };
 
@@ -251,4 +282,5 @@ void send_high_score(char *msg);
 
 void init_game();
 void init_main();
+void scan_controls(struct ROCKET_CONTROL_S *control);
 
@@ -0,0 +1,339 @@
+/* rocket_adc.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Theory of Implementation
+ *  - The ADC task (see prj.mdef) converts the joystick and slider channels
+ *    continuously in the background, instead of scan_controls() starting a
+ *    conversion and waiting for it
+ *  - Conversions start at absolute deadlines, ADC_SAMPLE_TICKS apart (not after
+ *    the previous wakeup), waited for with a nanokernel timer as the frames
+ *    are (see rocket_frame.c), so the filtering does not stretch the period. A
+ *    deadline that has already passed is an overrun, and restarts the grid
+ *  - Each conversion takes ADC_OVERSAMPLE samples of every channel, which are
+ *    averaged before the filter
+ *  - There are two sample tables. The next conversion is started into one table
+ *    as soon as the other completes, and adcCallback() (the ISR) records which
+ *    table completed, so the task filters stable values while the ADC runs
+ *  - An upside down channel (e.g. JOYSTICK_Z_INVERT) is inverted as it is
+ *    sampled, so the filter and the dead zone work in the game's direction
+ *  - Each channel is filtered by a median of the last three samples, which
+ *    removes single-sample spikes, followed by an IIR low pass for the analog
+ *    channels (the toggle joystick's resistor steps are only median filtered)
+ *  - Analog channels with a center dead zone use hysteresis at the zone's edge,
+ *    so the noise of a slider resting at the edge does not switch the thrust
+ *    on and off from frame to frame
+ *  - The filtered values are published as a double buffered snapshot, which
+ *    scan_controls() copies without waiting
+ *  - Until the task runs (or when IO_TASKS_ENABLE is false) adc_snapshot()
+ *    performs one conversion and waits for it, as before
+ */
+
+#include <zephyr.h>
+
+#include <adc.h>
+#include "galileo2ADCPWM.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_adc.h"
+
+
+struct ROCKET_ADC_STATS_S r_adc_stats;
+
+/* ISR to task: double buffered conversions */
+static uint16_t seq_buffer[2][ADC_MAX][ADC_OVERSAMPLE];
+static struct adc_seq_entry sample[2][ADC_MAX];
+static struct adc_seq_table table[2];
+static volatile uint8_t adc_filling = 0;
+static volatile uint8_t adc_done = 0;
+
+/* task to scan_controls: double buffered filtered values */
+static struct ROCKET_ADC_CHANNEL_S adc_channel[ADC_MAX];
+static int32_t adc_value[2][ADC_MAX];
+static volatile uint8_t adc_value_front = 0;
+static volatile bool adc_running = false;
+
+/* sampling deadlines */
+static struct nano_timer adc_timer;
+static void *adc_timer_data[1];
+static uint32_t adc_deadline;
+
+/*
+ * @brief Callback, which is invoked when ADC gets new data
+ *
+ * @param dev ADC device structure
+ * @param cb_type can be ADC_CB_DONE or ADC_CB_ERROR
+ */
+static void adcCallback (struct device *dev, enum adc_callback_type cb_type) {
+	checkpoint(301);
+    if (dev == adc && cb_type == ADC_CB_DONE)
+        {
+		checkpoint(302);
+		adc_done = adc_filling;
+        isr_event_send(ADCREADY);
+		checkpoint(303);
+		}
+	checkpoint(304);
+}
+
+/*
+ * adc_channel_init : set a channel's filter and dead zone
+ *
+ */
+
+static void adc_channel_init(uint8_t i, uint8_t port, uint8_t iir_shift, int32_t dead_mid, int32_t dead_delta, bool invert) {
+	uint8_t b;
+
+	for (b=0;b<2;b++) {
+		sample[b][i].sampling_delay = 1;
+		sample[b][i].channel_id     = port;
+		sample[b][i].buffer         = (uint8_t*) seq_buffer[b][i];
+		sample[b][i].buffer_length  = sizeof(seq_buffer[b][i]);
+	}
+
+	memset(&adc_channel[i],0,sizeof(struct ROCKET_ADC_CHANNEL_S));
+	adc_channel[i].iir_shift  = iir_shift;
+	adc_channel[i].dead_mid   = dead_mid;
+	adc_channel[i].dead_delta = dead_delta;
+	adc_channel[i].invert     = invert;
+}
+
+/*
+ * adc_init : prepare the sample tables and filters, and hook the ADC callback
+ *
+ */
+
+void adc_init() {
+	uint8_t b;
+
+	memset(&r_adc_stats,0,sizeof(r_adc_stats));
+
+	if (IO_GROVE_JOYSTICK_ENABLE) {
+		adc_channel_init(0, JOYSTICK_X_PORT, ADC_IIR_SHIFT, JOYSTICK_X_MID, JOYSTICK_DELTA_XY_MIN, false);
+		adc_channel_init(1, JOYSTICK_Y_PORT, ADC_IIR_SHIFT, JOYSTICK_Y_MID, JOYSTICK_DELTA_XY_MIN, false);
+	} else {
+		// toggle switch steps, mapped in scan_controls()
+		adc_channel_init(0, JOYSTICK_X_PORT, 0, 0, 0, false);
+		adc_channel_init(1, JOYSTICK_Y_PORT, 0, 0, 0, false);
+	}
+	adc_channel_init(2, JOYSTICK_Z_PORT, ADC_IIR_SHIFT, JOYSTICK_Z_MID, JOYSTICK_DELTA_Z_MIN, JOYSTICK_Z_INVERT);
+
+	for (b=0;b<2;b++) {
+		table[b].entries     = sample[b];
+		table[b].num_entries = ADC_MAX;
+	}
+	adc_filling = 0;
+	adc_done = 0;
+	adc_value_front = 0;
+
+	adc_set_callback(adc, adcCallback);
+}
+
+/*
+ * adc_start : start a conversion into the table that is not holding the latest result
+ *
+ */
+
+static bool adc_start() {
+	int32_t rc;
+
+	adc_filling = 1 - adc_done;
+	rc = adc_read(adc, &table[adc_filling]);
+	if (DEV_OK != rc) {
+		r_adc_stats.errors++;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * adc_median : median of the channel's last samples
+ *
+ */
+
+static int32_t adc_median(uint16_t *v) {
+	if (v[0] > v[1]) {
+		if (v[1] > v[2]) return v[1];
+		return (v[0] > v[2]) ? v[2] : v[0];
+	} else {
+		if (v[0] > v[2]) return v[0];
+		return (v[1] > v[2]) ? v[2] : v[1];
+	}
+}
+
+/*
+ * adc_filter : filter a completed conversion and publish the values
+ *
+ */
+
+static void adc_filter(uint16_t raw[ADC_MAX][ADC_OVERSAMPLE]) {
+	struct ROCKET_ADC_CHANNEL_S *ch;
+	uint8_t back = 1 - adc_value_front;
+	int32_t value,distance;
+	uint32_t sum;
+	uint16_t in;
+	uint8_t i,j;
+
+	for (i=0;i<ADC_MAX;i++) {
+		ch = &adc_channel[i];
+
+		// average the oversamples
+		sum = 0;
+		for (j=0;j<ADC_OVERSAMPLE;j++) sum += raw[i][j];
+		in = (uint16_t) ((sum + (ADC_OVERSAMPLE / 2)) / ADC_OVERSAMPLE);
+
+		// is the channel 'upside down' ?
+		if (ch->invert)
+			in = JOYSTICK_Z_MAX - in;
+
+		// median of the last samples (seeded with the first sample)
+		if (!ch->primed) {
+			for (j=0;j<ADC_MEDIAN_MAX;j++) ch->median[j] = in;
+			ch->iir = (int32_t) in << ADC_IIR_FRACTION;
+			ch->primed = true;
+		}
+		ch->median[ch->median_next] = in;
+		ch->median_next = (ch->median_next + 1) % ADC_MEDIAN_MAX;
+		value = adc_median(ch->median);
+
+		// low pass
+		if (ch->iir_shift) {
+			ch->iir += ((value << ADC_IIR_FRACTION) - ch->iir) >> ch->iir_shift;
+			value = (ch->iir + (1 << (ADC_IIR_FRACTION-1))) >> ADC_IIR_FRACTION;
+		}
+
+		// center dead zone with hysteresis
+		if (ch->dead_delta) {
+			distance = abs(value - ch->dead_mid);
+			if (ch->dead_active) {
+				if (distance < (ch->dead_delta - ADC_HYSTERESIS))
+					ch->dead_active = false;
+			} else {
+				if (distance > (ch->dead_delta + ADC_HYSTERESIS))
+					ch->dead_active = true;
+			}
+			if (!ch->dead_active)
+				value = ch->dead_mid;
+		}
+
+		adc_value[back][i] = value;
+	}
+	adc_value_front = back;
+}
+
+/*
+ * adc_snapshot : return the latest filtered joystick and slider values
+ *
+ */
+
+void adc_snapshot(int32_t *x, int32_t *y, int32_t *z) {
+	int32_t *front;
+
+	if (!adc_running) {
+		// no background sampling, convert now and wait for it
+		if (adc_start()) {
+			task_event_recv_wait(ADCREADY);
+			r_adc_stats.conversions++;
+			adc_filter(seq_buffer[adc_done]);
+		} else {
+			PRINT("ERROR: ADC read error!\n");
+		}
+	}
+
+	front = adc_value[adc_value_front];
+	*x = front[0];
+	*y = front[1];
+	*z = front[2];
+	r_adc_stats.snapshots++;
+}
+
+/*
+ * adc_report : display the sampling statistics
+ *
+ */
+
+void adc_report() {
+	if (!IO_JOYSTICK_ENABLE)
+		return;
+
+	PRINT("*** ADC(%d conversions, %d snapshots): lost=%d errors=%d overruns=%d\n",
+		r_adc_stats.conversions,
+		r_adc_stats.snapshots,
+		r_adc_stats.lost,
+		r_adc_stats.errors,
+		r_adc_stats.overruns);
+}
+
+/*
+ * adc_wait_deadline : wait for the next sampling deadline
+ *
+ */
+
+static void adc_wait_deadline() {
+	int32_t remaining = (int32_t) (adc_deadline - task_tick_get_32());
+
+	if (remaining > 0) {
+		nano_task_timer_start(&adc_timer,remaining);
+		nano_task_timer_test(&adc_timer,TICKS_UNLIMITED);
+	} else if (remaining < 0) {
+		// overrun: restart the grid from now
+		r_adc_stats.overruns++;
+		adc_deadline = task_tick_get_32();
+	}
+	adc_deadline += ADC_SAMPLE_TICKS;
+}
+
+/*
+ * rocket_adc_task : high priority task that converts and filters the analog controls
+ *
+ */
+
+void rocket_adc_task() {
+	uint8_t done;
+
+	if (!IO_JOYSTICK_ENABLE)
+		return;
+
+	nano_timer_init(&adc_timer,adc_timer_data);
+	adc_running = true;
+	adc_deadline = task_tick_get_32() + ADC_SAMPLE_TICKS;
+	adc_start();
+
+	while (1) {
+		if (RC_OK != task_event_recv_wait_timeout(ADCREADY,ADC_WAIT_TICKS)) {
+			// the conversion was lost (or never started), start again
+			r_adc_stats.lost++;
+			adc_start();
+			continue;
+		}
+		r_adc_stats.conversions++;
+
+		// start the next conversion at its deadline, and filter this one while it runs
+		done = adc_done;
+		adc_wait_deadline();
+		adc_start();
+		adc_filter(seq_buffer[done]);
+	}
+}
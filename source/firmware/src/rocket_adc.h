@@ -0,0 +1,60 @@
+/* rocket_adc.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/* Sampling */
+#define ADC_SAMPLE_TICKS	1		// background sampling period (one conversion of all channels)
+#define ADC_OVERSAMPLE		4		// samples of each channel per conversion, averaged
+#define ADC_WAIT_TICKS		10		// longest wait for a conversion before it counts as lost
+#define ADC_MEDIAN_MAX		3		// median of the last three samples removes single spikes
+#define ADC_IIR_SHIFT		2		// IIR weight of each new sample = 1/(2^shift)
+#define ADC_IIR_FRACTION	4		// fixed point fraction bits of the IIR state
+
+/* Dead zone hysteresis: a channel leaves the center zone only when it is this
+ * far beyond the zone's edge, and returns when it is this far inside it */
+#define ADC_HYSTERESIS		12
+
+struct ROCKET_ADC_CHANNEL_S {
+	uint16_t median[ADC_MEDIAN_MAX];	// last raw samples
+	uint8_t  median_next;				// next slot to replace
+	bool     primed;					// the filter has been seeded
+	int32_t  iir;						// filter state (fixed point)
+	uint8_t  iir_shift;					// 0 = no IIR (e.g. the toggle joystick)
+	int32_t  dead_mid;					// center of the dead zone
+	int32_t  dead_delta;				// half width of the dead zone (0 = none)
+	bool     dead_active;				// outside the dead zone
+	bool     invert;					// the channel is 'upside down', invert each sample
+};
+
+struct ROCKET_ADC_STATS_S {
+	uint32_t conversions;		// completed conversions
+	uint32_t errors;			// conversions that could not be started
+	uint32_t lost;				// conversions that did not complete in time
+	uint32_t overruns;			// sampling deadlines already passed (the grid restarts from now)
+	uint32_t snapshots;			// snapshots read by scan_controls()
+};
+
+extern struct ROCKET_ADC_STATS_S r_adc_stats;
+
+void adc_init();
+void adc_snapshot(int32_t *x, int32_t *y, int32_t *z);
+void adc_report();
+void rocket_adc_task();
@@ -0,0 +1,447 @@
+/* rocket_bench.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - Each kernel is called over a fixed corpus of game space positions (a 4x4x4
+ *    grid with odd offsets, plus joystick and angle values derived from it), so
+ *    every run, on the board or on the host, times the same work
+ *  - Every call is timed with the cycle counter, less the cost of the counter
+ *    reads themselves, for the mean and worst case per call in nSec
+ *  - The kernels' answers are folded into a check value, which also keeps the
+ *    compiler from discarding the calls; a changed check means a kernel now
+ *    computes something different, not just faster or slower
+ *  - The game state that the kernels use (r_space, r_towers, r_flight, r_control,
+ *    r_game) is saved and restored around the run, and the game is set to
+ *    simulate so that no motor commands are sent
+ *  - bench_report() prints one "BENCH,..." line per kernel, to be picked out of
+ *    the console log; the host build (see ../host) also writes them as CSV
+ *  - Run from the Test > Bench state, or the host's "-b" option
+ */
+
+#include <zephyr.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_space.h"
+#include "rocket_math.h"
+#include "rocket_hist.h"
+#include "rocket_profile.h"
+#include "rocket_bench.h"
+
+
+struct BENCH_RESULT_S r_bench[BENCH_KERNEL_MAX] = {
+	[BENCH_SQRT]       = { "sqrt_rocket",                  "Sqrt"      },
+	[BENCH_UM2STEPS]   = { "micrometers2steps",            "Um2Step"   },
+	[BENCH_STEPS2UM]   = { "steps2micrometers",            "Step2Um"   },
+	[BENCH_SINE]       = { "degrees2sine",                 "Sine"      },
+	[BENCH_COSINE]     = { "degrees2cosine",               "Cosine"    },
+	[BENCH_ATAN2]      = { "atan2degrees",                 "Atan2"     },
+	[BENCH_LENGTH]     = { "get_length",                   "Length"    },
+	[BENCH_CABLES]     = { "compute_rocket_cable_lengths", "Cables"    },
+	[BENCH_KINEMATICS] = { "compute_rocket_next_position", "Kinematic" },
+	[BENCH_FLY_LINEAR] = { "flight_linear_loop",           "FlyLine"   },
+	[BENCH_FLY_CIRCLE] = { "flight_circular_loop",         "FlyCircle" },
+	[BENCH_FLY_ROTATE] = { "flight_circular_loop_xyz",     "FlyRotate" },
+	[BENCH_FLY_WAIT]   = { "flight_wait_loop",             "FlyWait"   },
+};
+
+struct BENCH_POINT_S {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+};
+
+static struct BENCH_POINT_S bench_corpus[BENCH_CORPUS_MAX];
+
+static uint32_t bench_overhead;		// cycles of an empty timed call
+static uint64_t bench_sum;			// cycles of the current kernel
+static uint32_t bench_max;
+static uint32_t bench_calls;
+static uint32_t bench_check;
+
+/*
+ * bench_corpus_init : the fixed input positions
+ *
+ */
+
+static void bench_corpus_init() {
+	uint8_t i;
+
+	for (i=0;i<BENCH_CORPUS_MAX;i++) {
+		// grid points at 1/8, 3/8, 5/8, 7/8 of each axis, moved off the round numbers
+		bench_corpus[i].x = X_POS_MIN + (((( i       & 0x3) * 2) + 1) * ((X_POS_MAX-X_POS_MIN)/8L)) + (i * 1237L);
+		bench_corpus[i].y = Y_POS_MIN + (((((i >> 2) & 0x3) * 2) + 1) * ((Y_POS_MAX-Y_POS_MIN)/8L)) - (i *  911L);
+		bench_corpus[i].z = Z_POS_MIN + (((((i >> 4) & 0x3) * 2) + 1) * ((Z_POS_MAX-Z_POS_MIN)/8L)) + (i *  523L);
+	}
+}
+
+/*
+ * bench_begin, bench_end : time one call, from the cycle count returned by bench_begin()
+ *
+ */
+
+static inline uint32_t bench_begin() {
+	return task_cycle_get_32();
+}
+
+static inline void bench_end(uint32_t cycle_start, uint32_t result) {
+	uint32_t cycles = task_cycle_get_32() - cycle_start;
+
+	cycles = (cycles > bench_overhead) ? (cycles - bench_overhead) : 0;
+	bench_sum += cycles;
+	if (cycles > bench_max)
+		bench_max = cycles;
+	bench_calls++;
+	bench_check = (bench_check * 31) + result;
+}
+
+/*
+ * bench_cycles2nsec : cycles to nSec, without the uSec rounding of hist_cycles2usec()
+ *
+ */
+
+static uint32_t bench_cycles2nsec(uint64_t cycles) {
+	if (0 == sys_clock_hw_cycles_per_sec)
+		return (uint32_t) cycles;
+	return (uint32_t) ((cycles * 1000000000ULL) / sys_clock_hw_cycles_per_sec);
+}
+
+/*
+ * bench_kernel_start, bench_kernel_done : collect one kernel's result
+ *
+ */
+
+static void bench_kernel_start() {
+	bench_sum = 0;
+	bench_max = 0;
+	bench_calls = 0;
+	bench_check = 0;
+}
+
+static void bench_kernel_done(uint8_t kernel) {
+	r_bench[kernel].calls = bench_calls;
+	r_bench[kernel].ns_mean = bench_calls ? bench_cycles2nsec(bench_sum / bench_calls) : 0;
+	r_bench[kernel].ns_worst = bench_cycles2nsec(bench_max);
+	r_bench[kernel].check = bench_check;
+}
+
+/*
+ * bench_calibrate : the cost of the cycle counter reads, the least of many tries
+ *
+ */
+
+static void bench_calibrate() {
+	uint32_t cycles,cycle_start;
+	uint16_t i;
+
+	bench_overhead = 0xffffffff;
+	for (i=0;i<256;i++) {
+		cycle_start = task_cycle_get_32();
+		cycles = task_cycle_get_32() - cycle_start;
+		if (cycles < bench_overhead)
+			bench_overhead = cycles;
+	}
+}
+
+/*
+ * bench_space_reset : put the rocket at a corpus position, at rest
+ *
+ */
+
+static void bench_space_reset(struct BENCH_POINT_S *point) {
+	memset(&r_space,0,sizeof(r_space));
+	r_space.rocket_x = r_space.rocket_goal_x = point->x;
+	r_space.rocket_y = r_space.rocket_goal_y = point->y;
+	r_space.rocket_z = r_space.rocket_goal_z = point->z;
+	r_space.rocket_fuel = FUEL_SUPPLY_INIT;
+	r_space.gravity_delta = GRAVITY_UMETER_PER_SECOND;
+}
+
+/*
+ * bench_math : the rocket_math kernels
+ *
+ */
+
+static void bench_math() {
+	struct BENCH_POINT_S *a,*b;
+	uint32_t cycle_start,result;
+	int32_t x,y,z,v;
+	uint16_t pass;
+	uint8_t i;
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			// the cable length sum of squares (see do_compute_cable_length)
+			a = &bench_corpus[i];
+			x = (a->x - r_towers[i & 0x3].pos_x) >> 6;
+			y = (a->y - r_towers[i & 0x3].pos_y) >> 6;
+			z = (a->z - r_towers[i & 0x3].pos_z) >> 6;
+			v = (x*x)+(y*y)+(z*z);
+			cycle_start = bench_begin();
+			result = sqrt_rocket(v);
+			bench_end(cycle_start,result);
+		}
+	}
+	bench_kernel_done(BENCH_SQRT);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			// cable lengths from 100 to 740 mm
+			v = 100000L + (i * 10000L) + (pass * 37L);
+			cycle_start = bench_begin();
+			result = micrometers2steps(i & 0x3,v);
+			bench_end(cycle_start,result);
+		}
+	}
+	bench_kernel_done(BENCH_UM2STEPS);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			// the step counts of the same lengths
+			v = 1919L + (i * 115L) + pass;
+			cycle_start = bench_begin();
+			result = steps2micrometers(i & 0x3,v);
+			bench_end(cycle_start,result);
+		}
+	}
+	bench_kernel_done(BENCH_STEPS2UM);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			// 0..359 degrees
+			v = ((i * 360L) / BENCH_CORPUS_MAX) + (pass & 0x3);
+			cycle_start = bench_begin();
+			result = (int32_t) (degrees2sine(v) * 1000000.0);
+			bench_end(cycle_start,result);
+		}
+	}
+	bench_kernel_done(BENCH_SINE);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			v = ((i * 360L) / BENCH_CORPUS_MAX) + (pass & 0x3);
+			cycle_start = bench_begin();
+			result = (int32_t) (degrees2cosine(v) * 1000000.0);
+			bench_end(cycle_start,result);
+		}
+	}
+	bench_kernel_done(BENCH_COSINE);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			// the antenna pan angle (see antenna_update_space)
+			a = &bench_corpus[i];
+			cycle_start = bench_begin();
+			result = atan2degrees((double) (a->x - ANTENNA_X_POS), (double) (a->y - ANTENNA_Y_POS));
+			bench_end(cycle_start,result);
+		}
+	}
+	bench_kernel_done(BENCH_ATAN2);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			a = &bench_corpus[i];
+			b = &bench_corpus[(i + 1 + pass) % BENCH_CORPUS_MAX];
+			cycle_start = bench_begin();
+			result = get_length(a->x,a->y,a->z,b->x,b->y,b->z);
+			bench_end(cycle_start,result);
+		}
+	}
+	bench_kernel_done(BENCH_LENGTH);
+}
+
+/*
+ * bench_space : the per-frame rocket_space kernels
+ *
+ */
+
+static void bench_space() {
+	struct BENCH_POINT_S *a;
+	uint32_t cycle_start;
+	uint16_t pass;
+	uint8_t i;
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			a = &bench_corpus[i];
+			r_space.rocket_goal_x = a->x;
+			r_space.rocket_goal_y = a->y;
+			r_space.rocket_goal_z = a->z;
+			cycle_start = bench_begin();
+			compute_rocket_cable_lengths();
+			bench_end(cycle_start,r_towers[ROCKET_TOWER_NW].step_goal ^ r_towers[ROCKET_TOWER_SE].step_goal);
+		}
+	}
+	bench_kernel_done(BENCH_CABLES);
+
+	// from each start point, fly with the joystick sweeping through its range
+	bench_kernel_start();
+	r_game.game = GAME_XYZ_LAND;
+	r_game.gravity_option = GAME_GRAVITY_NORMAL;
+	r_game.fuel_option = GAME_FUEL_NORMAL;
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		bench_space_reset(&bench_corpus[pass]);
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			r_control.analog_x = JOYSTICK_X_MIN + ((i * 7) % 8) * ((JOYSTICK_X_MAX - JOYSTICK_X_MIN)/7);
+			r_control.analog_y = JOYSTICK_Y_MIN + ((i * 5) % 8) * ((JOYSTICK_Y_MAX - JOYSTICK_Y_MIN)/7);
+			r_control.analog_z = JOYSTICK_Z_MIN + ((i * 3) % 8) * ((JOYSTICK_Z_MAX - JOYSTICK_Z_MIN)/7);
+			cycle_start = bench_begin();
+			compute_rocket_next_position();
+			bench_end(cycle_start,r_space.rocket_goal_x ^ r_space.rocket_goal_y ^ r_space.rocket_goal_z);
+		}
+	}
+	bench_kernel_done(BENCH_KINEMATICS);
+}
+
+/*
+ * bench_flight : the flight loops, one frame per call
+ *
+ */
+
+static void bench_flight() {
+	struct BENCH_POINT_S *a,*b;
+	uint32_t cycle_start;
+	uint16_t pass;
+	uint8_t i;
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		a = &bench_corpus[pass];
+		b = &bench_corpus[BENCH_CORPUS_MAX - 1 - pass];
+		bench_space_reset(a);
+		flight_linear(b->x,b->y,b->z,MOTOR_SPEED_AUTO);
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			cycle_start = bench_begin();
+			flight_linear_loop();
+			bench_end(cycle_start,r_flight.current_x ^ r_flight.current_y ^ r_flight.current_z);
+		}
+	}
+	bench_kernel_done(BENCH_FLY_LINEAR);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		a = &bench_corpus[pass];
+		bench_space_reset(a);
+		flight_circular(0,0,20 + pass,ROCKET_HOME_X,ROCKET_HOME_Y,a->z,10000);
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			cycle_start = bench_begin();
+			flight_circular_loop();
+			bench_end(cycle_start,r_flight.current_x ^ r_flight.current_y ^ r_flight.current_z);
+		}
+	}
+	bench_kernel_done(BENCH_FLY_CIRCLE);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		a = &bench_corpus[pass];
+		bench_space_reset(a);
+		flight_circular(10,20,20 + pass,ROCKET_HOME_X,ROCKET_HOME_Y,a->z,10000);
+		// start off the axes, so that every frame takes the rigid rotation path
+		r_flight.current_ax = 1000L;
+		r_flight.current_ay = 1000L;
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			cycle_start = bench_begin();
+			flight_circular_loop();
+			bench_end(cycle_start,r_flight.current_x ^ r_flight.current_y ^ r_flight.current_z);
+		}
+	}
+	bench_kernel_done(BENCH_FLY_ROTATE);
+
+	bench_kernel_start();
+	for (pass=0;pass<BENCH_PASSES;pass++) {
+		bench_space_reset(&bench_corpus[pass]);
+		flight_wait(10000);
+		for (i=0;i<BENCH_CORPUS_MAX;i++) {
+			cycle_start = bench_begin();
+			flight_wait_loop();
+			bench_end(cycle_start,r_flight.frame_count);
+		}
+	}
+	bench_kernel_done(BENCH_FLY_WAIT);
+}
+
+/*
+ * bench_run : time all of the kernels, leaving the game state as it was
+ *
+ */
+
+void bench_run() {
+	static struct ROCKET_SPACE_S space_save;
+	static struct ROCKET_TOWER_S towers_save[ROCKET_TOWER_MAX];
+	static struct ROCKET_FLIGHT_S flight_save;
+	static struct ROCKET_CONTROL_S control_save;
+	static struct ROCKET_GAME_S game_save;
+
+	space_save = r_space;
+	memcpy(towers_save,r_towers,sizeof(towers_save));
+	flight_save = r_flight;
+	control_save = r_control;
+	game_save = r_game;
+
+	// no motor commands, and the physics steps of a normal frame
+	r_game.game_mode = GAME_SIMULATE;
+	r_game.frame_dt_ms = r_game.frame_ms;
+
+	bench_corpus_init();
+	bench_calibrate();
+	bench_math();
+	bench_space();
+	bench_flight();
+
+	r_space = space_save;
+	memcpy(r_towers,towers_save,sizeof(towers_save));
+	r_flight = flight_save;
+	r_control = control_save;
+	r_game = game_save;
+
+	// the kernels' own profile points have just timed the benchmark, not the game
+	profile_reset();
+}
+
+/*
+ * bench_report : one machine readable line per kernel
+ *
+ */
+
+void bench_report() {
+	uint8_t i;
+
+	PRINT("BENCH,kernel,calls,ns_mean,ns_worst,check\n");
+	for (i=0;i<BENCH_KERNEL_MAX;i++) {
+		PRINT("BENCH,%s,%d,%d,%d,%08x\n",
+			r_bench[i].name,
+			r_bench[i].calls,
+			r_bench[i].ns_mean,
+			r_bench[i].ns_worst,
+			r_bench[i].check);
+	}
+}
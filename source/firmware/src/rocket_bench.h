@@ -0,0 +1,54 @@
+/* rocket_bench.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/* Benchmark controls */
+#define BENCH_CORPUS_MAX	64		// fixed inputs per kernel (a 4x4x4 grid of the game space)
+#define BENCH_PASSES		16		// passes over the corpus per kernel
+
+/* Kernels, in the order of the report */
+#define BENCH_SQRT			0	// sqrt_rocket()
+#define BENCH_UM2STEPS		1	// micrometers2steps()
+#define BENCH_STEPS2UM		2	// steps2micrometers()
+#define BENCH_SINE			3	// degrees2sine()
+#define BENCH_COSINE		4	// degrees2cosine()
+#define BENCH_ATAN2			5	// atan2degrees()
+#define BENCH_LENGTH		6	// get_length()
+#define BENCH_CABLES		7	// compute_rocket_cable_lengths(), i.e. do_compute_cable_length() for the four towers
+#define BENCH_KINEMATICS	8	// compute_rocket_next_position()
+#define BENCH_FLY_LINEAR	9	// flight_linear_loop()
+#define BENCH_FLY_CIRCLE	10	// flight_circular_loop(), rotation on the z axis
+#define BENCH_FLY_ROTATE	11	// flight_circular_loop(), rigid rotation on all axes
+#define BENCH_FLY_WAIT		12	// flight_wait_loop()
+#define BENCH_KERNEL_MAX	13
+
+struct BENCH_RESULT_S {
+	const char *name;		// kernel function
+	const char *label;		// short name for the LCD
+	uint32_t calls;			// timed calls
+	uint32_t ns_mean;		// mean time per call (nSec)
+	uint32_t ns_worst;		// worst call (nSec)
+	uint32_t check;			// fingerprint of the results, changes if the kernel's answers change
+};
+
+extern struct BENCH_RESULT_S r_bench[BENCH_KERNEL_MAX];
+
+void bench_run();
+void bench_report();
@@ -0,0 +1,348 @@
+/* rocket_button.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - Button edges, not levels, drive the state machine. Each accepted edge is
+ *    timestamped and queued, and state_loop() drains the queue, so a press is
+ *    never lost to a frame that did not happen to sample it, and two presses in
+ *    one frame are handled on consecutive frames
+ *  - The RED button (IO3) is Quark GPIO6, which interrupts on both edges. The
+ *    GREEN button (IO7) is behind the i2c expander, which cannot interrupt, so the
+ *    button task (see prj.mdef) polls it every BUTTON_POLL_MS, well inside the
+ *    debounce time. Each poll is one expander read. The task also re-reads the
+ *    RED level straight from the SoC GPIO (no bus), which catches a final level
+ *    whose edge the debounce rejected; it is the RED button's only source if its
+ *    interrupt cannot be configured, and then it needs the expander read too
+ *  - Debounce is by time: an edge that does not change the accepted level, or that
+ *    comes within BUTTON_DEBOUNCE_MS of the last accepted edge, is bounce
+ *  - Presses are decided from their timestamps, in the order they happened. A
+ *    press of both buttons within BUTTON_CHORD_MS is a chord (the main menu). So
+ *    a single press is held back until its button is released, or until the
+ *    chord window has passed while it is held, and is then delivered once
+ *  - In a 'hold' state (see STATE_BUTTON_HOLD_*) a button is on/off: once its
+ *    press is decided, its event is repeated every frame until its release edge
+ *  - The accepted levels remain available for the bringup display
+ *  - Until the task runs (or when IO_TASKS_ENABLE is false) scan_controls()
+ *    polls the buttons once per frame, which still queues the edges in order
+ */
+
+#include <zephyr.h>
+
+#include <gpio.h>
+#include "groveLCDUtils.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_space.h"
+#include "rocket_io.h"
+#include "rocket_hist.h"
+#include "rocket_button.h"
+
+
+struct ROCKET_BUTTON_STATS_S r_button_stats;
+
+extern struct device *gpio07;
+
+/* accepted (debounced) state, shared by the ISR and the polling task */
+static bool button_down[BUTTON_MAX];
+static uint32_t button_edge_cycles[BUTTON_MAX];
+static bool button_a_irq = false;
+static bool button_running = false;
+
+/* edge queue: ISR and polling task to state_loop() */
+static struct BUTTON_EDGE_S button_queue[BUTTON_QUEUE_MAX];
+static uint8_t button_queue_head = 0;
+static uint8_t button_queue_tail = 0;
+
+/* state_loop() press decisions */
+static bool button_pending[BUTTON_MAX];
+static bool button_held[BUTTON_MAX];
+static uint32_t button_press_cycles[BUTTON_MAX];
+
+/*
+ * button_sample : debounce a button level, and queue the edge if accepted
+ *
+ *  Called from the GPIO ISR and from the polling task
+ *
+ */
+
+static void button_sample(uint8_t button, bool pressed, bool from_isr) {
+	uint32_t now = sys_cycle_get_32();
+	uint32_t debounce = (sys_clock_hw_cycles_per_sec / 1000) * BUTTON_DEBOUNCE_MS;
+	unsigned int key;
+	uint8_t next;
+
+	key = irq_lock();
+
+	if (pressed == button_down[button]) {
+		irq_unlock(key);
+		return;
+	}
+	if ((now - button_edge_cycles[button]) < debounce) {
+		r_button_stats.bounces++;
+		irq_unlock(key);
+		return;
+	}
+
+	button_down[button] = pressed;
+	button_edge_cycles[button] = now;
+	r_button_stats.edges++;
+	if (from_isr)
+		r_button_stats.edges_isr++;
+
+	next = (button_queue_tail + 1) % BUTTON_QUEUE_MAX;
+	if (next == button_queue_head) {
+		r_button_stats.dropped++;
+	} else {
+		button_queue[button_queue_tail].cycles = now;
+		button_queue[button_queue_tail].button = button;
+		button_queue[button_queue_tail].pressed = pressed;
+		button_queue_tail = next;
+	}
+
+	irq_unlock(key);
+}
+
+/*
+ * button_edge_get : take the oldest queued edge
+ *
+ */
+
+static bool button_edge_get(struct BUTTON_EDGE_S *edge) {
+	unsigned int key;
+	bool found = false;
+
+	key = irq_lock();
+	if (button_queue_head != button_queue_tail) {
+		*edge = button_queue[button_queue_head];
+		button_queue_head = (button_queue_head + 1) % BUTTON_QUEUE_MAX;
+		found = true;
+	}
+	irq_unlock(key);
+	return found;
+}
+
+/*
+ * button_isr : GPIO callback for the RED button
+ *
+ */
+
+static void button_isr(struct device *port, uint32_t pin) {
+	uint32_t value = 0;
+
+	if (BUTTON_A_GPIO != pin)
+		return;
+	gpio_pin_read(port, BUTTON_A_GPIO, &value);
+	button_sample(BUTTON_A, 0 != value, true);
+}
+
+/*
+ * button_init : reset the button state, and attach the RED button's interrupt
+ *
+ */
+
+void button_init() {
+	uint32_t now = sys_cycle_get_32();
+	uint8_t b;
+
+	memset(&r_button_stats,0,sizeof(r_button_stats));
+	for (b=0;b<BUTTON_MAX;b++) {
+		button_down[b] = false;
+		button_edge_cycles[b] = now;
+		button_pending[b] = false;
+		button_held[b] = false;
+	}
+	button_queue_head = 0;
+	button_queue_tail = 0;
+
+	if (!IO_BUTTONS_ENABLE)
+		return;
+
+	// if the edge interrupt cannot be configured, the RED button is polled through the expander
+	button_a_irq = false;
+	if (gpio07 &&
+		(DEV_OK == gpio_pin_configure(gpio07, BUTTON_A_GPIO,
+			GPIO_DIR_IN | GPIO_INT | GPIO_INT_EDGE | GPIO_INT_DOUBLE_EDGE)) &&
+		(DEV_OK == gpio_set_callback(gpio07, button_isr)) &&
+		(DEV_OK == gpio_pin_enable_callback(gpio07, BUTTON_A_GPIO))) {
+		button_a_irq = true;
+	} else {
+		PRINT("NOTE: button interrupt not available, polling\n");
+	}
+}
+
+/*
+ * button_poll : sample the polled button levels (the expander button needs the bus)
+ *
+ */
+
+void button_poll() {
+	uint32_t value = 0;
+	bool a = false,b;
+
+	if (!IO_BUTTONS_ENABLE)
+		return;
+
+	// the RED level, on the SoC GPIO, in case the interrupt's last edge was bounce
+	if (button_a_irq) {
+		gpio_pin_read(gpio07, BUTTON_A_GPIO, &value);
+		button_sample(BUTTON_A, 0 != value, false);
+	}
+
+	// a busy bus skips this poll, the levels are sampled again next time
+	if (!io_bus_trylock())
+		return;
+	if (!button_a_irq)
+		a = (0 != gpioInputGet(INPUT_A_PIN));
+	b = (0 != gpioInputGet(INPUT_B_PIN));
+	io_bus_unlock();
+
+	if (!button_a_irq)
+		button_sample(BUTTON_A, a, false);
+	button_sample(BUTTON_B, b, false);
+}
+
+/*
+ * button_level : the accepted (debounced) level of a button
+ *
+ */
+
+bool button_level(uint8_t button) {
+	return button_down[button];
+}
+
+/*
+ * button_decided : a press is decided, record its latency
+ *
+ */
+
+static uint8_t button_decided(uint8_t event, uint32_t press_cycles) {
+	uint32_t latency_us = hist_cycles2usec(task_cycle_get_32() - press_cycles);
+
+	r_button_stats.events++;
+	if (BUTTON_EVENT_CHORD == event)
+		r_button_stats.chords++;
+	if (latency_us > r_button_stats.latency_max_us)
+		r_button_stats.latency_max_us = latency_us;
+	return event;
+}
+
+/*
+ * button_event : drain the queued edges until a press or chord is decided
+ *
+ *  Called once per frame by state_loop(), with the buttons (BUTTON_HOLD_*) that
+ *  the current state treats as on/off. Edges after the decided event stay queued
+ *  for the next frame.
+ *
+ */
+
+uint8_t button_event(uint8_t hold) {
+	uint32_t window = (sys_clock_hw_cycles_per_sec / 1000) * BUTTON_CHORD_MS;
+	struct BUTTON_EDGE_S edge;
+	uint8_t b,other;
+
+	while (button_edge_get(&edge)) {
+		b = edge.button;
+		other = 1 - b;
+		button_held[b] = edge.pressed;
+
+		if (edge.pressed) {
+			button_press_cycles[b] = edge.cycles;
+			if (button_held[other] && ((edge.cycles - button_press_cycles[other]) <= window)) {
+				// both pressed together: one chord, not two presses
+				button_pending[b] = false;
+				button_pending[other] = false;
+				return button_decided(BUTTON_EVENT_CHORD, button_press_cycles[other]);
+			}
+			button_pending[b] = true;
+		} else if (button_pending[b]) {
+			// released before the chord window passed
+			button_pending[b] = false;
+			return button_decided((BUTTON_A == b) ? BUTTON_EVENT_A : BUTTON_EVENT_B, button_press_cycles[b]);
+		}
+	}
+
+	// held presses that outlived the chord window
+	for (b=0;b<BUTTON_MAX;b++) {
+		if (button_pending[b] && ((task_cycle_get_32() - button_press_cycles[b]) > window)) {
+			button_pending[b] = false;
+			return button_decided((BUTTON_A == b) ? BUTTON_EVENT_A : BUTTON_EVENT_B, button_press_cycles[b]);
+		}
+	}
+
+	// decided 'hold' buttons stay on until their release edge
+	for (b=0;b<BUTTON_MAX;b++) {
+		if ((hold & (1 << b)) && button_held[b] && !button_pending[b]) {
+			return (BUTTON_A == b) ? BUTTON_EVENT_A : BUTTON_EVENT_B;
+		}
+	}
+
+	return BUTTON_EVENT_NONE;
+}
+
+/*
+ * button_report : display the button statistics
+ *
+ */
+
+void button_report() {
+	if (!IO_BUTTONS_ENABLE)
+		return;
+
+	PRINT("*** BUTTON(%d edges, %d by irq%s): events=%d chords=%d bounces=%d dropped=%d latency_max=%d us\n",
+		r_button_stats.edges,
+		r_button_stats.edges_isr,
+		button_a_irq ? "" : " (polled)",
+		r_button_stats.events,
+		r_button_stats.chords,
+		r_button_stats.bounces,
+		r_button_stats.dropped,
+		r_button_stats.latency_max_us);
+}
+
+/*
+ * rocket_button_task : high priority task that polls the button levels
+ *
+ */
+
+void rocket_button_task() {
+	if (!IO_BUTTONS_ENABLE)
+		return;
+
+	button_running = true;
+	while (1) {
+		button_poll();
+		task_sleep(BUTTON_POLL_TICKS);
+	}
+}
+
+/*
+ * button_scan : per frame poll, when the button task is not running
+ *
+ */
+
+void button_scan() {
+	if (!button_running)
+		button_poll();
+}
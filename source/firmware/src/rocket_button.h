@@ -0,0 +1,69 @@
+/* rocket_button.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/* Buttons */
+#define BUTTON_A			0		// RED (next, stop), Arduino IO3
+#define BUTTON_B			1		// GREEN (select, go), Arduino IO7
+#define BUTTON_MAX			2
+#define BUTTON_A_GPIO		6		// IO3 is Quark GPIO6 on the DW controller (see setup.c)
+
+/* Buttons that the current state treats as on/off (see button_event) */
+#define BUTTON_HOLD_A		(1 << BUTTON_A)
+#define BUTTON_HOLD_B		(1 << BUTTON_B)
+
+/* Timing */
+#define BUTTON_DEBOUNCE_MS	20		// edges closer than this to the last accepted edge are bounce
+#define BUTTON_CHORD_MS		100		// presses of both buttons this close together are a chord
+#define BUTTON_POLL_MS		10		// sampling period of the polled button(s)
+#define BUTTON_POLL_TICKS	((BUTTON_POLL_MS * sys_clock_ticks_per_sec / 1000) + 1)
+#define BUTTON_QUEUE_MAX	16		// edges waiting for the state machine
+
+/* Decided button events */
+#define BUTTON_EVENT_NONE	0
+#define BUTTON_EVENT_A		1
+#define BUTTON_EVENT_B		2
+#define BUTTON_EVENT_CHORD	3
+
+struct BUTTON_EDGE_S {
+	uint32_t cycles;	// time of the edge
+	uint8_t  button;	// BUTTON_A or BUTTON_B
+	bool     pressed;	// new level
+};
+
+struct ROCKET_BUTTON_STATS_S {
+	uint32_t edges;			// accepted edges
+	uint32_t edges_isr;		// accepted edges captured by the interrupt
+	uint32_t bounces;		// rejected edges
+	uint32_t dropped;		// accepted edges lost to a full queue
+	uint32_t events;		// decided presses and chords
+	uint32_t chords;		// decided chords
+	uint32_t latency_max_us;	// longest wait from press to decided event
+};
+
+extern struct ROCKET_BUTTON_STATS_S r_button_stats;
+
+void button_init();
+void button_poll();
+void button_scan();
+bool button_level(uint8_t button);
+uint8_t button_event(uint8_t hold);
+void button_report();
+void rocket_button_task();
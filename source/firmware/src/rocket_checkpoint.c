@@ -0,0 +1,173 @@
+/* rocket_checkpoint.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Checkpoint support: capture check points as the code executes, latest and previous
+ *
+ *  This provides a passive context when the code gets lost, especially if the
+ *  OS is in an idle state and there is no stack trace available back
+ *  into the code.
+ *
+ *  The checkpoint value is in decimal (the native format of the debugger), where
+ *  the 6 digits are:   xxxxxx
+ *                          ^^= the sub-checkpoints in a given sub-routine
+ *                        ^^  = the sub-routine
+ *                      ^^    = the file
+ *
+ * Theory of Implementation
+ *  - Besides the latest and previous checkpoint in r_game, every checkpoint is
+ *    recorded in a ring of the last CHECKPOINT_RING_MAX entries, with its value,
+ *    a cycle time stamp, and the task (or ISR) that passed it
+ *  - A writer reserves its slot with an atomic increment of the head, so tasks
+ *    and ISRs (e.g. adcCallback) can record without locks. An entry whose 'seq'
+ *    does not match its position was overwritten or is still being written.
+ *    The 'seq' is stored last, behind a compiler barrier (the Quark is in order).
+ *  - The ring is in the '.noinit' section, so that it survives a warm reset.
+ *    The magic number tells a surviving ring from power-on garbage, and each
+ *    boot adds a CHECKPOINT_BOOT marker entry, so the entries before the marker
+ *    are what the code was doing before the reset.
+ *  - From the debugger, 'print r_checkpoints' shows the ring, where 'head' is the
+ *    next sequence number and entry[(head-1) % CHECKPOINT_RING_MAX] the latest.
+ *    The Test > Checkpoints state dumps the recent entries to the console.
+ */
+
+#include <zephyr.h>
+
+#include <atomic.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_hist.h"
+#include "rocket_checkpoint.h"
+
+
+struct CHECKPOINT_RECORDER_S r_checkpoints __noinit;
+
+/* keep the compiler from moving the entry's stores past its 'seq' store */
+#define CHECKPOINT_BARRIER()	__asm__ __volatile__ ("" : : : "memory")
+
+/*
+ * checkpoint_init : keep a ring that survived a warm reset, else clear it, then mark the boot
+ *
+ */
+
+void checkpoint_init() {
+	if (CHECKPOINT_MAGIC != r_checkpoints.magic) {
+		memset(&r_checkpoints,0,sizeof(r_checkpoints));
+		r_checkpoints.magic = CHECKPOINT_MAGIC;
+	}
+	r_checkpoints.boots++;
+	r_checkpoints.boot_head = (uint32_t) atomic_get(&r_checkpoints.head);
+	checkpoint_v(CHECKPOINT_BOOT,r_checkpoints.boots);
+}
+
+ /* checkpoints to help track where code code got lost without a thread to pause */
+void checkpoint_v(int32_t check_num, int32_t check_value) {
+	struct CHECKPOINT_ENTRY_S *entry;
+	uint32_t seq;
+
+	r_game.check_point_prev = r_game.check_point_now;
+	r_game.check_point_now  = check_num;
+	r_game.check_point_value = check_value;
+
+	if (DEBUG_CHECKPOINT_RING_ENABLE && (CHECKPOINT_MAGIC == r_checkpoints.magic)) {
+		seq = (uint32_t) atomic_inc(&r_checkpoints.head);
+		entry = &r_checkpoints.entry[seq & (CHECKPOINT_RING_MAX-1)];
+		entry->cycles = sys_cycle_get_32();
+		entry->id     = check_num;
+		entry->value  = check_value;
+		if (NANO_CTX_ISR == sys_execution_context_type_get()) {
+			entry->task = CHECKPOINT_TASK_ISR;
+		} else {
+			entry->task = (uint16_t) task_id_get();
+		}
+		CHECKPOINT_BARRIER();
+		entry->seq    = (uint16_t) seq;
+	}
+}
+
+void checkpoint(int32_t check_num) {
+	checkpoint_v(check_num,0);
+}
+
+/*
+ * checkpoint_before_boot : the last checkpoint recorded before this boot (0 if unknown)
+ *
+ */
+
+int32_t checkpoint_before_boot() {
+	struct CHECKPOINT_ENTRY_S *entry;
+	uint32_t seq = r_checkpoints.boot_head - 1;
+
+	if (!DEBUG_CHECKPOINT_RING_ENABLE || (0 == r_checkpoints.boot_head))
+		return 0;
+
+	entry = &r_checkpoints.entry[seq & (CHECKPOINT_RING_MAX-1)];
+	if ((entry->seq != (uint16_t) seq) || (CHECKPOINT_BOOT == entry->id))
+		return 0;
+	return entry->id;
+}
+
+/*
+ * checkpoint_dump : print the most recent checkpoints, oldest first
+ *
+ */
+
+void checkpoint_dump(uint32_t count) {
+	struct CHECKPOINT_ENTRY_S *entry;
+	uint32_t head = (uint32_t) atomic_get(&r_checkpoints.head);
+	uint32_t seq,cycle_prev=0;
+	bool first = true;
+
+	if (!DEBUG_CHECKPOINT_RING_ENABLE)
+		return;
+
+	if (count > CHECKPOINT_RING_MAX)
+		count = CHECKPOINT_RING_MAX;
+	if (count > head)
+		count = head;
+
+	PRINT("\n=== Checkpoints (boot %d, latest last) ===\n",r_checkpoints.boots);
+	PRINT("%8s %8s %10s %6s %10s\n","Seq","Delta","Checkpoint","Task","Value");
+	for (seq=head-count;seq!=head;seq++) {
+		entry = &r_checkpoints.entry[seq & (CHECKPOINT_RING_MAX-1)];
+		if (entry->seq != (uint16_t) seq) {
+			PRINT("%8d (overwritten)\n",seq);
+			continue;
+		}
+		if (CHECKPOINT_BOOT == entry->id) {
+			PRINT("%8d --- boot %d ---\n",seq,entry->value);
+			first = true;
+			continue;
+		}
+		PRINT("%8d %8d %10d %6x %10d\n",
+			seq,
+			first ? 0 : hist_cycles2usec(entry->cycles - cycle_prev),
+			entry->id,
+			entry->task,
+			entry->value);
+		cycle_prev = entry->cycles;
+		first = false;
+	}
+}
@@ -0,0 +1,52 @@
+/* rocket_checkpoint.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/* Flight recorder of the recent checkpoints (see rocket_checkpoint.c) */
+#define CHECKPOINT_RING_MAX		256			// entries in the ring (power of two)
+#define CHECKPOINT_MAGIC		0x524f434bL	// 'ROCK': the ring survived a warm reset
+#define CHECKPOINT_BOOT			999999		// marker entry written at each boot
+#define CHECKPOINT_TASK_ISR		0xffff		// task field for entries written by an ISR
+#define CHECKPOINT_DUMP_MAX		32			// entries shown by the Test > Checkpoints state
+
+struct CHECKPOINT_ENTRY_S {
+	uint32_t cycles;		// time stamp (cycles)
+	int32_t  id;			// checkpoint number
+	int32_t  value;			// checkpoint value
+	uint16_t task;			// task ID, or CHECKPOINT_TASK_ISR
+	uint16_t seq;			// low bits of the ring sequence, to spot stale entries
+};
+
+struct CHECKPOINT_RECORDER_S {
+	uint32_t magic;			// CHECKPOINT_MAGIC once initialized
+	uint32_t boots;			// boots since the ring was cleared
+	atomic_t head;			// next sequence number
+	uint32_t boot_head;		// sequence number of this boot's marker entry
+	struct CHECKPOINT_ENTRY_S entry[CHECKPOINT_RING_MAX];
+};
+
+extern struct CHECKPOINT_RECORDER_S r_checkpoints;
+
+void checkpoint_init();
+void checkpoint_v(int32_t check_num, int32_t check_value);
+void checkpoint(int32_t check_num);
+void checkpoint_dump(uint32_t count);
+int32_t checkpoint_before_boot();
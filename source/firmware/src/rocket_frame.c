@@ -0,0 +1,206 @@
+/* rocket_frame.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Theory of Implementation
+ *  - Frames are released at absolute deadlines, each one frame period after the
+ *    previous deadline (not after the previous wakeup), so the time spent in a
+ *    frame and the tick rounding of each sleep do not accumulate as drift
+ *  - The wait for a deadline uses a nanokernel timer (CONFIG_NANO_TIMERS)
+ *  - If a deadline has already passed when the wait begins, the frame is an
+ *    overrun: it is released at once, and any further deadlines that have also
+ *    passed are skipped, so the following frames fall back onto the original
+ *    period grid instead of bursting to catch up
+ *  - The number of periods since the previous release is returned, so that
+ *    physics can integrate the real elapsed time (up to FRAME_CATCHUP_MAX)
+ *  - The physics steps also advance r_game.game_time_ms, the clock for the game
+ *    timers, so that a replayed session (see rocket_record.c) sees the same time
+ *  - Every release is measured in cycles, for the period and jitter histograms
+ *    shown by the Test > Jitter state and frame_report()
+ */
+
+#include <zephyr.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_hist.h"
+#include "rocket_frame.h"
+
+
+struct ROCKET_FRAME_STATS_S r_frame_stats;
+
+static struct nano_timer frame_timer;
+static void *frame_timer_data[1];
+static uint32_t frame_deadline;			// tick of the next release
+static uint32_t frame_period;			// frame period (ticks) the deadline grid uses
+static uint32_t frame_release_cycle;	// cycle of the previous release
+static bool frame_released = false;
+static volatile bool frame_clear_request = false;
+
+/*
+ * frame_period_ticks : the current frame period in ticks (at least one)
+ *
+ */
+
+static uint32_t frame_period_ticks() {
+	uint32_t ticks = SLEEPTICKS;
+
+	return (ticks > 0) ? ticks : 1;
+}
+
+/*
+ * frame_sched_reset : clear the statistics, and start a new deadline grid from now
+ *
+ */
+
+static void frame_sched_reset() {
+	memset(&r_frame_stats,0,sizeof(r_frame_stats));
+	hist_reset(&r_frame_stats.period);
+	hist_reset(&r_frame_stats.jitter);
+
+	frame_period = frame_period_ticks();
+	r_frame_stats.period_cycles = (sys_clock_hw_cycles_per_sec / 1000) * r_game.frame_ms;
+	frame_deadline = task_tick_get_32() + frame_period;
+	frame_released = false;
+	frame_clear_request = false;
+}
+
+/*
+ * frame_sched_clear : ask the scheduling task to clear the statistics at its next frame
+ *
+ */
+
+void frame_sched_clear() {
+	frame_clear_request = true;
+}
+
+/*
+ * frame_sched_init : prepare the frame timer
+ *
+ */
+
+void frame_sched_init() {
+	nano_timer_init(&frame_timer,frame_timer_data);
+	frame_sched_reset();
+}
+
+/*
+ * frame_sched_wait : wait for the next frame deadline, return the periods since the last release
+ *
+ */
+
+uint32_t frame_sched_wait() {
+	uint32_t now,cycle,measured,late,missed;
+	uint32_t periods = 1;
+	int32_t remaining;
+
+	// a new frame rate starts a new grid (and new statistics)
+	if ((frame_period != frame_period_ticks()) || frame_clear_request) {
+		frame_sched_reset();
+	}
+
+	now = task_tick_get_32();
+	remaining = (int32_t) (frame_deadline - now);
+	if (remaining > 0) {
+		nano_task_timer_start(&frame_timer,remaining);
+		nano_task_timer_test(&frame_timer,TICKS_UNLIMITED);
+	} else {
+		// overrun: release now, and skip the other deadlines that have passed
+		r_frame_stats.overruns++;
+		missed = ((uint32_t) -remaining) / frame_period;
+		if (missed > 0) {
+			r_frame_stats.skipped += missed;
+			frame_deadline += missed * frame_period;
+			periods += missed;
+		}
+	}
+
+	// lateness of this release after its deadline
+	late = task_tick_get_32() - frame_deadline;
+	if ((int32_t) late > 0) {
+		late = ((late * 1000L) / sys_clock_ticks_per_sec) * 1000L;
+		if (late > r_frame_stats.late_max_us)
+			r_frame_stats.late_max_us = late;
+	}
+	frame_deadline += frame_period;
+
+	// measured period and its jitter
+	cycle = task_cycle_get_32();
+	if (frame_released) {
+		measured = cycle - frame_release_cycle;
+		hist_add(&r_frame_stats.period,measured);
+		if (measured > (r_frame_stats.period_cycles * periods))
+			hist_add(&r_frame_stats.jitter,measured - (r_frame_stats.period_cycles * periods));
+		else
+			hist_add(&r_frame_stats.jitter,(r_frame_stats.period_cycles * periods) - measured);
+	}
+	frame_release_cycle = cycle;
+	frame_released = true;
+
+	r_frame_stats.frames++;
+	return periods;
+}
+
+/*
+ * frame_physics_step : set the physics time step for this frame (the catch-up policy)
+ *
+ */
+
+void frame_physics_step(uint32_t periods) {
+	if (0 == periods) {
+		periods = 1;
+	} else if (periods > FRAME_CATCHUP_MAX) {
+		r_frame_stats.dt_capped++;
+		periods = FRAME_CATCHUP_MAX;
+	}
+	r_game.frame_dt_ms = periods * r_game.frame_ms;
+	r_game.game_time_ms += r_game.frame_dt_ms;
+}
+
+/*
+ * frame_report : display the frame scheduling statistics
+ *
+ */
+
+void frame_report() {
+	struct ROCKET_HIST_S *period = &r_frame_stats.period;
+	struct ROCKET_HIST_S *jitter = &r_frame_stats.jitter;
+
+	if (0 == period->count)
+		return;
+
+	PRINT("*** Sched(%d frames): overruns=%d skipped=%d capped=%d late_max=%d uSec\n",
+		r_frame_stats.frames,
+		r_frame_stats.overruns,
+		r_frame_stats.skipped,
+		r_frame_stats.dt_capped,
+		r_frame_stats.late_max_us);
+	PRINT("***   period(uSec) min=%d ave=%d max=%d, jitter(uSec) ave=%d p99=%d max=%d\n",
+		hist_cycles2usec(period->min),
+		hist_cycles2usec(hist_mean(period)),
+		hist_cycles2usec(period->max),
+		hist_cycles2usec(hist_mean(jitter)),
+		hist_cycles2usec(hist_percentile(jitter,99)),
+		hist_cycles2usec(jitter->max));
+}
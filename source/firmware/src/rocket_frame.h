@@ -0,0 +1,45 @@
+/* rocket_frame.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/* Catch-up policy: after an overrun, physics integrates the real elapsed time
+ * up to this many frame periods; any time beyond that is dropped, so that the
+ * game slows down rather than jumps */
+#define FRAME_CATCHUP_MAX	2
+
+struct ROCKET_FRAME_STATS_S {
+	uint32_t frames;			// frames released
+	uint32_t overruns;			// frames whose deadline had passed before the wait began
+	uint32_t skipped;			// whole frame periods dropped after overruns
+	uint32_t dt_capped;			// physics steps capped at FRAME_CATCHUP_MAX periods
+	uint32_t late_max_us;		// worst release time after its deadline
+	uint32_t period_cycles;		// nominal frame period (cycles) for the jitter
+	struct ROCKET_HIST_S period;	// measured release to release period (cycles)
+	struct ROCKET_HIST_S jitter;	// distance of the measured period from the nominal (cycles)
+};
+
+extern struct ROCKET_FRAME_STATS_S r_frame_stats;
+
+void frame_sched_init();
+void frame_sched_clear();
+uint32_t frame_sched_wait();
+void frame_physics_step(uint32_t periods);
+void frame_report();
@@ -0,0 +1,93 @@
+/* rocket_hist.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Theory of Implementation
+ *  - A small fixed-size histogram for timing measurements (in cycles)
+ *  - Adding a sample is a handful of instructions, so that it can be used in
+ *    the frame path and in callbacks without disturbing the timing
+ *  - Percentiles are estimated as the upper bound of the log2 bucket that
+ *    holds the requested rank, clipped to the observed maximum
+ */
+
+#include <zephyr.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_hist.h"
+
+
+void hist_reset(struct ROCKET_HIST_S *hist) {
+	memset(hist,0,sizeof(struct ROCKET_HIST_S));
+	hist->min = 0xffffffff;
+}
+
+void hist_add(struct ROCKET_HIST_S *hist, uint32_t value) {
+	uint8_t bucket = (0 == value) ? 0 : (32 - __builtin_clz(value));
+
+	hist->count++;
+	hist->sum += value;
+	if (value < hist->min) hist->min = value;
+	if (value > hist->max) hist->max = value;
+	if (hist->bucket[bucket] < 0xffffffff)
+		hist->bucket[bucket]++;
+}
+
+uint32_t hist_mean(struct ROCKET_HIST_S *hist) {
+	if (0 == hist->count)
+		return 0;
+	return (uint32_t) (hist->sum / hist->count);
+}
+
+uint32_t hist_percentile(struct ROCKET_HIST_S *hist, uint32_t percent) {
+	uint64_t total=0,rank,seen=0;
+	uint32_t limit;
+	uint8_t i;
+
+	for (i=0;i<HIST_BUCKET_MAX;i++) total += hist->bucket[i];
+	if (0 == total)
+		return 0;
+
+	// the rank of the sample at this percentile (rounded up)
+	rank = ((total * percent) + 99) / 100;
+	for (i=0;i<HIST_BUCKET_MAX;i++) {
+		seen += hist->bucket[i];
+		if (seen >= rank)
+			break;
+	}
+
+	// upper bound of this bucket, clipped to the largest sample seen
+	if (0 == i)
+		return 0;
+	limit = (i >= 32) ? 0xffffffff : ((1UL << i) - 1);
+	return (limit < hist->max) ? limit : hist->max;
+}
+
+uint32_t hist_cycles2usec(uint32_t cycles) {
+	uint32_t cycles_per_usec = sys_clock_hw_cycles_per_sec / 1000000;
+
+	if (0 == cycles_per_usec)
+		return cycles;
+	return cycles / cycles_per_usec;
+}
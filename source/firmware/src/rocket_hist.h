@@ -0,0 +1,42 @@
+/* rocket_hist.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Timing histogram: min/max/sum plus log2 buckets, where bucket 'n' counts
+ * the values in [2^(n-1) .. 2^n), so that percentiles are cheap to estimate
+ */
+
+#define HIST_BUCKET_MAX	33		// zero, plus one bucket per bit of a 32-bit value
+
+struct ROCKET_HIST_S {
+	uint32_t count;					// number of samples
+	uint32_t min;					// smallest sample
+	uint32_t max;					// largest sample
+	uint64_t sum;					// sum of samples (for the mean)
+	uint32_t bucket[HIST_BUCKET_MAX];	// log2 buckets (as wide as the count)
+};
+
+void hist_reset(struct ROCKET_HIST_S *hist);
+void hist_add(struct ROCKET_HIST_S *hist, uint32_t value);
+uint32_t hist_mean(struct ROCKET_HIST_S *hist);
+uint32_t hist_percentile(struct ROCKET_HIST_S *hist, uint32_t percent);
+uint32_t hist_cycles2usec(uint32_t cycles);
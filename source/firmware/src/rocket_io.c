@@ -0,0 +1,667 @@
+/* rocket_io.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - The frame is split across three tasks (see prj.mdef), by priority:
+ *      INPUT  : releases the frames at their deadlines (see rocket_frame.c), with a
+ *               snapshot of the buttons and the ADC
+ *      MAIN   : the physics task, runs the state machine and queues the bus traffic
+ *      OUTPUT : performs the queued i2c transactions, motors first
+ *  - The input task samples into the back half of a double buffer and then flips it,
+ *    so the physics task always copies a complete snapshot. The button presses are
+ *    not sampled per frame, they are queued as edges (see rocket_button.c).
+ *  - The physics task queues its bus traffic from a fixed pool of requests, into one
+ *    nanokernel FIFO per priority. The output task always drains the motor queue
+ *    before the display queue, so a motor command waits for at most one display
+ *    transaction. The last few requests of the pool are held back for the motors.
+ *  - A full queue drops the (display) request rather than stall the physics task.
+ *  - Each request may name a completion callback, called by the output task with the
+ *    result. A read names a future, which the caller polls (or waits on with a
+ *    timeout), so the physics task can use the last completed answer.
+ *  - A device whose transactions fail IO_DEVICE_FAIL_MAX times in a row is marked
+ *    dead, and its requests are completed immediately as failed, until it is retried
+ *    after a backoff that doubles on each failed retry. A missing slave thus costs one
+ *    failed transaction per backoff rather than hanging the frame loop.
+ *  - A transaction that succeeds is never a failure. Its time is measured by the
+ *    output task, which every other task preempts, so one slower than the device's
+ *    timeout is only counted as late.
+ *  - The physics task publishes a double-buffered snapshot of r_space at the end of
+ *    the frame, from which the output task points the antenna.
+ *  - All tasks share the i2c bus through the I2CBUS mutex. The state transitions
+ *    queue their LCD and LED backpack set up as requests (IO_OUT_LCD_INIT, ...).
+ *    The direct users in the running game (the LED blink, the button poll, the
+ *    local pan/tilt) only wait IO_BUS_WAIT_MS for it, and otherwise skip that update.
+ *  - Before io_start() (and when IO_TASKS_ENABLE is false) requests are performed
+ *    immediately, in order, by the calling task.
+ */
+
+#include <zephyr.h>
+
+#include <i2c.h>
+#include <atomic.h>
+#include "groveLCDUtils.h"
+#include "groveLCD.h"
+#include "Adafruit_LEDBackpack.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_space.h"
+#include "rocket_math.h"
+#include "rocket_lcd.h"
+#include "rocket_io.h"
+#include "rocket_hist.h"
+#include "rocket_frame.h"
+#include "rocket_profile.h"
+#include "rocket_log.h"
+
+
+struct ROCKET_IO_STATS_S r_io_stats;
+
+static bool io_started = false;
+
+/* input to physics: double buffered control snapshot */
+static struct ROCKET_CONTROL_S io_control[2];
+static volatile uint8_t io_control_front = 0;
+static atomic_t io_frame_periods;
+
+/* physics to output: double buffered space snapshot */
+static struct ROCKET_SPACE_S io_space[2];
+static volatile uint8_t io_space_front = 0;
+static volatile uint32_t io_space_seq = 0;
+
+/* physics to output: request queues and their free pool */
+static struct IO_OUT_S io_out_pool[IO_OUT_ITEM_MAX];
+static struct IO_OUT_S io_out_now;
+static struct nano_fifo io_out_free;
+static struct nano_fifo io_out_queue[IO_PRIO_MAX];
+static struct nano_sem io_out_ready;
+static atomic_t io_out_free_count;
+static atomic_t io_out_depth[IO_PRIO_MAX];
+
+/* per device health, in the order of the report */
+static struct IO_DEVICE_S io_devices[] = {
+	{ROCKET_MOTOR_I2C_ADDRESS,   "Motor",    20},
+	{ROCKET_DISPLAY_I2C_ADDRESS, "Display",  10},
+	{GROVE_LCD_I2C_ADDRESS,      "LCD",      20},
+	{GROVE_RGB_I2C_ADDRESS,      "LCD_RGB",  5},
+	{LED_BACKPACK_I2C_ADDRESS,   "Backpack", 5},
+};
+#define IO_DEVICE_MAX (sizeof(io_devices)/sizeof(struct IO_DEVICE_S))
+
+/*
+ * io_init : prepare the snapshots and the output pool (before the tasks start)
+ *
+ */
+
+void io_init() {
+	uint8_t i;
+
+	memset(&r_io_stats,0,sizeof(r_io_stats));
+
+	memcpy(&io_control[0],&r_control,sizeof(r_control));
+	memcpy(&io_control[1],&r_control,sizeof(r_control));
+	io_control_front = 0;
+	atomic_set(&io_frame_periods,0);
+
+	io_space_front = 0;
+	io_space_seq = 0;
+
+	nano_fifo_init(&io_out_free);
+	for (i=0;i<IO_PRIO_MAX;i++) {
+		nano_fifo_init(&io_out_queue[i]);
+		atomic_set(&io_out_depth[i],0);
+	}
+	nano_sem_init(&io_out_ready);
+	for (i=0;i<IO_OUT_ITEM_MAX;i++) {
+		nano_task_fifo_put(&io_out_free,&io_out_pool[i]);
+	}
+	atomic_set(&io_out_free_count,IO_OUT_ITEM_MAX);
+
+	for (i=0;i<IO_DEVICE_MAX;i++) {
+		io_devices[i].fails = 0;
+		io_devices[i].dead = false;
+		io_devices[i].backoff_ms = IO_DEVICE_BACKOFF_MS;
+		io_devices[i].sent = 0;
+		io_devices[i].errors = 0;
+		io_devices[i].late = 0;
+		io_devices[i].skipped = 0;
+		io_devices[i].time_max_us = 0;
+	}
+}
+
+/*
+ * io_start : start the input and output tasks
+ *
+ */
+
+void io_start() {
+	if (IO_TASKS_ENABLE) {
+		io_started = true;
+		task_group_start(PIPE);
+	}
+}
+
+/*
+ * io_bus_lock, io_bus_unlock : serialize the i2c bus between the tasks
+ *
+ */
+
+void io_bus_lock() {
+	if (IO_TASKS_ENABLE) {
+		task_mutex_lock(I2CBUS,TICKS_UNLIMITED);
+	}
+}
+
+/*
+ * io_bus_trylock : as io_bus_lock, but give up after IO_BUS_WAIT_MS, return false if so
+ *
+ *  For the per frame bus users, which skip their work for the frame rather than
+ *  wait behind a long queued transaction
+ *
+ */
+
+bool io_bus_trylock() {
+	if (IO_TASKS_ENABLE) {
+		return (RC_OK == task_mutex_lock(I2CBUS,IO_BUS_WAIT_TICKS));
+	}
+	return true;
+}
+
+void io_bus_unlock() {
+	if (IO_TASKS_ENABLE) {
+		task_mutex_unlock(I2CBUS);
+	}
+}
+
+/*
+ * io_frame_wait : physics task waits for the input task to release the next frame
+ *
+ *  Returns the frame periods since the previous frame, including those the
+ *  input task skipped and those released while the physics task was busy
+ *
+ */
+
+uint32_t io_frame_wait() {
+	task_sem_take(FRAMEREADY,TICKS_UNLIMITED);
+
+	// frames released while we were busy are skipped, the snapshot is the latest
+	while (RC_OK == task_sem_take(FRAMEREADY,TICKS_NONE)) {
+		r_io_stats.frames_late++;
+	}
+
+	return atomic_set(&io_frame_periods,0);
+}
+
+/*
+ * io_control_fetch : copy the latest input snapshot (the physics task owns r_control)
+ *
+ */
+
+void io_control_fetch(struct ROCKET_CONTROL_S *control) {
+	struct ROCKET_CONTROL_S *front = &io_control[io_control_front];
+
+	control->button_a = front->button_a;
+	control->button_b = front->button_b;
+	control->analog_x = front->analog_x;
+	control->analog_y = front->analog_y;
+	control->analog_z = front->analog_z;
+}
+
+/*
+ * io_space_publish : hand the frame's rocket state to the output task
+ *
+ */
+
+void io_space_publish(struct ROCKET_SPACE_S *space) {
+	uint8_t back = 1 - io_space_front;
+
+	memcpy(&io_space[back],space,sizeof(struct ROCKET_SPACE_S));
+	io_space_front = back;
+	io_space_seq++;
+}
+
+/*
+ * io_device_find : return the health record for an i2c address
+ *
+ */
+
+static struct IO_DEVICE_S *io_device_find(uint8_t addr) {
+	uint8_t i;
+
+	for (i=0;i<IO_DEVICE_MAX;i++) {
+		if (addr == io_devices[i].addr)
+			return &io_devices[i];
+	}
+	return NULL;
+}
+
+/*
+ * io_device_ready : false if the device is dead and not yet due for a retry
+ *
+ */
+
+static bool io_device_ready(struct IO_DEVICE_S *device) {
+	if ((NULL == device) || !device->dead)
+		return true;
+
+	if ((int32_t) (task_tick_get_32() - device->retry_tick) >= 0)
+		return true;
+
+	device->skipped++;
+	return false;
+}
+
+/*
+ * io_device_result : update the device's health from a transaction's result and time
+ *
+ */
+
+static void io_device_result(struct IO_DEVICE_S *device, int32_t rc, uint32_t time_us) {
+	if (NULL == device)
+		return;
+
+	if (time_us > device->time_max_us)
+		device->time_max_us = time_us;
+
+	if (DEV_OK == rc) {
+		device->sent++;
+		if (time_us > ((uint32_t) device->timeout_ms * 1000))
+			device->late++;
+		if (device->dead) {
+			RLOG_ERR(LOG_F_IO_DEVICE,device->name,device->addr,"recovered",0);
+		}
+		device->fails = 0;
+		device->dead = false;
+		device->backoff_ms = IO_DEVICE_BACKOFF_MS;
+		return;
+	}
+
+	device->errors++;
+
+	if (device->dead) {
+		// the retry failed, wait longer for the next one
+		if (device->backoff_ms < (IO_DEVICE_BACKOFF_MAX_MS/2))
+			device->backoff_ms *= 2;
+		else
+			device->backoff_ms = IO_DEVICE_BACKOFF_MAX_MS;
+	} else if (++device->fails >= IO_DEVICE_FAIL_MAX) {
+		device->dead = true;
+		RLOG_ERR(LOG_F_IO_DEVICE,device->name,device->addr,"not responding",device->backoff_ms);
+	}
+	device->retry_tick = task_tick_get_32() + ((device->backoff_ms * sys_clock_ticks_per_sec) / 1000);
+}
+
+/*
+ * io_out_do : perform an output request, then report its result
+ *
+ */
+
+static void io_out_do(struct IO_OUT_S *item) {
+	struct IO_DEVICE_S *device = io_device_find(item->addr);
+	uint32_t time_start,time_us;
+	int32_t rc = DEV_OK;
+
+	if (!io_device_ready(device)) {
+		rc = DEV_NO_RESPONSE;
+	} else {
+		io_bus_lock();
+		time_start = task_cycle_get_32();
+		if        (IO_OUT_I2C == item->type) {
+			if (IO_I2C_INTERRUPT_ENABLE && io_started)
+				rc = i2c_write(i2c, item->buf, item->len, item->addr);
+			else
+				rc = i2c_polling_write(i2c, item->buf, item->len, item->addr);
+		} else if (IO_OUT_I2C_READ == item->type) {
+			if (IO_I2C_INTERRUPT_ENABLE && io_started)
+				rc = i2c_read(i2c, item->buf, item->len, item->addr);
+			else
+				rc = i2c_polling_read(i2c, item->buf, item->len, item->addr);
+		} else if (IO_OUT_BACKPACK == item->type) {
+			seg_writeNumber(item->value);
+		} else if (IO_OUT_LCD_COLOR == item->type) {
+			groveLcdColorSet(i2c, item->buf[0], item->buf[1], item->buf[2]);
+		} else if (IO_OUT_LCD_INIT == item->type) {
+			groveLcdInit(i2c);
+		} else if (IO_OUT_LCD_CURSOR == item->type) {
+			groveLcdCursor(i2c, item->value & 0x1);
+			groveLcdBlink(i2c, (item->value >> 1) & 0x1);
+		} else if (IO_OUT_BACKPACK_INIT == item->type) {
+			bp_setdevice(i2c);
+			bp_begin();
+			bp_clear();
+		} else if (IO_OUT_BACKPACK_DIGITS == item->type) {
+			seg_writeDigitNum(0, (item->value >> 24) & 0xff, 0);
+			seg_writeDigitNum(1, (item->value >> 16) & 0xff, 0);
+			seg_writeDigitNum(3, (item->value >>  8) & 0xff, 0);
+			seg_writeDigitNum(4, (item->value      ) & 0xff, 0);
+			bp_writeDisplay();
+		}
+		time_us = (task_cycle_get_32() - time_start) / (sys_clock_hw_cycles_per_sec / 1000000);
+		prof_stop(PROF_BUS,time_start);
+		io_bus_unlock();
+
+		io_device_result(device, rc, time_us);
+	}
+
+	if (DEV_OK != rc) {
+		r_io_stats.out_errors++;
+	} else {
+		r_io_stats.out_sent++;
+	}
+
+	if (NULL != item->future) {
+		item->future->rc = rc;
+		item->future->len = item->len;
+		memcpy(item->future->buf,item->buf,item->len);
+		item->future->pending = false;
+		nano_task_sem_give(&item->future->done);
+	}
+	if (NULL != item->on_done)
+		(*item->on_done)(rc);
+}
+
+/*
+ * io_out_get, io_out_put : get an empty request, then queue (or perform) it
+ *
+ */
+
+static struct IO_OUT_S *io_out_get(uint8_t prio) {
+	struct IO_OUT_S *item;
+
+	if (!IO_TASKS_ENABLE || !io_started) {
+		item = &io_out_now;
+	} else {
+		// the last requests in the pool are kept for the motors
+		if ((IO_PRIO_MOTOR != prio) && (atomic_get(&io_out_free_count) <= IO_OUT_MOTOR_RESERVE))
+			item = NULL;
+		else
+			item = nano_task_fifo_get(&io_out_free,TICKS_NONE);
+
+		if (NULL == item) {
+			r_io_stats.out_dropped++;
+			return NULL;
+		}
+		atomic_dec(&io_out_free_count);
+	}
+
+	item->prio = prio;
+	item->addr = 0;
+	item->on_done = NULL;
+	item->future = NULL;
+	return item;
+}
+
+static void io_out_put(struct IO_OUT_S *item) {
+	uint32_t depth;
+
+	if (&io_out_now == item) {
+		io_out_do(item);
+		return;
+	}
+
+	depth = atomic_inc(&io_out_depth[item->prio]) + 1;
+	if (depth > r_io_stats.out_depth_max[item->prio])
+		r_io_stats.out_depth_max[item->prio] = depth;
+	nano_task_fifo_put(&io_out_queue[item->prio],item);
+	nano_task_sem_give(&io_out_ready);
+}
+
+/*
+ * io_out_i2c : queue an i2c write, return false if it was dropped
+ *
+ */
+
+bool io_out_i2c(uint8_t addr, uint8_t *buf, uint16_t len, uint8_t prio, io_done_t on_done) {
+	struct IO_OUT_S *item;
+
+	if (len > IO_OUT_BUF_MAX)
+		return false;
+
+	item = io_out_get(prio);
+	if (NULL == item)
+		return false;
+
+	item->type = IO_OUT_I2C;
+	item->addr = addr;
+	item->len = len;
+	item->on_done = on_done;
+	memcpy(item->buf,buf,len);
+	io_out_put(item);
+	return true;
+}
+
+/*
+ * io_out_device : queue a device operation with a value, return false if it was dropped
+ *
+ */
+
+static bool io_out_device(uint8_t type, uint8_t addr, uint32_t value) {
+	struct IO_OUT_S *item = io_out_get(IO_PRIO_DISPLAY);
+
+	if (NULL == item)
+		return false;
+
+	item->type = type;
+	item->addr = addr;
+	item->value = value;
+	io_out_put(item);
+	return true;
+}
+
+/*
+ * io_out_value : queue a value for a display device, return false if it was dropped
+ *
+ */
+
+bool io_out_value(uint8_t type, uint32_t value) {
+	return io_out_device(type, LED_BACKPACK_I2C_ADDRESS, value);
+}
+
+/*
+ * io_lcd_init, io_lcd_cursor : queue an LCD (re)initialization, or a cursor change
+ *
+ *  The state transitions use these rather than wait for the bus themselves
+ *
+ */
+
+void io_lcd_init() {
+	io_out_device(IO_OUT_LCD_INIT, GROVE_LCD_I2C_ADDRESS, 0);
+}
+
+void io_lcd_cursor(bool cursor, bool blink) {
+	io_out_device(IO_OUT_LCD_CURSOR, GROVE_LCD_I2C_ADDRESS, (cursor ? 0x1 : 0) | (blink ? 0x2 : 0));
+}
+
+/*
+ * io_lcd_color : queue an LCD backlight color change
+ *
+ */
+
+void io_lcd_color(uint8_t r, uint8_t g, uint8_t b) {
+	struct IO_OUT_S *item = io_out_get(IO_PRIO_DISPLAY);
+
+	if (NULL == item)
+		return;
+
+	item->type = IO_OUT_LCD_COLOR;
+	item->addr = GROVE_RGB_I2C_ADDRESS;
+	item->buf[0] = r;
+	item->buf[1] = g;
+	item->buf[2] = b;
+	io_out_put(item);
+}
+
+/*
+ * io_future_init : prepare a future for its first read
+ *
+ */
+
+void io_future_init(struct IO_FUTURE_S *future) {
+	nano_sem_init(&future->done);
+	future->pending = false;
+	future->rc = DEV_OK;
+	future->len = 0;
+}
+
+/*
+ * io_in_i2c : queue an i2c read into the future, return false if it was not queued
+ *
+ *  A future whose previous read is still pending is not reused. A read that cannot
+ *  be queued completes the future at once, as failed
+ *
+ */
+
+bool io_in_i2c(uint8_t addr, uint16_t len, uint8_t prio, struct IO_FUTURE_S *future) {
+	struct IO_OUT_S *item;
+
+	if (future->pending)
+		return false;
+
+	// a read that is not queued fails, rather than leave the previous result standing
+	item = NULL;
+	if (len <= IO_FUTURE_BUF_MAX)
+		item = io_out_get(prio);
+	if (NULL == item) {
+		future->rc = DEV_FAIL;
+		future->len = 0;
+		return false;
+	}
+
+	// discard the signal of any earlier result that was not waited for
+	while (nano_task_sem_take(&future->done,TICKS_NONE)) ;
+	future->pending = true;
+
+	item->type = IO_OUT_I2C_READ;
+	item->addr = addr;
+	item->len = len;
+	item->future = future;
+	io_out_put(item);
+	return true;
+}
+
+/*
+ * io_future_wait : wait for a queued read, return its result (DEV_NO_RESPONSE on timeout)
+ *
+ */
+
+int32_t io_future_wait(struct IO_FUTURE_S *future, int32_t ticks) {
+	if (future->pending && !nano_task_sem_take(&future->done,ticks)) {
+		r_io_stats.future_timeouts++;
+		return DEV_NO_RESPONSE;
+	}
+	return future->rc;
+}
+
+/*
+ * io_report : display the pipeline statistics and the device health
+ *
+ */
+
+void io_report() {
+	uint8_t i;
+
+	if (!IO_TASKS_ENABLE)
+		return;
+
+	PRINT("*** I/O(%d frames, %d late): out sent=%d dropped=%d errors=%d depth_max=%d/%d futures_late=%d\n",
+		r_io_stats.frames,
+		r_io_stats.frames_late,
+		r_io_stats.out_sent,
+		r_io_stats.out_dropped,
+		r_io_stats.out_errors,
+		r_io_stats.out_depth_max[IO_PRIO_MOTOR],
+		r_io_stats.out_depth_max[IO_PRIO_DISPLAY],
+		r_io_stats.future_timeouts);
+
+	for (i=0;i<IO_DEVICE_MAX;i++) {
+		PRINT("***   %-8s(0x%02x): sent=%d errors=%d late=%d skipped=%d max=%d uSec%s\n",
+			io_devices[i].name,
+			io_devices[i].addr,
+			io_devices[i].sent,
+			io_devices[i].errors,
+			io_devices[i].late,
+			io_devices[i].skipped,
+			io_devices[i].time_max_us,
+			io_devices[i].dead ? " DEAD" : "");
+	}
+	PRINT("***   motor commands lost=%d resyncs=%d\n",
+		r_motor_status.sends_lost,
+		r_motor_status.resyncs);
+}
+
+/*
+ * rocket_input_task : high priority task that samples the controls and paces the frames
+ *
+ */
+
+void rocket_input_task() {
+	uint32_t periods;
+	uint8_t back;
+
+	while (1) {
+		// wait for the frame deadline (see rocket_frame.c)
+		periods = frame_sched_wait();
+
+		// sample into the back buffer
+		back = 1 - io_control_front;
+		scan_controls(&io_control[back]);
+
+		// publish the snapshot and release the frame
+		io_control_front = back;
+		r_io_stats.frames++;
+		atomic_add(&io_frame_periods,periods);
+		task_sem_give(FRAMEREADY);
+	}
+}
+
+/*
+ * rocket_output_task : low priority task that performs the queued requests, highest priority first
+ *
+ */
+
+void rocket_output_task() {
+	struct IO_OUT_S *item;
+	uint32_t space_seq = 0;
+	uint8_t prio;
+
+	while (1) {
+		if (nano_task_sem_take(&io_out_ready,IO_OUT_IDLE_TICKS)) {
+			for (prio=0,item=NULL;(prio<IO_PRIO_MAX) && (NULL == item);prio++) {
+				item = nano_task_fifo_get(&io_out_queue[prio],TICKS_NONE);
+			}
+			if (NULL != item) {
+				atomic_dec(&io_out_depth[item->prio]);
+				io_out_do(item);
+				nano_task_fifo_put(&io_out_free,item);
+				atomic_inc(&io_out_free_count);
+			}
+		}
+
+		// follow the latest published rocket position with the antenna
+		if (IO_TRACKER_FOLLOW_ENABLE && (space_seq != io_space_seq)) {
+			space_seq = io_space_seq;
+			antenna_update_space(&io_space[io_space_front]);
+		}
+	}
+}
@@ -0,0 +1,130 @@
+/* rocket_io.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/* Output queue sizing */
+#define IO_OUT_ITEM_MAX		16		// queued output requests
+#define IO_OUT_MOTOR_RESERVE 4		// requests held back from the pool for the motor commands
+#define IO_OUT_BUF_MAX		128		// largest transaction (a full LCD redraw, LCD_FB_BUFFER_MAX)
+#define IO_OUT_IDLE_TICKS	2		// output task wakeup when idle, to follow the rocket with the antenna
+
+/* Output request priorities (queues are drained highest first) */
+#define IO_PRIO_MOTOR		0		// motor commands and queries
+#define IO_PRIO_DISPLAY		1		// cosmetic LCD, LED, and satellite display updates
+#define IO_PRIO_MAX			2
+
+/* Output request types */
+#define IO_OUT_I2C			0		// raw i2c write to 'addr'
+#define IO_OUT_BACKPACK		1		// LED backpack number in 'value'
+#define IO_OUT_LCD_COLOR	2		// LCD backlight color in 'buf[0..2]'
+#define IO_OUT_I2C_READ		3		// raw i2c read of 'len' bytes from 'addr', into the future
+#define IO_OUT_LCD_INIT		4		// re-initialize the LCD controller
+#define IO_OUT_LCD_CURSOR	5		// LCD cursor (bit 0) and blink (bit 1) in 'value'
+#define IO_OUT_BACKPACK_INIT	6	// set up and clear the LED backpack
+#define IO_OUT_BACKPACK_DIGITS	7	// LED backpack digit codes 0,1,3,4 in the bytes of 'value' (MSB first)
+
+/* Dead device detection */
+#define IO_DEVICE_FAIL_MAX		3		// consecutive failed transactions before a device is dead
+#define IO_DEVICE_BACKOFF_MS	500		// first wait before a dead device is tried again
+#define IO_DEVICE_BACKOFF_MAX_MS 8000	// the wait doubles on each failed retry, up to this limit
+
+/* Futures for queued reads */
+#define IO_FUTURE_BUF_MAX	32		// largest queued read (the motor board status frame)
+
+/* Direct bus users */
+#define IO_BUS_WAIT_MS		2		// how long a per frame bus user waits for the bus
+#define IO_BUS_WAIT_TICKS	((IO_BUS_WAIT_MS * sys_clock_ticks_per_sec / 1000) + 1)
+
+/* Completion callback, given the transaction's result (DEV_OK, ...) */
+typedef void (*io_done_t)(int32_t rc);
+
+struct IO_FUTURE_S {
+	struct nano_sem done;		// given when the result is ready
+	volatile bool pending;		// a read is queued and not yet complete
+	int32_t  rc;				// result of the read
+	uint16_t len;				// bytes read
+	uint8_t  buf[IO_FUTURE_BUF_MAX];
+};
+
+struct IO_OUT_S {
+	void *fifo_reserved;		// first word is used by the nanokernel FIFO
+	uint8_t  type;				// request type
+	uint8_t  prio;				// request priority
+	uint8_t  addr;				// i2c address
+	uint16_t len;				// i2c length
+	uint32_t value;				// request value
+	io_done_t on_done;			// called when the transaction completes (or fails)
+	struct IO_FUTURE_S *future;	// result of a read
+	uint8_t  buf[IO_OUT_BUF_MAX];
+};
+
+struct IO_DEVICE_S {
+	uint8_t  addr;				// i2c address
+	char    *name;
+	uint16_t timeout_ms;		// a transaction slower than this counts as late (not a failure)
+	uint8_t  fails;				// consecutive failures
+	bool     dead;				// skip this device until 'retry_tick'
+	uint16_t backoff_ms;		// current wait before a retry
+	uint32_t retry_tick;		// when a dead device is tried again
+	uint32_t sent;				// transactions completed
+	uint32_t errors;			// transactions failed by the driver
+	uint32_t late;				// transactions slower than the timeout
+	uint32_t skipped;			// transactions skipped while the device was dead
+	uint32_t time_max_us;		// slowest transaction
+};
+
+struct ROCKET_IO_STATS_S {
+	uint32_t frames;			// frames released by the input task
+	uint32_t frames_late;		// frames released while the physics task was still busy
+	uint32_t out_sent;			// output requests completed
+	uint32_t out_dropped;		// output requests dropped for a full queue
+	uint32_t out_errors;		// output requests that failed
+	uint32_t out_depth_max[IO_PRIO_MAX];	// deepest output queue seen, per priority
+	uint32_t future_timeouts;	// readers that gave up waiting for their result
+};
+
+extern struct ROCKET_IO_STATS_S r_io_stats;
+
+void io_init();
+void io_start();
+
+void io_bus_lock();
+void io_bus_unlock();
+bool io_bus_trylock();
+
+uint32_t io_frame_wait();
+void io_control_fetch(struct ROCKET_CONTROL_S *control);
+void io_space_publish(struct ROCKET_SPACE_S *space);
+
+bool io_out_i2c(uint8_t addr, uint8_t *buf, uint16_t len, uint8_t prio, io_done_t on_done);
+bool io_out_value(uint8_t type, uint32_t value);
+void io_lcd_color(uint8_t r, uint8_t g, uint8_t b);
+void io_lcd_init();
+void io_lcd_cursor(bool cursor, bool blink);
+
+void io_future_init(struct IO_FUTURE_S *future);
+bool io_in_i2c(uint8_t addr, uint16_t len, uint8_t prio, struct IO_FUTURE_S *future);
+int32_t io_future_wait(struct IO_FUTURE_S *future, int32_t ticks);
+
+void io_report();
+
+void rocket_input_task();
+void rocket_output_task();
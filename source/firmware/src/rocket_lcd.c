@@ -0,0 +1,237 @@
+/* rocket_lcd.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Theory of Implementation
+ *  - The states compose the LCD text into a framebuffer during the frame
+ *  - A shadow copy holds what the panel is currently showing
+ *  - At the end of the frame, lcd_fb_flush() compares the two and sends only
+ *    the changed character runs, each preceded by a cursor move, all batched
+ *    into one i2c transaction using the controller's 'Co' continuation bit
+ *  - Runs separated by a single unchanged character are merged, since resending
+ *    that character costs no more than another cursor move
+ *  - If the panel is reset (e.g. groveLcdInit) the shadow is invalidated, which
+ *    forces a full redraw on the next flush
+ *  - The transaction is handed to the output task (see rocket_io.c), which
+ *    invalidates the shadow if the write fails
+ */
+
+#include <zephyr.h>
+
+#include <i2c.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_space.h"
+#include "rocket_lcd.h"
+#include "rocket_io.h"
+
+
+struct ROCKET_LCD_STATS_S r_lcd_stats;
+
+static char lcd_frame[LCD_ROW_MAX][LCD_COL_MAX];	// requested panel content
+static char lcd_shadow[LCD_ROW_MAX][LCD_COL_MAX];	// current panel content
+static uint8_t lcd_cursor_row = LCD_CURSOR_NONE;
+static uint8_t lcd_cursor_col = 0;
+static bool lcd_cursor_dirty = false;
+
+static uint8_t lcd_buf[LCD_FB_BUFFER_MAX];
+
+struct LCD_RUN_S {
+	uint8_t row;
+	uint8_t col;
+	uint8_t len;
+};
+
+/*
+ * lcd_fb_init : clear the framebuffer, mark the panel as unknown
+ *
+ */
+
+void lcd_fb_init() {
+	memset(lcd_frame,' ',sizeof(lcd_frame));
+	lcd_fb_invalidate();
+	lcd_cursor_row = LCD_CURSOR_NONE;
+	lcd_cursor_dirty = false;
+	memset(&r_lcd_stats,0,sizeof(r_lcd_stats));
+}
+
+/*
+ * lcd_fb_invalidate : the panel content is unknown, redraw it all on the next flush
+ *
+ */
+
+void lcd_fb_invalidate() {
+	memset(lcd_shadow,LCD_FB_UNKNOWN,sizeof(lcd_shadow));
+}
+
+/*
+ * lcd_fb_done : completion of a flush transaction
+ *
+ */
+
+static void lcd_fb_done(int32_t rc) {
+	// if the write failed, the panel content is unknown
+	if (DEV_OK != rc) {
+		lcd_fb_invalidate();
+	}
+}
+
+/*
+ * lcd_fb_write : place text into the framebuffer (clipped to the line)
+ *
+ */
+
+void lcd_fb_write(uint8_t row, uint8_t col, char *text, uint8_t len) {
+	if ((row >= LCD_ROW_MAX) || (col >= LCD_COL_MAX))
+		return;
+	if (len > (LCD_COL_MAX - col))
+		len = LCD_COL_MAX - col;
+	memcpy(&lcd_frame[row][col],text,len);
+}
+
+/*
+ * lcd_fb_line : place a full line into the framebuffer, space padded
+ *
+ */
+
+void lcd_fb_line(uint8_t row, char *text) {
+	uint8_t len = 0;
+
+	if (row >= LCD_ROW_MAX)
+		return;
+
+	while ((len < LCD_COL_MAX) && ('\0' != text[len])) len++;
+	memcpy(lcd_frame[row],text,len);
+	memset(&lcd_frame[row][len],' ',LCD_COL_MAX-len);
+
+	r_lcd_stats.bytes_legacy += LCD_LEGACY_LINE_BYTES;
+}
+
+/*
+ * lcd_fb_cursor : set the cursor position to restore after each flush
+ *
+ *  Use LCD_CURSOR_NONE for the row when the cursor is not shown
+ *
+ */
+
+void lcd_fb_cursor(uint8_t row, uint8_t col) {
+	lcd_cursor_row = row;
+	lcd_cursor_col = col;
+	lcd_cursor_dirty = (LCD_CURSOR_NONE != row);
+}
+
+/*
+ * lcd_fb_flush : send the changed character runs in one transaction
+ *
+ */
+
+void lcd_fb_flush() {
+	struct LCD_RUN_S run[LCD_ROW_MAX*LCD_COL_MAX];
+	uint8_t run_count=0;
+	uint8_t row,col,i,j;
+	uint32_t len=0;
+
+	r_lcd_stats.frames++;
+
+	// find the changed runs
+	for (row=0;row<LCD_ROW_MAX;row++) {
+		for (col=0;col<LCD_COL_MAX;col++) {
+			if (lcd_frame[row][col] == lcd_shadow[row][col])
+				continue;
+			if ((run_count > 0) &&
+				(run[run_count-1].row == row) &&
+				((col - (run[run_count-1].col + run[run_count-1].len)) <= LCD_FB_MERGE_GAP)) {
+				run[run_count-1].len = col - run[run_count-1].col + 1;
+			} else {
+				run[run_count].row = row;
+				run[run_count].col = col;
+				run[run_count].len = 1;
+				run_count++;
+			}
+		}
+	}
+
+	if ((0 == run_count) && !lcd_cursor_dirty)
+		return;
+
+	// batch the runs: cursor move then characters, the last item ends the transaction
+	for (i=0;i<run_count;i++) {
+		char *text = &lcd_frame[run[i].row][run[i].col];
+
+		lcd_buf[len++] = LCD_CONTROL_COMMAND;
+		lcd_buf[len++] = LCD_SET_DDRAM | ((run[i].row * LCD_ROW_OFFSET) + run[i].col);
+		if ((i == (run_count-1)) && (LCD_CURSOR_NONE == lcd_cursor_row)) {
+			lcd_buf[len++] = LCD_CONTROL_LAST_DATA;
+			memcpy(&lcd_buf[len],text,run[i].len);
+			len += run[i].len;
+		} else {
+			for (j=0;j<run[i].len;j++) {
+				lcd_buf[len++] = LCD_CONTROL_DATA;
+				lcd_buf[len++] = text[j];
+			}
+		}
+		memcpy(&lcd_shadow[run[i].row][run[i].col],text,run[i].len);
+	}
+
+	// restore the (blinking) cursor position
+	if (LCD_CURSOR_NONE != lcd_cursor_row) {
+		lcd_buf[len++] = LCD_CONTROL_LAST_COMMAND;
+		lcd_buf[len++] = LCD_SET_DDRAM | ((lcd_cursor_row * LCD_ROW_OFFSET) + lcd_cursor_col);
+	}
+	lcd_cursor_dirty = false;
+
+	if (IO_LCD_ENABLE) {
+		// queue the transaction for the output task; if it fails or is dropped,
+		// the panel state is unknown, so try again next frame
+		if (!io_out_i2c(GROVE_LCD_I2C_ADDRESS, lcd_buf, len, IO_PRIO_DISPLAY, lcd_fb_done)) {
+			lcd_fb_invalidate();
+		}
+	}
+
+	r_lcd_stats.frames_sent++;
+	r_lcd_stats.bytes_sent += len + 1;
+	if ((len + 1) > r_lcd_stats.bytes_max)
+		r_lcd_stats.bytes_max = len + 1;
+}
+
+/*
+ * lcd_fb_report : display the measured bus traffic per frame, framebuffer versus full refresh
+ *
+ *  Shown with the DEBUG_TIMING_ENABLE reports, by the Test > Timing state, and
+ *  at the end of a host run
+ *
+ */
+
+void lcd_fb_report() {
+	if (0 == r_lcd_stats.frames)
+		return;
+
+	PRINT("*** LCD(%d frames, %d sent): bytes/frame = %d, max %d (full refresh estimate = %d)\n",
+		r_lcd_stats.frames,
+		r_lcd_stats.frames_sent,
+		r_lcd_stats.bytes_sent / r_lcd_stats.frames,
+		r_lcd_stats.bytes_max,
+		r_lcd_stats.bytes_legacy / r_lcd_stats.frames);
+}
@@ -0,0 +1,63 @@
+/* rocket_lcd.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/* LCD geometry */
+#define LCD_ROW_MAX		2
+#define LCD_COL_MAX		LCD_DISPLAY_POS_MAX
+
+/* Grove LCD text controller (AIP31068 on the JHD1313 module) */
+#define GROVE_LCD_I2C_ADDRESS		0x3E
+#define LCD_CONTROL_COMMAND			0x80	// Co=1,RS=0: one command byte, then another control byte
+#define LCD_CONTROL_DATA			0xC0	// Co=1,RS=1: one data byte, then another control byte
+#define LCD_CONTROL_LAST_COMMAND	0x00	// Co=0,RS=0: command byte(s) to end of transaction
+#define LCD_CONTROL_LAST_DATA		0x40	// Co=0,RS=1: data byte(s) to end of transaction
+#define LCD_SET_DDRAM				0x80	// set the cursor (DDRAM) address
+#define LCD_ROW_OFFSET				0x40	// DDRAM address of the second row
+
+/* Framebuffer controls */
+#define LCD_FB_UNKNOWN		0xff	// shadow value for 'panel content unknown'
+#define LCD_FB_MERGE_GAP	1		// merge runs separated by this many unchanged characters
+#define LCD_FB_BUFFER_MAX	128		// worst case batch for a full 2x16 redraw plus cursor
+#define LCD_CURSOR_NONE		0xff	// no cursor to restore after a flush
+
+/* Cost of the previous full-line groveLcdPrint() refresh, for comparison:
+ * one cursor transaction plus one transaction per character, where each
+ * transaction is the address byte, the control byte, and the value */
+#define LCD_LEGACY_LINE_BYTES	(3 + (LCD_COL_MAX * 3))
+
+struct ROCKET_LCD_STATS_S {
+	uint32_t frames;		// number of flushes
+	uint32_t frames_sent;	// number of flushes that needed a bus transaction
+	uint32_t bytes_sent;	// bus bytes sent by the framebuffer (including address byte)
+	uint32_t bytes_max;		// largest transaction (including address byte)
+	uint32_t bytes_legacy;	// bus bytes the full-line refresh would have sent
+};
+
+extern struct ROCKET_LCD_STATS_S r_lcd_stats;
+
+void lcd_fb_init();
+void lcd_fb_invalidate();
+void lcd_fb_write(uint8_t row, uint8_t col, char *text, uint8_t len);
+void lcd_fb_line(uint8_t row, char *text);
+void lcd_fb_cursor(uint8_t row, uint8_t col);
+void lcd_fb_flush();
+void lcd_fb_report();
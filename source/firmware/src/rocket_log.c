@@ -0,0 +1,297 @@
+/* rocket_log.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Theory of Implementation
+ *  - Deferred binary logging: the frame path only records a format ID plus
+ *    raw arguments (and optionally a short text copy) into a ring buffer
+ *  - The ring is lock-free for many producers and one consumer: a producer
+ *    reserves a slot with a compare-and-swap of the head, only if the slot is
+ *    free, fills it, and then publishes it by writing the slot's sequence number
+ *    into 'ready'
+ *  - The low priority LOGGER task (see prj.mdef) formats and prints the
+ *    published entries, so the console never blocks the game loop
+ *  - If the ring is full the entry is dropped and counted, rather than
+ *    blocking the producer
+ *  - The RLOG_* macros have the compiler check each call's arguments against
+ *    its format. The arguments are recorded as intptr_t, so the drain task
+ *    prints each conversion on its own, with its argument cast back to the
+ *    type that the conversion expects (which also holds on 64 bit hosts)
+ *  - With DEBUG_LOG_DEFERRED false the entries are printed immediately
+ */
+
+#include <zephyr.h>
+#include <atomic.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_log.h"
+
+
+static const char *log_formats[LOG_F_MAX] = {
+	[LOG_F_TEXT]          = LOG_F_TEXT_FMT,
+	[LOG_F_NEW_STATE]     = LOG_F_NEW_STATE_FMT,
+	[LOG_F_STATE_TOP]     = LOG_F_STATE_TOP_FMT,
+	[LOG_F_STATE_LINE]    = LOG_F_STATE_LINE_FMT,
+	[LOG_F_STATE_BOTTOM]  = LOG_F_STATE_BOTTOM_FMT,
+	[LOG_F_STATE_KEYS]    = LOG_F_STATE_KEYS_FMT,
+	[LOG_F_SOUND]         = LOG_F_SOUND_FMT,
+	[LOG_F_FLIGHT_POS]    = LOG_F_FLIGHT_POS_FMT,
+	[LOG_F_FLIGHT_TOWERS] = LOG_F_FLIGHT_TOWERS_FMT,
+	[LOG_F_FLIGHT_ANGLES] = LOG_F_FLIGHT_ANGLES_FMT,
+	[LOG_F_IO_STATE]      = LOG_F_IO_STATE_FMT,
+	[LOG_F_IO_GPIO]       = LOG_F_IO_GPIO_FMT,
+	[LOG_F_TEST_SOUND]    = LOG_F_TEST_SOUND_FMT,
+	[LOG_F_TEST_LEDRGB]   = LOG_F_TEST_LEDRGB_FMT,
+	[LOG_F_TEST_ANTENNAE] = LOG_F_TEST_ANTENNAE_FMT,
+	[LOG_F_IO_DEVICE]     = LOG_F_IO_DEVICE_FMT,
+};
+
+static struct LOG_ENTRY_S log_ring[LOG_RING_MAX];
+static atomic_t log_head = 0;			// next slot to reserve (producers)
+static volatile uint32_t log_tail = 0;	// next slot to print (consumer)
+static atomic_t log_dropped = 0;		// entries lost to a full ring
+
+/*
+ * log_print_arg : print one conversion, with its argument cast back to the conversion's type
+ *
+ */
+
+static void log_print_arg(const char *spec, char conversion, bool is_long, intptr_t value) {
+	switch (conversion) {
+		case 'd' :
+		case 'i' :
+			if (is_long) PRINT(spec,(long) value); else PRINT(spec,(int) value);
+			break;
+		case 'u' :
+		case 'x' :
+		case 'X' :
+		case 'o' :
+			if (is_long) PRINT(spec,(unsigned long) value); else PRINT(spec,(unsigned int) value);
+			break;
+		case 'c' :
+			PRINT(spec,(int) value);
+			break;
+		case 's' :
+			PRINT(spec,(const char *) value);
+			break;
+		case 'p' :
+			PRINT(spec,(void *) value);
+			break;
+		default :
+			PRINT("%s",spec);
+	}
+}
+
+/*
+ * log_print : format one entry to the console, a conversion at a time
+ *
+ */
+
+static void log_print(struct LOG_ENTRY_S *entry) {
+	const char *format = "?";
+	char chunk[LOG_CHUNK_MAX+1];
+	char spec[LOG_SPEC_MAX+1];
+	uint8_t arg = 0;
+	uint8_t len;
+	bool is_long;
+	intptr_t value;
+
+	if (entry->format < LOG_F_MAX)
+		format = log_formats[entry->format];
+
+	while (*format) {
+		// literal text, up to the next conversion
+		if (('%' != *format) || ('%' == format[1])) {
+			len = 0;
+			while (*format && (len < LOG_CHUNK_MAX)) {
+				if ('%' == *format) {
+					if ('%' != format[1])
+						break;
+					format++;
+				}
+				chunk[len++] = *format++;
+			}
+			chunk[len] = '\0';
+			PRINT("%s",chunk);
+			continue;
+		}
+
+		// the conversion: flags, width and precision, length, and type
+		len = 0;
+		spec[len++] = *format++;
+		while (*format && strchr("-+ #0123456789.",*format) && (len < (LOG_SPEC_MAX-2)))
+			spec[len++] = *format++;
+		is_long = false;
+		while (('l' == *format) || ('h' == *format)) {
+			if ('l' == *format) is_long = true;
+			if (len < (LOG_SPEC_MAX-1)) spec[len++] = *format;
+			format++;
+		}
+		if ('\0' == *format)
+			break;
+		spec[len++] = *format;
+		spec[len] = '\0';
+
+		// the text (if any) is the first argument
+		if (entry->has_text && (0 == arg))
+			value = (intptr_t) entry->text;
+		else if ((arg - (entry->has_text ? 1 : 0)) < LOG_ARG_MAX)
+			value = entry->arg[arg - (entry->has_text ? 1 : 0)];
+		else
+			value = 0;
+		arg++;
+
+		log_print_arg(spec,*format++,is_long,value);
+	}
+}
+
+/*
+ * log_reserve : claim the next ring slot, or NULL if full
+ *
+ */
+
+static struct LOG_ENTRY_S *log_reserve(uint32_t *seq) {
+	atomic_val_t head;
+
+	// the full check and the claim are one step, else two producers could both pass the check
+	do {
+		head = atomic_get(&log_head);
+		if (((uint32_t) head - log_tail) >= LOG_RING_MAX) {
+			atomic_inc(&log_dropped);
+			return NULL;
+		}
+	} while (!atomic_cas(&log_head, head, head + 1));
+
+	*seq = (uint32_t) head;
+	return &log_ring[*seq & (LOG_RING_MAX-1)];
+}
+
+void log_event(uint8_t level, uint16_t format,
+	intptr_t a0, intptr_t a1, intptr_t a2, intptr_t a3,
+	intptr_t a4, intptr_t a5, intptr_t a6, intptr_t a7) {
+	struct LOG_ENTRY_S local;
+	struct LOG_ENTRY_S *entry = &local;
+	uint32_t seq = 0;
+
+	if (DEBUG_LOG_DEFERRED) {
+		entry = log_reserve(&seq);
+		if (NULL == entry)
+			return;
+	}
+
+	entry->format = format;
+	entry->level  = level;
+	entry->has_text = false;
+	entry->arg[0] = a0;
+	entry->arg[1] = a1;
+	entry->arg[2] = a2;
+	entry->arg[3] = a3;
+	entry->arg[4] = a4;
+	entry->arg[5] = a5;
+	entry->arg[6] = a6;
+	entry->arg[7] = a7;
+
+	if (DEBUG_LOG_DEFERRED) {
+		entry->ready = seq + 1;
+	} else {
+		log_print(entry);
+	}
+}
+
+void log_text_event(uint8_t level, uint16_t format, const char *text) {
+	struct LOG_ENTRY_S local;
+	struct LOG_ENTRY_S *entry = &local;
+	uint32_t seq = 0;
+
+	if (DEBUG_LOG_DEFERRED) {
+		entry = log_reserve(&seq);
+		if (NULL == entry)
+			return;
+	}
+
+	entry->format = format;
+	entry->level  = level;
+	entry->has_text = true;
+	strncpy(entry->text,text,LOG_TEXT_MAX);
+	entry->text[LOG_TEXT_MAX] = '\0';
+
+	if (DEBUG_LOG_DEFERRED) {
+		entry->ready = seq + 1;
+	} else {
+		log_print(entry);
+	}
+}
+
+/*
+ * log_drain : print all of the published entries
+ *
+ */
+
+void log_drain() {
+	static uint32_t dropped_prev = 0;
+	struct LOG_ENTRY_S *entry;
+	uint32_t dropped;
+
+	while (1) {
+		entry = &log_ring[log_tail & (LOG_RING_MAX-1)];
+		if (entry->ready != (log_tail + 1))
+			break;
+		log_print(entry);
+		log_tail++;
+	}
+
+	dropped = (uint32_t) atomic_get(&log_dropped);
+	if (dropped != dropped_prev) {
+		PRINT("\n*** LOG: %d entries dropped\n",dropped - dropped_prev);
+		dropped_prev = dropped;
+	}
+}
+
+/*
+ * log_flush : wait for the logger to catch up, before a synchronous console report
+ *
+ */
+
+void log_flush() {
+	int32_t wait = LOG_FLUSH_TICKS_MAX;
+
+	if (DEBUG_LOG_DEFERRED) {
+		while ((log_tail != (uint32_t) atomic_get(&log_head)) && (wait-- > 0)) {
+			task_sleep(1);
+		}
+	}
+}
+
+/*
+ * rocket_log_task : low priority task that drains the log ring
+ *
+ */
+
+void rocket_log_task() {
+	while (1) {
+		log_drain();
+		task_sleep(LOG_DRAIN_TICKS);
+	}
+}
@@ -0,0 +1,131 @@
+/* rocket_log.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/* Log levels (the compile-time filter is DEBUG_LOG_LEVEL in rocket.h) */
+#define LOG_LEVEL_NONE	0
+#define LOG_LEVEL_ERR	1	// always recorded
+#define LOG_LEVEL_INF	2	// recorded when 'verbose'
+#define LOG_LEVEL_DBG	3	// recorded when 'verbose'
+
+#define LOG_RING_MAX	256		// entries in the ring (power of two)
+#define LOG_ARG_MAX		8		// raw arguments per entry
+#define LOG_TEXT_MAX	32		// copied text per entry
+#define LOG_DRAIN_TICKS	2		// drain task period (ticks)
+#define LOG_FLUSH_TICKS_MAX	100	// longest wait for the drain task in log_flush()
+#define LOG_VAL_MAX		96		// longest log_val() message
+#define LOG_SPEC_MAX	15		// longest conversion specification in a format
+#define LOG_CHUNK_MAX	32		// literal text printed at a time
+
+/* Log formats: only the ID is recorded, the string (<ID>_FMT) is used by the
+ * drain task, and checked against the arguments of each RLOG_* call */
+#define LOG_F_TEXT_FMT			"%s"
+#define LOG_F_NEW_STATE_FMT		"NEW_STATE=%s\n"
+#define LOG_F_STATE_TOP_FMT		"\n/----------------\\ State=%s, Depth=%d\n"
+#define LOG_F_STATE_LINE_FMT	"|%s|\n"
+#define LOG_F_STATE_BOTTOM_FMT	"\\----------------/\n"
+#define LOG_F_STATE_KEYS_FMT	"1:=%s, 2=%s\n"
+#define LOG_F_SOUND_FMT			"** Sound: %d ***"
+#define LOG_F_FLIGHT_POS_FMT	"Now at:(%6d,%6d,%6d)"
+#define LOG_F_FLIGHT_TOWERS_FMT	" NW=(%6d,%6d),NE=(%6d,%6d),SW=(%6d,%6d),SE=(%6d,%6d)\n"
+#define LOG_F_FLIGHT_ANGLES_FMT	"A(%6d,%6d,%6d)Motors=(%6d,%6d,%6d,%6d)\n"
+#define LOG_F_IO_STATE_FMT		"[I/O] X=%3d Y=%3d Z=%3d A=%d B=%d"
+#define LOG_F_IO_GPIO_FMT		" | D4=%d, D5=%d, D6=%d, D7=%d, D8=%d\n"
+#define LOG_F_TEST_SOUND_FMT	"[Sound & Neo %d] Play\n"
+#define LOG_F_TEST_LEDRGB_FMT	"[LED RGB] Z=%#04x RGB=%d,%d,%d\n"
+#define LOG_F_TEST_ANTENNAE_FMT	"[%c] Pan=%0x,Tilt=%0x, Z=%04d\n"
+#define LOG_F_IO_DEVICE_FMT		"*** I/O: %s (0x%02x) %s, retry in %d mSec\n"
+
+enum LOG_FORMAT_E {
+	LOG_F_TEXT = 0,			// pre-formatted text (from log())
+	LOG_F_NEW_STATE,
+	LOG_F_STATE_TOP,
+	LOG_F_STATE_LINE,
+	LOG_F_STATE_BOTTOM,
+	LOG_F_STATE_KEYS,
+	LOG_F_SOUND,
+	LOG_F_FLIGHT_POS,
+	LOG_F_FLIGHT_TOWERS,
+	LOG_F_FLIGHT_ANGLES,
+	LOG_F_IO_STATE,
+	LOG_F_IO_GPIO,
+	LOG_F_TEST_SOUND,
+	LOG_F_TEST_LEDRGB,
+	LOG_F_TEST_ANTENNAE,
+	LOG_F_IO_DEVICE,
+	LOG_F_MAX
+};
+
+struct LOG_ENTRY_S {
+	volatile uint32_t ready;	// ring sequence+1, set when the entry is complete
+	uint16_t format;			// format ID
+	uint8_t  level;				// log level
+	uint8_t  has_text;			// text is the first argument
+	intptr_t arg[LOG_ARG_MAX];	// raw arguments (strings must be static)
+	char     text[LOG_TEXT_MAX+1];	// copied text
+};
+
+/*
+ * Logging macros: record a format ID plus up to LOG_ARG_MAX raw arguments.
+ * Entries above DEBUG_LOG_LEVEL compile away. String arguments are recorded
+ * as pointers, so they must be static (e.g. state names), else use RLOG_TEXT.
+ * The format ID must be the LOG_F_* name itself, so that the compiler checks
+ * the arguments against its <ID>_FMT string (log_format_check is never run).
+ */
+
+#define RLOG_ERR(format,...)	RLOG_LEVEL(LOG_LEVEL_ERR,format,##__VA_ARGS__)
+#define RLOG_INF(format,...)	RLOG_LEVEL(LOG_LEVEL_INF,format,##__VA_ARGS__)
+#define RLOG_DBG(format,...)	RLOG_LEVEL(LOG_LEVEL_DBG,format,##__VA_ARGS__)
+
+#define RLOG_ENABLED(level)	(((level) <= DEBUG_LOG_LEVEL) && ((LOG_LEVEL_ERR == (level)) || verbose))
+
+#define RLOG_LEVEL(level,format,...) \
+	do { \
+		if (0) \
+			log_format_check(format##_FMT,##__VA_ARGS__); \
+		if (RLOG_ENABLED(level)) \
+			RLOG_EVENT(level,format,##__VA_ARGS__,0,0,0,0,0,0,0,0); \
+	} while (0)
+
+#define RLOG_EVENT(level,format,a0,a1,a2,a3,a4,a5,a6,a7,...) \
+	log_event((level),(format), \
+		(intptr_t)(a0),(intptr_t)(a1),(intptr_t)(a2),(intptr_t)(a3), \
+		(intptr_t)(a4),(intptr_t)(a5),(intptr_t)(a6),(intptr_t)(a7))
+
+#define RLOG_TEXT(level,format,text) \
+	do { \
+		if (0) \
+			log_format_check(format##_FMT,(text)); \
+		if (RLOG_ENABLED(level)) \
+			log_text_event((level),(format),(text)); \
+	} while (0)
+
+static inline void log_format_check(const char *format, ...) __attribute__((format(printf,1,2)));
+static inline void log_format_check(const char *format, ...) {
+}
+
+void log_event(uint8_t level, uint16_t format,
+	intptr_t a0, intptr_t a1, intptr_t a2, intptr_t a3,
+	intptr_t a4, intptr_t a5, intptr_t a6, intptr_t a7);
+void log_text_event(uint8_t level, uint16_t format, const char *text);
+void log_drain();
+void log_flush();
+void rocket_log_task();
@@ -31,6 +31,7 @@
  *  - Interget version of the square root function (game-time distances)
  *  - Least-square approximation of motor steps to tower cable micro-meters
  *  - Curve routines for the come-hither and self-play modes
+ *  - Seeded random numbers and a CRC, for recorded and replayed sessions
  *
  */
 
@@ -58,7 +59,7 @@ static int32_t do_sqrt_rocket(int32_t x, int32_t init_guess)
 {	int32_t next_guess;
 
 	if (++sqrt_cnt > 10) {
-		PRINT("#############SQRT_TOOMANY(%ld,%ld\n",x,init_guess);
+		PRINT("#############SQRT_TOOMANY(%d,%d\n",x,init_guess);
 		return init_guess;
 	}
 
@@ -97,14 +98,54 @@ int32_t milli2micrometer(int32_t value) {
 	return(value*1000L);
 }
 
+/*
+ * rocket_rand : seeded pseudo random numbers (xorshift32)
+ *
+ *  The game's randomness comes only from here, so that a recorded session
+ *  replays exactly from its seed (see rocket_record.c)
+ *
+ */
+
+static uint32_t rand_state = ROCKET_RAND_SEED_DEFAULT;
+
+void rocket_rand_seed(uint32_t seed) {
+	// zero is the one state that xorshift can not leave
+	rand_state = seed ? seed : ROCKET_RAND_SEED_DEFAULT;
+}
+
+uint32_t rocket_rand() {
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+	return rand_state;
+}
+
+/*
+ * rocket_crc32 : CRC-32 (IEEE 802.3) of a buffer, continued from a previous value
+ *
+ */
+
+uint32_t rocket_crc32(uint32_t crc, const void *data, uint32_t len) {
+	const uint8_t *p = (const uint8_t *) data;
+	uint8_t bit;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (bit=0;bit<8;bit++)
+			crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+	}
+	return ~crc;
+}
+
 /*
  * tower spool length calibrate : extrapolate tower uMeters to steps from measurement table
  *
  */
 
 struct TOWER_SPOOL_SAMPLES {
-	uint32_t length;	// measured length (mm)
-	uint32_t steps;		// measured steps
+	int32_t length;		// measured length (mm), signed like the lengths it is compared to
+	int32_t steps;		// measured steps
 };
 
 #define TOWER_SPOOL_SAMPLES_MAX 22
@@ -213,57 +254,62 @@ struct TOWER_SPOOL_SAMPLES spool_samples[4][TOWER_SPOOL_SAMPLES_MAX] = {
 };
 
 int32_t micrometers2steps(int32_t tower,int32_t um) {
-	int32_t millimeters,steps;
+	int32_t steps;
 	uint8_t i;
 
-	millimeters = micro2millimeter(um);
-	if (millimeters < spool_samples[tower][0].length)
-		return(spool_samples[tower][0].steps);
-	if (millimeters > spool_samples[tower][TOWER_SPOOL_SAMPLES_MAX-1].length)
-		return(spool_samples[tower][TOWER_SPOOL_SAMPLES_MAX-1].steps);
-
-	for (i=0;i<TOWER_SPOOL_SAMPLES_MAX;) {
-		if (spool_samples[tower][i+1].length > millimeters) {
-			break;
-		} else {
-			i++;
+	// the segment is chosen in micrometers too, a rounded millimeter would extrapolate past its end
+	if (um < milli2micrometer(spool_samples[tower][0].length)) {
+		steps = spool_samples[tower][0].steps * ROCKET_TOWER_MICROSTEPS;
+	} else if (um > milli2micrometer(spool_samples[tower][TOWER_SPOOL_SAMPLES_MAX-1].length)) {
+		steps = spool_samples[tower][TOWER_SPOOL_SAMPLES_MAX-1].steps * ROCKET_TOWER_MICROSTEPS;
+	} else {
+		for (i=0;i<(TOWER_SPOOL_SAMPLES_MAX-2);) {
+			if (milli2micrometer(spool_samples[tower][i+1].length) > um) {
+				break;
+			} else {
+				i++;
+			}
 		}
-	}
 
-	steps  = millimeters - spool_samples[tower][i].length;
-	steps *= spool_samples[tower][i+1].steps  - spool_samples[tower][i].steps;
-	steps /= spool_samples[tower][i+1].length - spool_samples[tower][i].length;
-	steps += spool_samples[tower][i].steps;
+		// interpolate in micrometers, so that the microsteps resolve within the samples' millimeters
+		steps  = um - milli2micrometer(spool_samples[tower][i].length);
+		steps *= (spool_samples[tower][i+1].steps - spool_samples[tower][i].steps) * ROCKET_TOWER_MICROSTEPS;
+		steps /= milli2micrometer(spool_samples[tower][i+1].length - spool_samples[tower][i].length);
+		steps += spool_samples[tower][i].steps * ROCKET_TOWER_MICROSTEPS;
+	}
 
-	// HACK FOR NEW SPINDLES ######s
+	// HACK FOR NEW SPINDLES ######s (the clamped ends too)
 	steps /= 2;
 
 	return (steps);
 }
 
 int32_t steps2micrometers(int32_t tower,int32_t steps) {
-	int32_t millimeters;
+	int32_t micrometers;
 	uint8_t i;
 
-	if (steps < spool_samples[tower][0].steps)
+	// undo the HACK FOR NEW SPINDLES in micrometers2steps, to look up the samples
+	steps *= 2;
+
+	if (steps < (spool_samples[tower][0].steps * ROCKET_TOWER_MICROSTEPS))
 		return(milli2micrometer(spool_samples[tower][0].length));
-	if (steps > spool_samples[tower][TOWER_SPOOL_SAMPLES_MAX-1].steps)
+	if (steps > (spool_samples[tower][TOWER_SPOOL_SAMPLES_MAX-1].steps * ROCKET_TOWER_MICROSTEPS))
 		return(milli2micrometer(spool_samples[tower][TOWER_SPOOL_SAMPLES_MAX-1].length));
 
-	for (i=0;i<TOWER_SPOOL_SAMPLES_MAX;) {
-		if (spool_samples[tower][i+1].steps > steps) {
+	for (i=0;i<(TOWER_SPOOL_SAMPLES_MAX-2);) {
+		if ((spool_samples[tower][i+1].steps * ROCKET_TOWER_MICROSTEPS) > steps) {
 			break;
 		} else {
 			i++;
 		}
 	}
 
-	millimeters  = steps - spool_samples[tower][i].steps;
-	millimeters *= spool_samples[tower][i+1].length - spool_samples[tower][i].length;
-	millimeters /= spool_samples[tower][i+1].steps  - spool_samples[tower][i].steps;
-	millimeters += spool_samples[tower][i].length;
+	micrometers  = steps - (spool_samples[tower][i].steps * ROCKET_TOWER_MICROSTEPS);
+	micrometers *= milli2micrometer(spool_samples[tower][i+1].length - spool_samples[tower][i].length);
+	micrometers /= (spool_samples[tower][i+1].steps - spool_samples[tower][i].steps) * ROCKET_TOWER_MICROSTEPS;
+	micrometers += milli2micrometer(spool_samples[tower][i].length);
 
-	return (milli2micrometer(millimeters));
+	return (micrometers);
 }
 
 /*
@@ -340,10 +386,10 @@ void compass_select(uint8_t command, struct CompassRec *compass) {
 
 	// scale Z from nm to steps
 	if (COMPASS_CALC_HOME == command) {
-    	z_delta = (z_delta * 10L) / ROCKET_TOWER_STEP_PER_UM10;
+    	z_delta = (z_delta * 10L * ROCKET_TOWER_MICROSTEPS) / ROCKET_TOWER_STEP_PER_UM10;
     } else if (COMPASS_CALC_TILT == command) {
         // TODO ############## scale to fine tilt control
-    	z_delta = (z_delta * 10L) / ROCKET_TOWER_STEP_PER_UM10;
+    	z_delta = (z_delta * 10L * ROCKET_TOWER_MICROSTEPS) / ROCKET_TOWER_STEP_PER_UM10;
     } else if (COMPASS_CALC_POS == command) {
     	// ignore Z for now, use later for position scaling
     } else if (COMPASS_CALC_CIRC == command) {
@@ -625,7 +671,7 @@ struct MATH_TABLE tan_table[MATH_ATAN_MAX] = {
 };
 
 double degrees2cosine(int16_t degrees) {
-	for (int i=0;i<MATH_TABLE_MAX;i++) {
+	for (int i=0;i<(MATH_TABLE_MAX-1);i++) {
 		if (degrees < cosine_table[i+1].degrees) {
 			double degree_part = (degrees - cosine_table[i].degrees)/(cosine_table[i+1].degrees-cosine_table[i].degrees);
 			return ((((cosine_table[i+1].value-cosine_table[i].value)) * degree_part) + cosine_table[i].value);
@@ -635,7 +681,7 @@ double degrees2cosine(int16_t degrees) {
 };
 
 double degrees2sine(int16_t degrees) {
-	for (int i=0;i<MATH_TABLE_MAX;i++) {
+	for (int i=0;i<(MATH_TABLE_MAX-1);i++) {
 		if (degrees < sine_table[i+1].degrees) {
 			double degree_part = (degrees - sine_table[i].degrees)/(sine_table[i+1].degrees-sine_table[i].degrees);
 			return ((((sine_table[i+1].value-sine_table[i].value)) * degree_part) + sine_table[i].value);
@@ -653,7 +699,7 @@ int16_t atan2degrees(double x, double y) {
 
 	if (value < tan_table[0].value) return(-89);
 
-	for (int i=0;i<MATH_ATAN_MAX;i++) {
+	for (int i=0;i<(MATH_ATAN_MAX-1);i++) {
 		if (value < tan_table[i+1].value) {
 			double value_scale = (value - tan_table[i].value)/(tan_table[i+1].value-tan_table[i].value);
 			double degree_part = (double) (tan_table[i+1].degrees-tan_table[i].degrees);
@@ -672,7 +718,7 @@ int16_t atan2degrees(double x, double y) {
 
 #define LENGTH_SQRT_SCALER   6	/* 2^6 = 64, Scale at 100 uM closely matches stepper 125nM step size */
 
-static int32_t get_length(int32_t pos_x, int32_t pos_y, int32_t pos_z, int32_t goal_x, int32_t goal_y, int32_t goal_z) {
+int32_t get_length(int32_t pos_x, int32_t pos_y, int32_t pos_z, int32_t goal_x, int32_t goal_y, int32_t goal_z) {
 	int32_t x,y,z;
 
 	// we will use uMeter scaler for the intermedate calculation to avoid overflow
@@ -710,11 +756,12 @@ void flight_init () {
 
 /* speed is millimeters per second
  * Given that the tower cable speed max is 4 rps * 200 steps/rpm * 125.6 uM/step = 100 mm/sec,
- * let us suggest a safe and sane speed of 80 mm/sec, which is 16 mm per frame
+ * let us suggest a safe and sane speed of 80 mm/sec, which is 16 mm per 1/5 second frame
  */
 
 //#define DEFAULT_LINEAR_MM_PER_SECOND 50
 #define DEFAULT_LINEAR_MM_PER_SECOND 80
+#define FLIGHT_LINEAR_SECONDS_MAX    40
 
 void flight_linear (int32_t dest_x,int32_t dest_y,int32_t dest_z, int32_t speed) {
 	int32_t length;
@@ -744,11 +791,12 @@ void flight_linear (int32_t dest_x,int32_t dest_y,int32_t dest_z, int32_t speed)
 		r_flight.frame_max = 0;
 		return;
 	}
-	r_flight.frame_max = (length/1000L)/(speed/FRAMES_PER_SECOND);
+	// (mm/sec * mSec/frame) = uM/frame
+	r_flight.frame_max = length/(speed * r_game.frame_ms);
 	if (0 == r_flight.frame_max) {
 		return;
-	} else if (200 < r_flight.frame_max) {
-		r_flight.frame_max = 200;
+	} else if ((FLIGHT_LINEAR_SECONDS_MAX * FRAMES_PER_SECOND) < r_flight.frame_max) {
+		r_flight.frame_max = FLIGHT_LINEAR_SECONDS_MAX * FRAMES_PER_SECOND;
 	}
 	r_flight.dx=(dest_x-r_flight.current_x)/r_flight.frame_max;
 	r_flight.dy=(dest_y-r_flight.current_y)/r_flight.frame_max;
@@ -776,7 +824,7 @@ void flight_linear_loop () {
 	move_rocket_next_position();
 }
 
-void flight_wait (int32_t frame_count) {
+void flight_wait (int32_t duration_ms) {
 	flight_init();
 
 	r_flight.final_x = r_space.rocket_x;
@@ -787,7 +835,7 @@ void flight_wait (int32_t frame_count) {
 	r_flight.current_y=r_flight.final_y;
 	r_flight.current_z=r_flight.final_z;
 
-	r_flight.frame_max = frame_count;
+	r_flight.frame_max = duration_ms / r_game.frame_ms;
 }
 
 void flight_wait_loop () {
@@ -833,16 +881,19 @@ void rigid_rotation_compute (int16_t x_degrees,int16_t y_degrees,int16_t z_degre
 }
 
 /*
- * flight_circular
+ * flight_circular : rotate at the given degrees per second, for the given duration
+ *
+ *  The angles are tracked in milli-degrees so that slow rotations survive high frame rates
  *
  */
 
-void flight_circular (int32_t ax,int32_t ay,int32_t az, int32_t center_x, int32_t center_y, int32_t center_z, int32_t frame_count) {
+void flight_circular (int32_t ax,int32_t ay,int32_t az, int32_t center_x, int32_t center_y, int32_t center_z, int32_t duration_ms) {
 	flight_init();
 
-	r_flight.ax=ax;
-	r_flight.ay=ay;
-	r_flight.az=az;
+	// (degrees/sec * mSec/frame) = milli-degrees/frame
+	r_flight.ax=ax * r_game.frame_ms;
+	r_flight.ay=ay * r_game.frame_ms;
+	r_flight.az=az * r_game.frame_ms;
 
 	r_flight.center_x=center_x;
 	r_flight.center_y=center_y;
@@ -865,47 +916,51 @@ void flight_circular (int32_t ax,int32_t ay,int32_t az, int32_t center_x, int32_
 	if        ((10000L == r_space.rocket_x) && (0L == r_space.rocket_y) && (20000L==r_space.rocket_z)) {
 		r_flight.current_ax=0; r_flight.current_ay=0; r_flight.current_az=0;
 	} else if ((0L == r_space.rocket_x) && (10000L == r_space.rocket_y) && (20000L==r_space.rocket_z)) {
-		r_flight.current_ax=0; r_flight.current_ay=0; r_flight.current_az=90;
+		r_flight.current_ax=0; r_flight.current_ay=0; r_flight.current_az=90000L;
 	} else {
 		r_flight.current_ax=0; r_flight.current_ay=0; r_flight.current_az=0;
 	}
 
-	r_flight.frame_max = frame_count;
+	r_flight.frame_max = duration_ms / r_game.frame_ms;
 }
 
 void flight_circular_loop () {
 	float x=1.0,y=1.0,z=1.0;
+	int16_t degrees_x,degrees_y,degrees_z;
 	r_flight.frame_count++;
 
 	/* increment angles */
-	r_flight.current_ax = (r_flight.current_ax + r_flight.ax) % 360;
-	r_flight.current_ay = (r_flight.current_ay + r_flight.ay) % 360;
-	r_flight.current_az = (r_flight.current_az + r_flight.az) % 360;
+	r_flight.current_ax = (r_flight.current_ax + r_flight.ax) % 360000L;
+	r_flight.current_ay = (r_flight.current_ay + r_flight.ay) % 360000L;
+	r_flight.current_az = (r_flight.current_az + r_flight.az) % 360000L;
+	degrees_x = r_flight.current_ax / 1000L;
+	degrees_y = r_flight.current_ay / 1000L;
+	degrees_z = r_flight.current_az / 1000L;
 
 	/* find next rotation destination points */
-	if        ((0 == r_flight.current_ay) && (0 == r_flight.current_ax)) {
+	if        ((0 == degrees_y) && (0 == degrees_x)) {
 		// simple rotate on z-axis
-		x = degrees2cosine(r_flight.current_az);
-		y = degrees2sine(  r_flight.current_az);
+		x = degrees2cosine(degrees_z);
+		y = degrees2sine(  degrees_z);
 		r_flight.current_x = ((int32_t) (x * r_flight.radius)) + r_flight.center_x;
 		r_flight.current_y = ((int32_t) (y * r_flight.radius)) + r_flight.center_y;
 		// Z is unchanged
-	} else if ((0 == r_flight.current_az) && (0 == r_flight.current_ax)) {
+	} else if ((0 == degrees_z) && (0 == degrees_x)) {
 		// simple rotate on y-axis
-		x = degrees2cosine(r_flight.current_ay);
-		z = degrees2sine(  r_flight.current_ay);
+		x = degrees2cosine(degrees_y);
+		z = degrees2sine(  degrees_y);
 		r_flight.current_x = ((int32_t) (x * r_flight.radius)) + r_flight.center_x;
 		r_flight.current_z = ((int32_t) (z * r_flight.radius)) + r_flight.center_z;
 		// Y is unchanged
-	} else if ((0 == r_flight.current_az) && (0 == r_flight.current_ay)) {
+	} else if ((0 == degrees_z) && (0 == degrees_y)) {
 		// simple rotate on x-axis
-		y = degrees2cosine(r_flight.current_ax);
-		z = degrees2sine(  r_flight.current_ax);
+		y = degrees2cosine(degrees_x);
+		z = degrees2sine(  degrees_x);
 		r_flight.current_y = ((int32_t) (y * r_flight.radius)) + r_flight.center_y;
 		r_flight.current_z = ((int32_t) (z * r_flight.radius)) + r_flight.center_z;
 		// X is unchanged
 	} else {
-		rigid_rotation_compute (r_flight.current_ax,r_flight.current_ay,r_flight.current_az,ROCKET_HOME_X+100000L,ROCKET_HOME_Y+0,ROCKET_HOME_Z+150000L);
+		rigid_rotation_compute (degrees_x,degrees_y,degrees_z,ROCKET_HOME_X+100000L,ROCKET_HOME_Y+0,ROCKET_HOME_Z+150000L);
 	}
 
 	// send the coordinates to the rocket
@@ -947,7 +1002,7 @@ struct PWM_DEGREES_TABLE tilt_table[MATH_TILT_MAX] = {
 uint16_t pan_degrees2pwm(int16_t degrees) {
 	if (degrees < pan_table[0].degrees)
 		return pan_table[0].value;
-	for (int i=0;i<MATH_PAN_MAX;i++) {
+	for (int i=0;i<(MATH_PAN_MAX-1);i++) {
 		if (degrees < pan_table[i+1].degrees) {
 			int16_t result;
 			result  = (degrees - pan_table[i].degrees);
@@ -962,7 +1017,7 @@ uint16_t pan_degrees2pwm(int16_t degrees) {
 uint16_t tilt_degrees2pwm(int16_t degrees) {
 	if (degrees < tilt_table[0].degrees)
 		return tilt_table[0].value;
-	for (int i=0;i<MATH_PAN_MAX;i++) {
+	for (int i=0;i<(MATH_TILT_MAX-1);i++) {
 		if (degrees < tilt_table[i+1].degrees) {
 			int16_t result;
 			result  = (degrees - tilt_table[i].degrees);
@@ -971,25 +1026,29 @@ uint16_t tilt_degrees2pwm(int16_t degrees) {
 			return (result + tilt_table[i].value);
 		}
 	}
-	return tilt_table[MATH_PAN_MAX-1].value;
+	return tilt_table[MATH_TILT_MAX-1].value;
 };
 
 
 void antenna_update() {
+	antenna_update_space(&r_space);
+}
+
+void antenna_update_space(struct ROCKET_SPACE_S *space) {
 	static uint16_t pan_current=0;
 	static uint16_t tilt_current=0;
 	uint16_t pan_now=0;
 	uint16_t tilt_now=0;
 	double degrees_x,degrees_z;
 
-	degrees_x = atan2degrees((double) (r_space.rocket_goal_x - ANTENNA_X_POS), (double) (r_space.rocket_goal_y - ANTENNA_Y_POS));
-	degrees_z = atan2degrees((double) (r_space.rocket_goal_z - ANTENNA_Z_POS), (double) (r_space.rocket_goal_y - ANTENNA_Y_POS));
+	degrees_x = atan2degrees((double) (space->rocket_goal_x - ANTENNA_X_POS), (double) (space->rocket_goal_y - ANTENNA_Y_POS));
+	degrees_z = atan2degrees((double) (space->rocket_goal_z - ANTENNA_Z_POS), (double) (space->rocket_goal_y - ANTENNA_Y_POS));
 
 	pan_now=pan_degrees2pwm(degrees_x);
 	tilt_now=tilt_degrees2pwm(degrees_z);
 
-	if (false) printf("Antennae(%ld,%ld,%ld)=(%f,%f)=(%d,%d)\n",
-		r_space.rocket_goal_x,r_space.rocket_goal_y,r_space.rocket_goal_z,
+	if (false) printf("Antennae(%d,%d,%d)=(%f,%f)=(%d,%d)\n",
+		space->rocket_goal_x,space->rocket_goal_y,space->rocket_goal_z,
 		degrees_x,degrees_z,
 		pan_now,tilt_now
 		);
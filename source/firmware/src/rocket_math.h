@@ -45,13 +45,13 @@ struct ROCKET_FLIGHT_S {
 	int32_t	dy;
 	int32_t	dz;
 
-	int32_t	ax;		// change in angle around X,Y,Z per frame, degrees
+	int32_t	ax;		// change in angle around X,Y,Z per frame, milli-degrees
 	int32_t	ay;
 	int32_t	az;
 
 	int32_t	speed;		// speed (microseconds per step)
 
-	int32_t	current_ax;	// current angle on axis X,Y,Z in degrees
+	int32_t	current_ax;	// current angle on axis X,Y,Z in milli-degrees
 	int32_t	current_ay;
 	int32_t	current_az;
 
@@ -83,11 +83,19 @@ int32_t steps2micrometers(int32_t tower,int32_t value);
 int32_t micro2millimeter(int32_t value);
 int32_t milli2micrometer(int32_t value);
 
+#define ROCKET_RAND_SEED_DEFAULT	2463534242UL	// any non-zero seed
+
+void rocket_rand_seed(uint32_t seed);
+uint32_t rocket_rand();
+uint32_t rocket_crc32(uint32_t crc, const void *data, uint32_t len);
+
 extern struct ROCKET_FLIGHT_S r_flight;
 
 void compass_select(uint8_t command, struct CompassRec *compass);
 void compute_tower_step_to_nm();
 
+int32_t get_length(int32_t pos_x, int32_t pos_y, int32_t pos_z, int32_t goal_x, int32_t goal_y, int32_t goal_z);
+
 double degrees2sine(int16_t degrees);
 double degrees2cosine(int16_t degrees);
 int16_t atan2degrees(double x, double y);
@@ -95,12 +103,13 @@ int16_t atan2degrees(double x, double y);
 void flight_linear(int32_t dest_x,int32_t dest_y,int32_t dest_z, int32_t speed);
 void flight_linear_loop();
 
-void flight_circular(int32_t ax,int32_t ay,int32_t az, int32_t center_x, int32_t center_y, int32_t center_z, int32_t frame_count);
+void flight_circular(int32_t ax,int32_t ay,int32_t az, int32_t center_x, int32_t center_y, int32_t center_z, int32_t duration_ms);
 void flight_circular_loop();
 
-void flight_wait(int32_t frame_count);
+void flight_wait(int32_t duration_ms);
 void flight_wait_loop();
 
 void rigid_rotation_compute (int16_t x_degrees,int16_t y_degrees,int16_t z_degrees,int32_t start_x,int32_t start_y,int32_t start_z);
 
 void antenna_update();
+void antenna_update_space(struct ROCKET_SPACE_S *space);
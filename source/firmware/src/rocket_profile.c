@@ -0,0 +1,145 @@
+/* rocket_profile.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Theory of Implementation
+ *  - Each frame phase records its duration (in cycles) into a log2 histogram
+ *    (see rocket_hist.c), so the cost is two cycle counter reads and a few
+ *    adds, cheap enough to leave DEBUG_PROFILE_ENABLE on
+ *  - Some phases are recorded by more than one task (PROF_PAN_TILT and
+ *    PROF_DISPLAY by both the physics task and the output task's antenna
+ *    update), so each sample is added under a brief irq_lock()
+ *  - The phases nest (e.g. PROF_MOTOR inside PROF_MOVE, inside PROF_STATE,
+ *    inside PROF_FRAME), so the times are inclusive and do not add up
+ *  - The histograms are shown by the Test > Timing state, which also dumps
+ *    the full table to the console
+ */
+
+#include <zephyr.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_hist.h"
+#include "rocket_profile.h"
+
+
+static struct ROCKET_HIST_S profile_table[PROF_PHASE_MAX];
+
+static const char *profile_names[PROF_PHASE_MAX] = {
+	[PROF_FRAME]      = "Frame",
+	[PROF_SCAN]       = "Scan",
+	[PROF_STATE]      = "State",
+	[PROF_KINEMATICS] = "Kinematic",
+	[PROF_CABLES]     = "Cables",
+	[PROF_MOVE]       = "Move",
+	[PROF_MOTOR]      = "Motor",
+	[PROF_LCD]        = "LCD",
+	[PROF_BACKPACK]   = "Backpack",
+	[PROF_DISPLAY]    = "Display",
+	[PROF_PAN_TILT]   = "PanTilt",
+	[PROF_BUS]        = "Bus",
+};
+
+/*
+ * profile_reset : clear the phase histograms
+ *
+ */
+
+void profile_reset() {
+	uint8_t i;
+
+	for (i=0;i<PROF_PHASE_MAX;i++) {
+		hist_reset(&profile_table[i]);
+	}
+}
+
+/*
+ * prof_start, prof_stop : time a phase, from the cycle count returned by prof_start()
+ *
+ */
+
+uint32_t prof_start() {
+	if (DEBUG_PROFILE_ENABLE) {
+		return task_cycle_get_32();
+	}
+	return 0;
+}
+
+void prof_stop(uint8_t phase, uint32_t cycle_start) {
+	uint32_t cycles;
+	unsigned int key;
+
+	if (!DEBUG_PROFILE_ENABLE || (phase >= PROF_PHASE_MAX))
+		return;
+
+	cycles = task_cycle_get_32() - cycle_start;
+	key = irq_lock();
+	hist_add(&profile_table[phase],cycles);
+	irq_unlock(key);
+}
+
+/*
+ * profile_name, profile_hist : a phase's name and histogram, for the Timing state
+ *
+ */
+
+const char *profile_name(uint8_t phase) {
+	if (phase >= PROF_PHASE_MAX)
+		return "";
+	return profile_names[phase];
+}
+
+struct ROCKET_HIST_S *profile_hist(uint8_t phase) {
+	if (phase >= PROF_PHASE_MAX)
+		return NULL;
+	return &profile_table[phase];
+}
+
+/*
+ * profile_dump : print the phase timing table
+ *
+ */
+
+void profile_dump() {
+	struct ROCKET_HIST_S *hist;
+	uint8_t i;
+
+	if (!DEBUG_PROFILE_ENABLE)
+		return;
+
+	PRINT("\n=== Frame Profile (usec) ===\n");
+	PRINT("%-10s %6s %8s %8s %8s %8s\n","Phase","Count","Min","Mean","P99","Max");
+	for (i=0;i<PROF_PHASE_MAX;i++) {
+		hist = &profile_table[i];
+		if (0 == hist->count)
+			continue;
+		PRINT("%-10s %6d %8d %8d %8d %8d\n",
+			profile_names[i],
+			hist->count,
+			hist_cycles2usec(hist->min),
+			hist_cycles2usec(hist_mean(hist)),
+			hist_cycles2usec(hist_percentile(hist,99)),
+			hist_cycles2usec(hist->max));
+	}
+}
@@ -0,0 +1,43 @@
+/* rocket_profile.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/* Frame phases, in the order of the report */
+#define PROF_FRAME			0	// the whole frame (main loop work)
+#define PROF_SCAN			1	// scan_controls(), or the input snapshot copy
+#define PROF_STATE			2	// state_loop()
+#define PROF_KINEMATICS		3	// compute_rocket_next_position()
+#define PROF_CABLES			4	// compute_rocket_cable_lengths()
+#define PROF_MOVE			5	// move_rocket_next_position()
+#define PROF_MOTOR			6	// rocket_increment_send()
+#define PROF_LCD			7	// lcd_fb_flush()
+#define PROF_BACKPACK		8	// send_LED_Backpack()
+#define PROF_DISPLAY		9	// send_rocket_display()
+#define PROF_PAN_TILT		10	// send_Pan_Tilt()
+#define PROF_BUS			11	// each i2c transaction in the output task
+#define PROF_PHASE_MAX		12
+
+uint32_t prof_start();
+void prof_stop(uint8_t phase, uint32_t cycle_start);
+void profile_reset();
+void profile_dump();
+const char *profile_name(uint8_t phase);
+struct ROCKET_HIST_S *profile_hist(uint8_t phase);
@@ -0,0 +1,266 @@
+/* rocket_record.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - A game session is fully determined by the rocket_rand() seed and, for
+ *    each frame, the control inputs (analog x/y/z, the debounced button levels,
+ *    the decided button event) and the number of frame periods since the
+ *    previous frame, which sets the physics time step
+ *  - In capture mode record_frame() stores these after the controls are read,
+ *    as runs of identical frames, so a joystick held still costs one run
+ *  - In replay mode record_frame() overwrites them from the recording instead,
+ *    so state_loop() and the physics see exactly the recorded session,
+ *    without any buttons, joystick, or frame timing
+ *  - After state_loop(), record_frame_end() folds the frame's output (r_space
+ *    and the tower lengths and steps) into a running CRC. In capture it is
+ *    stored after every frame (up to RECORD_FRAME_MAX) and at the end of each
+ *    run. In replay each frame is checked against its stored CRC, so the first
+ *    mismatch is the frame where the replay diverged; frames past the stored
+ *    ones are only checked at the end of their run
+ *  - On the board the capture (DEBUG_RECORD_ENABLE) is a RAM buffer to read
+ *    with the debugger; the host build (see ../host) saves and loads the file
+ */
+
+#include <zephyr.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_space.h"
+#include "rocket_math.h"
+#include "rocket_record.h"
+
+
+struct ROCKET_RECORD_S r_record;
+
+/*
+ * record_capture_start : record the inputs of each frame from now on
+ *
+ */
+
+void record_capture_start() {
+	memset(&r_record,0,sizeof(r_record));
+	r_record.header.magic = RECORD_MAGIC;
+	r_record.header.version = RECORD_VERSION;
+	r_record.mode = RECORD_CAPTURE;
+}
+
+/*
+ * record_replay_start : replay the header and runs already loaded into r_record
+ *
+ */
+
+bool record_replay_start(uint32_t runs, uint32_t frame_crcs) {
+	if ((RECORD_MAGIC != r_record.header.magic) ||
+		(RECORD_VERSION != r_record.header.version) ||
+		(runs != r_record.header.runs) ||
+		(runs > RECORD_RUN_MAX) ||
+		(frame_crcs != r_record.header.frame_crcs) ||
+		(frame_crcs > RECORD_FRAME_MAX)) {
+		r_record.mode = RECORD_OFF;
+		return false;
+	}
+
+	r_record.run = 0;
+	r_record.run_frame = 0;
+	r_record.frame = 0;
+	r_record.crc = 0;
+	r_record.mismatches = 0;
+	r_record.mismatch_frame = 0;
+	r_record.mismatch_run = false;
+	r_record.mode = RECORD_REPLAY;
+	return true;
+}
+
+/*
+ * record_seed : the session's random seed, the recorded one when replaying
+ *
+ *  Called once at boot, after init_main(), which also sets the frame rate
+ *
+ */
+
+uint32_t record_seed(uint32_t fresh_seed) {
+	if (RECORD_REPLAY == r_record.mode) {
+		// keep a damaged or foreign recording within the supported frame periods
+		r_game.frame_ms = r_record.header.frame_ms;
+		if (r_game.frame_ms < FRAME_MS_MIN) r_game.frame_ms = FRAME_MS_MIN;
+		if (r_game.frame_ms > FRAME_MS_MAX) r_game.frame_ms = FRAME_MS_MAX;
+		return r_record.header.seed;
+	}
+	r_record.header.frame_ms = r_game.frame_ms;
+	r_record.header.seed = fresh_seed;
+	return fresh_seed;
+}
+
+/*
+ * record_frame : capture or replace this frame's inputs, return the frame periods
+ *
+ */
+
+uint32_t record_frame(uint32_t periods) {
+	struct RECORD_RUN_S *run = &r_record.run_buf[r_record.run];
+	uint16_t x,y,z;
+
+	if (RECORD_CAPTURE == r_record.mode) {
+		if (periods > RECORD_PERIOD_MAX)
+			periods = RECORD_PERIOD_MAX;
+
+		x = (r_control.analog_x & RECORD_ANALOG_MASK) |
+			((r_control.button_event & 0x3) << RECORD_EVENT_SHIFT) |
+			(r_control.button_a ? RECORD_LEVEL_A : 0) |
+			(r_control.button_b ? RECORD_LEVEL_B : 0);
+		y = (r_control.analog_y & RECORD_ANALOG_MASK) | (periods << RECORD_PERIOD_SHIFT);
+		z = (r_control.analog_z & RECORD_ANALOG_MASK);
+
+		// extend the current run, else start the next one
+		if ((0 < run->frames) &&
+			((x != run->x) || (y != run->y) || (z != run->z) || (RECORD_RUN_FRAMES == run->frames))) {
+			if ((r_record.run + 1) >= RECORD_RUN_MAX) {
+				r_record.mode = RECORD_FULL;
+				return periods;
+			}
+			run = &r_record.run_buf[++r_record.run];
+		}
+		if (0 == run->frames) {
+			run->x = x;
+			run->y = y;
+			run->z = z;
+		}
+		run->frames++;
+		r_record.frame++;
+		r_record.header.runs = r_record.run + 1;
+		r_record.header.frames = r_record.frame;
+		return periods;
+	}
+
+	if (RECORD_REPLAY == r_record.mode) {
+		if (r_record.run >= r_record.header.runs) {
+			r_record.mode = RECORD_DONE;
+			return periods;
+		}
+
+		r_control.analog_x = run->x & RECORD_ANALOG_MASK;
+		r_control.analog_y = run->y & RECORD_ANALOG_MASK;
+		r_control.analog_z = run->z & RECORD_ANALOG_MASK;
+		r_control.button_a = (0 != (run->x & RECORD_LEVEL_A));
+		r_control.button_b = (0 != (run->x & RECORD_LEVEL_B));
+		r_control.button_event = (run->x >> RECORD_EVENT_SHIFT) & 0x3;
+		r_record.run_frame++;
+		r_record.frame++;
+		return (run->y >> RECORD_PERIOD_SHIFT) & RECORD_PERIOD_MAX;
+	}
+
+	return periods;
+}
+
+/*
+ * record_frame_end : fold the frame's output into the CRC, check it when replaying
+ *
+ */
+
+void record_frame_end() {
+	struct RECORD_RUN_S *run = &r_record.run_buf[r_record.run];
+	bool run_end;
+	uint32_t crc;
+	uint8_t i;
+
+	if ((RECORD_CAPTURE != r_record.mode) && (RECORD_REPLAY != r_record.mode))
+		return;
+
+	r_record.crc = rocket_crc32(r_record.crc,&r_space,sizeof(r_space));
+	for (i=0;i<ROCKET_TOWER_MAX;i++) {
+		r_record.crc = rocket_crc32(r_record.crc,&r_towers[i].length,sizeof(r_towers[i].length));
+		r_record.crc = rocket_crc32(r_record.crc,&r_towers[i].step_count,sizeof(r_towers[i].step_count));
+	}
+
+	if (RECORD_CAPTURE == r_record.mode) {
+		run->crc = r_record.crc;
+		r_record.header.crc = r_record.crc;
+		if (r_record.frame <= RECORD_FRAME_MAX) {
+			r_record.frame_crc[r_record.frame - 1] = r_record.crc;
+			r_record.header.frame_crcs = r_record.frame;
+		}
+		return;
+	}
+
+	// replay: check each frame that has its own CRC, else the end of each run
+	run_end = (r_record.run_frame >= run->frames);
+	if (r_record.frame <= r_record.header.frame_crcs)
+		crc = r_record.frame_crc[r_record.frame - 1];
+	else if (run_end)
+		crc = run->crc;
+	else
+		return;
+	if (crc != r_record.crc) {
+		if (0 == r_record.mismatches) {
+			r_record.mismatch_frame = r_record.frame;
+			r_record.mismatch_run = (r_record.frame > r_record.header.frame_crcs);
+		}
+		r_record.mismatches++;
+		// continue from the recorded output, to count the independent mismatches
+		r_record.crc = crc;
+	}
+	if (!run_end)
+		return;
+	r_record.run++;
+	r_record.run_frame = 0;
+	if (r_record.run >= r_record.header.runs)
+		r_record.mode = RECORD_DONE;
+}
+
+/*
+ * record_size : bytes of the recording (the header, its runs and frame CRCs)
+ *
+ */
+
+uint32_t record_size() {
+	return sizeof(r_record.header) +
+		(r_record.header.runs * sizeof(struct RECORD_RUN_S)) +
+		(r_record.header.frame_crcs * sizeof(uint32_t));
+}
+
+/*
+ * record_report : display the recording state
+ *
+ */
+
+void record_report() {
+	if (RECORD_OFF == r_record.mode)
+		return;
+
+	PRINT("*** Record(%s): frames=%d runs=%d bytes=%d seed=0x%08x crc=0x%08x\n",
+		(RECORD_CAPTURE == r_record.mode) ? "capture" :
+		(RECORD_FULL    == r_record.mode) ? "full"    :
+		(RECORD_REPLAY  == r_record.mode) ? "replay"  : "done",
+		r_record.frame,
+		r_record.header.runs,
+		record_size(),
+		r_record.header.seed,
+		r_record.crc);
+	if (0 < r_record.mismatches) {
+		PRINT("***   replay diverged: %d checks differ, first at frame %d%s\n",
+			r_record.mismatches,
+			r_record.mismatch_frame,
+			r_record.mismatch_run ? " (or earlier in its run)" : "");
+	}
+}
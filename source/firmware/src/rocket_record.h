@@ -0,0 +1,90 @@
+/* rocket_record.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/* Recording format: a header, then runs of frames with the same inputs */
+#define RECORD_MAGIC		0x52544b52	// "RKTR"
+#define RECORD_VERSION		2
+#ifdef ROCKET_HOST
+#define RECORD_RUN_MAX		65536		// runs in the buffer (12 bytes each)
+#define RECORD_FRAME_MAX	262144		// frames with their own output CRC (the replay is on the host)
+#else
+#define RECORD_RUN_MAX		(DEBUG_RECORD_ENABLE ? 1024 : 1)
+#define RECORD_FRAME_MAX	1
+#endif
+#define RECORD_RUN_FRAMES	0xffff		// longest run
+
+/* Modes */
+#define RECORD_OFF			0
+#define RECORD_CAPTURE		1			// record the inputs of each frame
+#define RECORD_REPLAY		2			// replace the inputs of each frame from the recording
+#define RECORD_DONE			3			// the replay has used all of its frames
+#define RECORD_FULL			4			// the capture ran out of runs
+
+/* Packing of the control values (10 bit ADC values) with the frame flags */
+#define RECORD_ANALOG_MASK	0x03ff
+#define RECORD_EVENT_SHIFT	10			// x: the decided button event (BUTTON_EVENT_*)
+#define RECORD_LEVEL_A		0x1000		// x: the debounced button levels
+#define RECORD_LEVEL_B		0x2000
+#define RECORD_PERIOD_SHIFT	10			// y: the frame periods since the last frame (1..3)
+#define RECORD_PERIOD_MAX	3
+
+struct RECORD_HEADER_S {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t frame_ms;		// frame period at boot
+	uint32_t seed;			// rocket_rand() seed
+	uint32_t runs;			// runs that follow
+	uint32_t frames;		// total frames
+	uint32_t crc;			// output CRC after the last frame
+	uint32_t frame_crcs;	// per frame output CRCs that follow the runs
+};
+
+struct RECORD_RUN_S {
+	uint16_t frames;		// frames with these inputs
+	uint16_t x;				// analog x, event and button levels
+	uint16_t y;				// analog y and frame periods
+	uint16_t z;				// analog z
+	uint32_t crc;			// output CRC after the run's last frame
+};
+
+struct ROCKET_RECORD_S {
+	uint8_t  mode;
+	uint32_t run;			// current run
+	uint32_t run_frame;		// frames done in the current run
+	uint32_t frame;			// frames done
+	uint32_t crc;			// output CRC so far
+	uint32_t mismatches;	// replayed checks (frames, else runs) whose output differed
+	uint32_t mismatch_frame;	// frame of the first check that differed
+	bool mismatch_run;		// that check was at the end of its run, the frame is only an upper bound
+	struct RECORD_HEADER_S header;
+	struct RECORD_RUN_S run_buf[RECORD_RUN_MAX];
+	uint32_t frame_crc[RECORD_FRAME_MAX];	// output CRC after each frame
+};
+
+extern struct ROCKET_RECORD_S r_record;
+
+void record_capture_start();
+bool record_replay_start(uint32_t runs, uint32_t frame_crcs);
+uint32_t record_seed(uint32_t fresh_seed);
+uint32_t record_frame(uint32_t periods);
+void record_frame_end();
+uint32_t record_size();
+void record_report();
@@ -0,0 +1,120 @@
+/* rocket_segment.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/*
+ * Theory of Implementation
+ *  - Every numeric display (fuel on the LED backpack, height and speed on the
+ *    display board) is rendered here into raw segment bytes, left to right
+ *  - There is no floating point, and no division loop: the value (at most four
+ *    digits) is split into two halves of two digits with a multiply by the
+ *    reciprocal of 100, and each half is turned into its two BCD digits by a
+ *    100 entry table, so each render takes the same time
+ *  - Fixed point values take 'decimals' digits after the point (e.g. 123 with
+ *    one decimal shows as 12.3), signed values show a leading minus sign, and
+ *    leading zeros can be blanked
+ *  - Values outside the displayable range show as the nearest limit
+ */
+
+#include <zephyr.h>
+
+#include <stdbool.h>
+
+#include "rocket_segment.h"
+
+
+/* digit to segments */
+static const uint8_t segment_digit[10] = {
+	0x3F, /* 0 */
+	0x06, /* 1 */
+	0x5B, /* 2 */
+	0x4F, /* 3 */
+	0x66, /* 4 */
+	0x6D, /* 5 */
+	0x7D, /* 6 */
+	0x07, /* 7 */
+	0x7F, /* 8 */
+	0x6F, /* 9 */
+};
+
+/* 0..99 to two BCD digits */
+static const uint8_t segment_bcd[100] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+};
+
+/* value/100 for 0 <= value < 43699, as a multiply and a shift */
+#define SEGMENT_DIV100(v)	(((v) * 5243UL) >> 19)
+
+/*
+ * segment_render : render a value into SEGMENT_DIGITS segment bytes, left to right
+ *
+ *  decimals : digits after the decimal point (0 for an integer)
+ *  flags    : SEGMENT_ZEROS or SEGMENT_BLANK
+ *
+ */
+
+void segment_render(int32_t value, uint8_t decimals, uint8_t flags, uint8_t *segments) {
+	bool negative = (value < 0);
+	uint32_t magnitude,high,low;
+	uint8_t digits[SEGMENT_DIGITS];
+	uint8_t lead,i;
+
+	if (value > SEGMENT_VALUE_MAX)
+		value = SEGMENT_VALUE_MAX;
+	if (value < SEGMENT_VALUE_MIN)
+		value = SEGMENT_VALUE_MIN;
+	magnitude = negative ? -value : value;
+	if (decimals >= SEGMENT_DIGITS)
+		decimals = SEGMENT_DIGITS - 1;
+
+	// the four digits, from two table lookups
+	high = SEGMENT_DIV100(magnitude);
+	low  = magnitude - (high * 100);
+	digits[0] = segment_bcd[high] >> 4;
+	digits[1] = segment_bcd[high] & 0x0f;
+	digits[2] = segment_bcd[low]  >> 4;
+	digits[3] = segment_bcd[low]  & 0x0f;
+
+	// the leading zeros that may be blanked, up to the digit before the point
+	lead = 0;
+	if (SEGMENT_BLANK & flags) {
+		while ((lead < (SEGMENT_DIGITS - 1 - decimals)) && (0 == digits[lead]))
+			lead++;
+	}
+
+	for (i=0;i<SEGMENT_DIGITS;i++) {
+		segments[i] = (i < lead) ? SEGMENT_OFF : segment_digit[digits[i]];
+	}
+	if (0 < decimals)
+		segments[SEGMENT_DIGITS - 1 - decimals] |= SEGMENT_POINT;
+
+	// the sign goes just before the first digit shown (the first digit is a zero, as value >= -999)
+	if (negative)
+		segments[(0 < lead) ? (lead - 1) : 0] = SEGMENT_MINUS;
+}
@@ -0,0 +1,42 @@
+/* rocket_segment.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+/* Four digit seven-segment displays (the LED backpack and the display board's TM1637s) */
+#define SEGMENT_DIGITS		4
+#define SEGMENT_VALUE_MAX	9999	// larger values show as the limit
+#define SEGMENT_VALUE_MIN	-999	// one digit is taken by the sign
+
+/* Segment bits, the same on the HT16K33 and TM1637 displays:
+ *     01
+ *   20  02
+ *     40
+ *   10  04
+ *     08  80(point)
+ */
+#define SEGMENT_OFF			0x00
+#define SEGMENT_MINUS		0x40
+#define SEGMENT_POINT		0x80
+
+/* Render flags */
+#define SEGMENT_ZEROS		0x00	// show the leading zeros
+#define SEGMENT_BLANK		0x01	// blank the leading zeros (never the units, nor the digit before the point)
+
+void segment_render(int32_t value, uint8_t decimals, uint8_t flags, uint8_t *segments);
@@ -46,14 +46,17 @@
 #include "rocket.h"
 #include "rocket_space.h"
 #include "rocket_math.h"
+#include "rocket_io.h"
+#include "rocket_hist.h"
+#include "rocket_profile.h"
 
 /*
  * forward declarations
  *
  */
 
-void rocket_position_send();
-void rocket_command_send(uint8_t command);
+bool rocket_position_send();
+bool rocket_command_send(uint8_t command);
 void set_rocket_position();
 
 /*
@@ -119,6 +122,13 @@ struct ROCKET_TOWER_S r_towers[ROCKET_TOWER_MAX] = {
     },
 };
 
+struct ROCKET_MOTOR_STATUS_S r_motor_status;
+
+/* motor board commands not (yet) delivered (see rocket_increment_send) */
+static volatile bool motor_resync = false;		// resend the positions, then preset
+static volatile bool ground_resync = false;		// resend all the ground positions
+static int32_t increment_unsent[ROCKET_TOWER_MAX];	// increments not yet queued
+
 struct ROCKET_GROUND_S r_ground[ROCKET_GROUND_MAX] = {
     {
     	.name		= "00",
@@ -224,7 +234,7 @@ bool init_rocket_hardware () {
 	r_space.rocket_y = 0;
 	r_space.rocket_z = 0;
 
-	r_space.speed_max = 1250;  	// minimum microseconds per step => maximum speed (mSec) = 240 rpm (NOTE:1000 mSec too fast for NEMA-17)
+	r_space.speed_max = 1250 / ROCKET_TOWER_MICROSTEPS;  	// minimum microseconds per microstep => maximum speed (mSec) = 240 rpm (NOTE:1000 mSec too fast for NEMA-17)
 
 	// Initialize XYZ motor controls
 	if (IO_MOTOR_ENABLE) {
@@ -242,7 +252,7 @@ bool init_rocket_hardware () {
 
 void init_rocket_game (int32_t pos_x, int32_t pos_y, int32_t pos_z, int32_t fuel, int32_t gravity, int32_t mode)
  {
-	int32_t randnum = task_cycle_get_32()/2L;
+	int32_t randnum = rocket_rand()/2L;
 	int32_t x,y,a,b;
 
 	// set initial rocket conditions
@@ -273,10 +283,18 @@ void init_rocket_game (int32_t pos_x, int32_t pos_y, int32_t pos_z, int32_t fuel
 		r_space.gravity_delta = -(GRAVITY_UMETER_PER_SECOND/2);
 	}
 
-	r_space.rocket_delta_x = 0;		// current game-space rocket speed, in uMeters
+	r_space.rocket_delta_x = 0;		// current game-space rocket speed, in uMeters per second
 	r_space.rocket_delta_y = 0;
 	r_space.rocket_delta_z = 0;
 
+	r_space.rocket_rem_x = 0;		// no partial frame motion yet
+	r_space.rocket_rem_y = 0;
+	r_space.rocket_rem_z = 0;
+	r_space.rocket_rem_dx = 0;
+	r_space.rocket_rem_dy = 0;
+	r_space.rocket_rem_dz = 0;
+	r_space.rocket_rem_fuel = 0;
+
 	r_space.thrust_x = 0;			// current thruster value, in fuel units
 	r_space.thrust_y = 0;
 	r_space.thrust_z = 0;
@@ -310,6 +328,22 @@ void init_rocket_game (int32_t pos_x, int32_t pos_y, int32_t pos_z, int32_t fuel
 }
 
 
+/*
+ * rocket_frame_scale : scale a per-second rate to the current frame's time step
+ *
+ *  The remainder carries the sub-unit balance (in unit*mSec) to the next frame,
+ *  so that slow rates at high frame rates are not lost to integer truncation
+ *
+ */
+
+int32_t rocket_frame_scale(int32_t per_second, int32_t *remainder) {
+	int32_t value = (per_second * r_game.frame_dt_ms) + *remainder;
+
+	*remainder = value % 1000L;
+	return (value / 1000L);
+}
+
+
 /*
  * compute_next_position : use vectors to compute next incremental position for rocket
  *
@@ -317,66 +351,83 @@ void init_rocket_game (int32_t pos_x, int32_t pos_y, int32_t pos_z, int32_t fuel
 
 void compute_rocket_next_position ()
  {
+	uint32_t prof_cycles = prof_start();
 	int32_t	rocket_fuel_used=0;
 	int32_t	rocket_thrust_inc_x=THRUST_UMETER_INC_X;
 	int32_t	rocket_thrust_inc_y=THRUST_UMETER_INC_Y;
 	int32_t	rocket_thrust_inc_z=THRUST_UMETER_INC_Z;
+	int32_t	accel_x=0,accel_y=0,accel_z=0;
 
 	r_space.thrust_x=0;
 	r_space.thrust_y=0;
 	r_space.thrust_z=0;
 
 	if (GAME_XYZ_MOVE == r_game.game) {
-		// fast absolute xy changes in 'move' mode
-		rocket_thrust_inc_x = 5000;
-		rocket_thrust_inc_y = 5000;
+		// fast absolute xyz changes in 'move' mode, these are speeds and not accelerations
+		rocket_thrust_inc_x = MOVE_UMETER_INC_X;
+		rocket_thrust_inc_y = MOVE_UMETER_INC_Y;
+		rocket_thrust_inc_z = MOVE_UMETER_INC_Z;
 	}
 
-	// Convert joystick to thrust values
+	// Convert joystick to thrust values (per second)
 	if (r_space.rocket_fuel > 0) {
 		// Thruster X is 'on-left or 'on-right' or 'off'
 		r_space.thrust_x = r_control.analog_x - JOYSTICK_X_MID;
 		if (r_space.thrust_x < -JOYSTICK_DELTA_XY_MIN) {
-			r_space.rocket_delta_x -= rocket_thrust_inc_x;
+			accel_x -= rocket_thrust_inc_x;
 			rocket_fuel_used += FUEL_X_INC;
 		}
 		if (r_space.thrust_x > JOYSTICK_DELTA_XY_MIN ) {
-			r_space.rocket_delta_x += rocket_thrust_inc_x;
+			accel_x += rocket_thrust_inc_x;
 			rocket_fuel_used += FUEL_X_INC;
 		}
 
 		// Thruster Y is 'on-forward or 'on-backward' or 'off'
 		r_space.thrust_y = r_control.analog_y - JOYSTICK_Y_MID;
 		if (r_space.thrust_y < -JOYSTICK_DELTA_XY_MIN) {
-			r_space.rocket_delta_y -= rocket_thrust_inc_y;
+			accel_y -= rocket_thrust_inc_y;
 			rocket_fuel_used += FUEL_Y_INC;
 		}
 		if (r_space.thrust_y > JOYSTICK_DELTA_XY_MIN ) {
-			r_space.rocket_delta_y += rocket_thrust_inc_y;
+			accel_y += rocket_thrust_inc_y;
 			rocket_fuel_used += FUEL_Y_INC;
 		}
 
 		// Thruster Z is 'proportion-up or 'proportion-down' or 'off'
 		r_space.thrust_z = r_control.analog_z - JOYSTICK_Z_MID;
 		if (r_space.thrust_z < -JOYSTICK_DELTA_Z_MIN) {
-			r_space.rocket_delta_z += (r_space.thrust_z+JOYSTICK_DELTA_Z_MIN)*rocket_thrust_inc_z;
+			accel_z += (r_space.thrust_z+JOYSTICK_DELTA_Z_MIN)*rocket_thrust_inc_z;
 			rocket_fuel_used += FUEL_Z_INC;
 		}
 		if (r_space.thrust_z > JOYSTICK_DELTA_Z_MIN) {
-			r_space.rocket_delta_z += (r_space.thrust_z-JOYSTICK_DELTA_Z_MIN)*rocket_thrust_inc_z;
+			accel_z += (r_space.thrust_z-JOYSTICK_DELTA_Z_MIN)*rocket_thrust_inc_z;
 			rocket_fuel_used += FUEL_Z_INC;
 		}
 	}
 
-	r_space.rocket_goal_x += r_space.rocket_delta_x;
-	r_space.rocket_goal_y += r_space.rocket_delta_y;
-	r_space.rocket_goal_z += r_space.rocket_delta_z;
+	if (GAME_XYZ_MOVE != r_game.game) {
+		// Apply the thrust to the speed
+		r_space.rocket_delta_x += rocket_frame_scale(accel_x,&r_space.rocket_rem_dx);
+		r_space.rocket_delta_y += rocket_frame_scale(accel_y,&r_space.rocket_rem_dy);
+		r_space.rocket_delta_z += rocket_frame_scale(accel_z,&r_space.rocket_rem_dz);
+	} else {
+		// Cancel any inertial and gravity motion, the thrust is the speed
+		r_space.rocket_delta_x = accel_x;
+		r_space.rocket_delta_y = accel_y;
+		r_space.rocket_delta_z = accel_z;
+	}
+
+	// Apply the speed to the position
+	r_space.rocket_goal_x += rocket_frame_scale(r_space.rocket_delta_x,&r_space.rocket_rem_x);
+	r_space.rocket_goal_y += rocket_frame_scale(r_space.rocket_delta_y,&r_space.rocket_rem_y);
+	r_space.rocket_goal_z += rocket_frame_scale(r_space.rocket_delta_z,&r_space.rocket_rem_z);
 
 	if (GAME_XYZ_MOVE != r_game.game) {
 		// Acceleration due to gravity
 //		if (r_space.rocket_delta_z) printf("Z=%d,x%d\n",r_space.rocket_delta_z,r_space.thrust_z);
 		if (GAME_GRAVITY_NONE != r_game.gravity_option) {
-			r_space.rocket_delta_z -= r_space.gravity_delta;
+			// add the negated rate, so that the shared Z remainder keeps one sign convention
+			r_space.rocket_delta_z += rocket_frame_scale(-r_space.gravity_delta,&r_space.rocket_rem_dz);
 		}
 	} else {
 		// Cancel any inertial and gravity motion, also any fuel usage
@@ -386,7 +437,7 @@ void compute_rocket_next_position ()
 	}
 
 	// Burn that fuel
-	r_space.rocket_fuel -= rocket_fuel_used;
+	r_space.rocket_fuel -= rocket_frame_scale(rocket_fuel_used,&r_space.rocket_rem_fuel);
 	if ((GAME_FUEL_NOLIMIT == r_game.fuel_option) || (GAME_XYZ_MOVE == r_game.game)) {
 		if (r_space.rocket_fuel < 100) r_space.rocket_fuel = FUEL_SUPPLY_INIT;
 	}
@@ -416,6 +467,7 @@ void compute_rocket_next_position ()
 		r_space.rocket_goal_z = GAME_Z_POS_MAX;
 		if (r_space.rocket_delta_z > 0) r_space.rocket_delta_z = 0;
 	}
+	prof_stop(PROF_KINEMATICS,prof_cycles);
  }
 
 
@@ -444,11 +496,11 @@ static void do_compute_cable_length(int32_t tower,boolean verbose) {
 //	r_towers[tower].length_goal = sqrt_rocket((x*x)+(y*y)+(z*z)) * 100L;
 
 	if (false && verbose) {
-		printf("Tower[%d]:%ld,%ld,%ld\n",tower,x,y,z);
-		printf(" x=%ld-%ld+%ld\n",r_space.rocket_goal_x,r_towers[tower].pos_x,r_towers[tower].mount_pos_x);
-		printf(" y=%ld-%ld+%ld\n",r_space.rocket_goal_y,r_towers[tower].pos_y,r_towers[tower].mount_pos_y);
-		printf(" z=%ld-%ld+%ld\n",r_space.rocket_goal_z,r_towers[tower].pos_z,r_towers[tower].mount_pos_z);
-		printf(" l=%ld\n",r_towers[tower].length_goal);
+		printf("Tower[%d]:%d,%d,%d\n",tower,x,y,z);
+		printf(" x=%d-%d+%d\n",r_space.rocket_goal_x,r_towers[tower].pos_x,r_towers[tower].mount_pos_x);
+		printf(" y=%d-%d+%d\n",r_space.rocket_goal_y,r_towers[tower].pos_y,r_towers[tower].mount_pos_y);
+		printf(" z=%d-%d+%d\n",r_space.rocket_goal_z,r_towers[tower].pos_z,r_towers[tower].mount_pos_z);
+		printf(" l=%d\n",r_towers[tower].length_goal);
 	}
 
 	// compute the matching step goal count
@@ -459,10 +511,12 @@ static void do_compute_cable_length(int32_t tower,boolean verbose) {
 
 void compute_rocket_cable_lengths ()
  {
+	uint32_t prof_cycles = prof_start();
  	do_compute_cable_length(ROCKET_TOWER_NW,false);
  	do_compute_cable_length(ROCKET_TOWER_NE,false);
  	do_compute_cable_length(ROCKET_TOWER_SW,false);
  	do_compute_cable_length(ROCKET_TOWER_SE,false);
+	prof_stop(PROF_CABLES,prof_cycles);
  }
 
 void compute_rocket_cable_lengths_verbose ()
@@ -490,9 +544,10 @@ void set_rocket_position ()
 	r_towers[ROCKET_TOWER_SE].step_count =  micrometers2steps(ROCKET_TOWER_SE,r_towers[ROCKET_TOWER_SE].length_goal);
 
 	if (IO_MOTOR_ENABLE && (GAME_SIMULATE != r_game.game_mode)) {
-		rocket_position_send();
-		rocket_command_send(ROCKET_MOTOR_CMD_PRESET);
-
+		// the preset replaces any unsent increments, and is retried by a resync if not sent
+		memset(increment_unsent,0,sizeof(increment_unsent));
+		if (!rocket_position_send() || !rocket_command_send(ROCKET_MOTOR_CMD_PRESET))
+			motor_resync = true;
 	}
 	if (IO_TRACKER_FOLLOW_ENABLE) {
  		// update Antennae
@@ -537,6 +592,8 @@ static void do_move_tower(struct ROCKET_TOWER_S *tower) {
 
 void move_rocket_next_position ()
  {
+	uint32_t prof_cycles = prof_start();
+
 	r_space.rocket_x = r_space.rocket_goal_x;
 	r_space.rocket_y = r_space.rocket_goal_y;
 	r_space.rocket_z = r_space.rocket_goal_z;
@@ -550,8 +607,9 @@ void move_rocket_next_position ()
 		if (r_towers[ROCKET_TOWER_NW].step_diff ||
 		    r_towers[ROCKET_TOWER_NE].step_diff ||
 		    r_towers[ROCKET_TOWER_SW].step_diff ||
-		    r_towers[ROCKET_TOWER_SE].step_diff) {
-			// there is movement for the rocket
+		    r_towers[ROCKET_TOWER_SE].step_diff ||
+		    rocket_increment_pending()) {
+			// there is movement for the rocket (or some still to send)
 			rocket_increment_send(
 				r_towers[ROCKET_TOWER_NW].step_diff,
 				r_towers[ROCKET_TOWER_NE].step_diff,
@@ -560,27 +618,49 @@ void move_rocket_next_position ()
 		    }
 	}
 
-	// update Antennae
-	if (IO_TRACKER_FOLLOW_ENABLE) {
+	// update Antennae (else the output task follows the published position)
+	if (IO_TRACKER_FOLLOW_ENABLE && !IO_TASKS_ENABLE) {
 		antenna_update();
 	}
-
+	prof_stop(PROF_MOVE,prof_cycles);
 
  }
 
 /*
- * query_rocket_progress : query and return progress of rocket motion (in percent)
+ * query_rocket_progress : return progress of rocket motion (in percent)
+ *
+ *  Never blocks the physics task: returns the answer to the last completed query
+ *  (101 until there is one), and queues the next query once that one has landed.
+ *  Commands that the motor board has not yet executed count as not done
  *
  */
 
 uint8_t query_rocket_progress ()
  {
+	static struct IO_FUTURE_S progress;
+	static bool progress_init = false;
+	static uint8_t progress_last = 101;
 	uint8_t buf[10];
-	uint32_t len = 1;
 
 	if (IO_MOTOR_ENABLE) {
-		buf[0] = (uint8_t) 101;
-		i2c_read(i2c,buf,len,ROCKET_MOTOR_I2C_ADDRESS);
+		if (!progress_init) {
+			io_future_init(&progress);
+			progress_init = true;
+		}
+		if (!progress.pending) {
+			if (DEV_OK != progress.rc) {
+				progress_last = 101;
+			} else if ((progress.len > 0) &&
+				rocket_status_parse(progress.buf, progress.len)) {
+				progress_last = r_motor_status.progress;
+				// a command still queued on the motor board means the move is not done
+				if ((r_motor_status.flags & ROCKET_MOTOR_FLAG_CMD_PENDING) && (progress_last >= 100))
+					progress_last = 99;
+			}
+			// queued behind the motor commands already sent, so the answer includes them
+			io_in_i2c(ROCKET_MOTOR_I2C_ADDRESS, ROCKET_MOTOR_STATUS_LEN, IO_PRIO_MOTOR, &progress);
+		}
+		buf[0] = progress_last;
 	} else {
 		if ((r_space.rocket_x == r_space.rocket_goal_x) &&
 	    	(r_space.rocket_y == r_space.rocket_goal_y) &&
@@ -593,81 +673,240 @@ uint8_t query_rocket_progress ()
 	return(buf[0]);
  }
 
+/*
+ * status_get16 : fetch a 16-bit status frame value (MSB first)
+ *
+ */
+
+static uint16_t status_get16 (uint8_t *buf, uint8_t offset)
+ {
+	return((uint16_t) ((buf[offset] << 8) | buf[offset+1]));
+ }
+
+/*
+ * rocket_status_parse : validate a motor board status frame, and unpack it into r_motor_status
+ *
+ */
+
+bool rocket_status_parse (uint8_t *buf, uint32_t len)
+ {
+	uint8_t sum=0;
+	uint8_t i;
+
+	for (i=0;(i<len) && (i<ROCKET_MOTOR_STATUS_LEN);i++) {
+		sum += buf[i];
+	}
+	if ((ROCKET_MOTOR_STATUS_LEN != len) ||
+		(ROCKET_MOTOR_STATUS_VERSION != buf[ROCKET_MOTOR_STATUS_VERSION_OFFSET]) ||
+		(0 != sum)) {
+		r_motor_status.frames_bad++;
+		return false;
+	}
+
+	r_motor_status.progress         = buf[ROCKET_MOTOR_STATUS_PROGRESS];
+	r_motor_status.sequence         = buf[ROCKET_MOTOR_STATUS_SEQUENCE];
+	r_motor_status.flags            = buf[ROCKET_MOTOR_STATUS_FLAGS];
+	r_motor_status.cmd_overflow     = buf[ROCKET_MOTOR_STATUS_CMD_OVERFLOW];
+	r_motor_status.rocket_remain_ms = status_get16(buf,ROCKET_MOTOR_STATUS_ROCKET_REMAIN);
+	r_motor_status.ground_remain_ms = status_get16(buf,ROCKET_MOTOR_STATUS_GROUND_REMAIN);
+	for (i=0;i<ROCKET_TOWER_MAX;i++) {
+		r_motor_status.location[i]    = status_get16(buf,ROCKET_MOTOR_STATUS_LOCATION    + (i*2));
+		r_motor_status.destination[i] = status_get16(buf,ROCKET_MOTOR_STATUS_DESTINATION + (i*2));
+	}
+	r_motor_status.rocket_errors    = status_get16(buf,ROCKET_MOTOR_STATUS_ROCKET_ERRORS);
+	r_motor_status.ground_errors    = status_get16(buf,ROCKET_MOTOR_STATUS_GROUND_ERRORS);
+	r_motor_status.ground_moving    = status_get16(buf,ROCKET_MOTOR_STATUS_GROUND_MOVING);
+	r_motor_status.frames++;
+	return true;
+ }
+
+/*
+ * motor_send_done : completion of a motor board command, from the output task
+ *
+ *  A command that was queued but then failed (e.g. the motor board is marked dead)
+ *  leaves the boards disagreeing on the positions, so the next frame resyncs them
+ *
+ */
+
+static void motor_send_done(int32_t rc) {
+	if (DEV_OK != rc) {
+		r_motor_status.sends_lost++;
+		motor_resync = true;
+	}
+}
+
+static void ground_send_done(int32_t rc) {
+	if (DEV_OK != rc) {
+		r_motor_status.sends_lost++;
+		ground_resync = true;
+	}
+}
+
+/*
+ * motor_send : queue a motor board command, false (and resync later) if it was dropped
+ *
+ */
+
+static bool motor_send(uint8_t *buf, uint16_t len) {
+	if (io_out_i2c(ROCKET_MOTOR_I2C_ADDRESS, buf, len, IO_PRIO_MOTOR, motor_send_done))
+		return true;
+	r_motor_status.sends_lost++;
+	return false;
+}
+
+/*
+ * rocket_motor_resync : preset the motor board to the main board's positions
+ *
+ *  Replaces the unsent increments, which the positions already include
+ *
+ */
+
+static void rocket_motor_resync ()
+ {
+	uint8_t i;
+
+	motor_resync = false;
+	if (rocket_position_send() && rocket_command_send(ROCKET_MOTOR_CMD_PRESET)) {
+		for (i=0;i<ROCKET_TOWER_MAX;i++) {
+			increment_unsent[i] = 0;
+		}
+		r_motor_status.resyncs++;
+	} else {
+		motor_resync = true;
+	}
+ }
+
 /*
  * rocket_increment_send : increment a rocket motor
  *
+ *  An increment too large for the 16-bit command is sent in parts, which the
+ *  motor board adds together (as for any increments that arrive during a move).
+ *  What cannot be queued is kept, and sent with the next frame's increment. A
+ *  command lost after it was queued is recovered by a resync.
+ *
  */
 
 void rocket_increment_send (int32_t increment_nw, int32_t increment_ne, int32_t increment_sw, int32_t increment_se)
  {
-	uint8_t buf[10];
+	uint32_t prof_cycles = prof_start();
+	uint8_t buf[12];
+	int32_t *increment = increment_unsent;
+	int32_t part[ROCKET_TOWER_MAX];
+	uint8_t i;
+
+	increment[ROCKET_TOWER_NW] += increment_nw;
+	increment[ROCKET_TOWER_NE] += increment_ne;
+	increment[ROCKET_TOWER_SW] += increment_sw;
+	increment[ROCKET_TOWER_SE] += increment_se;
+
+	if (motor_resync) {
+		rocket_motor_resync();
+		prof_stop(PROF_MOTOR,prof_cycles);
+		return;
+	}
 
-	// only move if something changed
-	if (increment_nw || increment_ne || increment_sw || increment_se) {
+	// send until none is left (nothing, if nothing changed)
+	while (increment[ROCKET_TOWER_NW] || increment[ROCKET_TOWER_NE] ||
+		   increment[ROCKET_TOWER_SW] || increment[ROCKET_TOWER_SE]) {
 		buf[0]=(uint8_t) ROCKET_MOTOR_CMD_NEXT;
-		buf[1]=(uint8_t) ((increment_nw & 0x00ff00L) >> 8);
-		buf[2]=(uint8_t) ((increment_nw & 0x0000ffL)     );
-		buf[3]=(uint8_t) ((increment_ne & 0x00ff00L) >> 8);
-		buf[4]=(uint8_t) ((increment_ne & 0x0000ffL)     );
-		buf[5]=(uint8_t) ((increment_sw & 0x00ff00L) >> 8);
-		buf[6]=(uint8_t) ((increment_sw & 0x0000ffL)     );
-		buf[7]=(uint8_t) ((increment_se & 0x00ff00L) >> 8);
-		buf[8]=(uint8_t) ((increment_se & 0x0000ffL)     );
-		i2c_polling_write (i2c, buf, 9, ROCKET_MOTOR_I2C_ADDRESS);
+		for (i=0;i<ROCKET_TOWER_MAX;i++) {
+			part[i] = increment[i];
+			if (part[i] >  ROCKET_MOTOR_INCREMENT_MAX) part[i] =  ROCKET_MOTOR_INCREMENT_MAX;
+			if (part[i] < -ROCKET_MOTOR_INCREMENT_MAX) part[i] = -ROCKET_MOTOR_INCREMENT_MAX;
+			buf[1+(i*2)]=(uint8_t) ((part[i] & 0x00ff00L) >> 8);
+			buf[2+(i*2)]=(uint8_t) ((part[i] & 0x0000ffL)     );
+		}
+		// the frame period (mSec) over which to spread the move
+		buf[9] =(uint8_t) ((r_game.frame_ms & 0x00ff00L) >> 8);
+		buf[10]=(uint8_t) ((r_game.frame_ms & 0x0000ffL)     );
+		if (!motor_send(buf, 11))
+			break;
+		for (i=0;i<ROCKET_TOWER_MAX;i++) {
+			increment[i] -= part[i];
+		}
 	}
+	prof_stop(PROF_MOTOR,prof_cycles);
  }
 
 /*
- * rocket_position_send : send the motor positions
+ * rocket_increment_pending : true if there are unsent increments or a resync to send
  *
  */
 
-void rocket_position_send ()
+bool rocket_increment_pending ()
+ {
+	return (motor_resync ||
+		increment_unsent[ROCKET_TOWER_NW] || increment_unsent[ROCKET_TOWER_NE] ||
+		increment_unsent[ROCKET_TOWER_SW] || increment_unsent[ROCKET_TOWER_SE]);
+ }
+
+/*
+ * rocket_position_send : send the motor positions, return false if it was dropped
+ *
+ *  The positions are unsigned 16-bit microsteps, saturated rather than wrapped
+ *
+ */
+
+bool rocket_position_send ()
  {
 	uint8_t buf[10];
+	int32_t position;
+	uint8_t i;
+
 	buf[0]=(uint8_t) 'l';
-	buf[1]=(uint8_t) ((r_towers[ROCKET_TOWER_NW].step_count & 0x00ff00L) >> 8);
-	buf[2]=(uint8_t) ((r_towers[ROCKET_TOWER_NW].step_count & 0x0000ffL)     );
-	buf[3]=(uint8_t) ((r_towers[ROCKET_TOWER_NE].step_count & 0x00ff00L) >> 8);
-	buf[4]=(uint8_t) ((r_towers[ROCKET_TOWER_NE].step_count & 0x0000ffL)     );
-	buf[5]=(uint8_t) ((r_towers[ROCKET_TOWER_SW].step_count & 0x00ff00L) >> 8);
-	buf[6]=(uint8_t) ((r_towers[ROCKET_TOWER_SW].step_count & 0x0000ffL)     );
-	buf[7]=(uint8_t) ((r_towers[ROCKET_TOWER_SE].step_count & 0x00ff00L) >> 8);
-	buf[8]=(uint8_t) ((r_towers[ROCKET_TOWER_SE].step_count & 0x0000ffL)     );
-	i2c_polling_write (i2c, buf, 9, ROCKET_MOTOR_I2C_ADDRESS);
+	for (i=0;i<ROCKET_TOWER_MAX;i++) {
+		position = r_towers[i].step_count;
+		if (position < 0) position = 0;
+		if (position > ROCKET_MOTOR_POSITION_MAX) position = ROCKET_MOTOR_POSITION_MAX;
+		buf[1+(i*2)]=(uint8_t) ((position & 0x00ff00L) >> 8);
+		buf[2+(i*2)]=(uint8_t) ((position & 0x0000ffL)     );
+	}
+	return motor_send(buf, 9);
  }
 
 /*
- * ground_position_send : send the ground motor positions
+ * ground_position_send : send the ground motor positions, return false if any was dropped
  * NOTE: actual move defered until explicit rocket_command_send()
  *       rocket motors are numbered 0..3
  *       ground motors are numbered 4..13
+ *       a position is only counted as sent once it is queued, and all are
+ *       sent again after one was lost
  */
 
-void ground_position_send ()
+bool ground_position_send ()
  {
 	uint8_t buf[10];
+	bool resend = ground_resync;
+	bool sent = true;
 
+	ground_resync = false;
 	for (uint8_t i=0;i<ROCKET_GROUND_MAX;i++) {
-		if (r_ground[i].step_count != r_ground[i].step_goal) {
+		if (resend || (r_ground[i].step_count != r_ground[i].step_goal)) {
 			buf[0]=(uint8_t) ((i+4) / 10) + '0';
 			buf[1]=(uint8_t) ((i+4) % 10) + '0';
 			buf[2]=(uint8_t) ((r_ground[i].step_goal & 0x00ff00L) >> 8);
 			buf[3]=(uint8_t) ((r_ground[i].step_goal & 0x0000ffL)     );
-			i2c_polling_write (i2c, buf, 4, ROCKET_MOTOR_I2C_ADDRESS);
-			r_ground[i].step_count = r_ground[i].step_goal;
+			if (io_out_i2c(ROCKET_MOTOR_I2C_ADDRESS, buf, 4, IO_PRIO_MOTOR, ground_send_done)) {
+				r_ground[i].step_count = r_ground[i].step_goal;
+			} else {
+				r_motor_status.sends_lost++;
+				sent = false;
+			}
 		}
 	}
+	if (!sent)
+		ground_resync = resend;
+	return sent;
  }
 
 /*
- * rocket_command_send : send a motor command
+ * rocket_command_send : send a motor command, return false if it was dropped
  *
  */
 
-void rocket_command_send (uint8_t command)
+bool rocket_command_send (uint8_t command)
  {
 	uint8_t buf[10];
 	buf[0]=(uint8_t) command;
-	i2c_polling_write (i2c, buf, 1, ROCKET_MOTOR_I2C_ADDRESS);
+	return motor_send(buf, 1);
  }
@@ -71,25 +71,33 @@
 #define SCALE_GAME_UMETER_TO_MOON_METER 1000
 #define SCALE_GAME_UMETER_TO_MOON_CMETER 10
 
-// Moon Gravity = 1.622 m/s² => 1622 uM/s
-#define GRAVITY_UMETER_PER_SECOND 200
+// All physics rates are per second, and are scaled by the frame's time step (r_game.frame_dt_ms)
+// (The values match the original 5 frames per second tuning)
+
+// Moon Gravity = 1.622 m/s² => 1622 uM/s² (game tuned to 5000 uM/s²)
+#define GRAVITY_UMETER_PER_SECOND 5000
 // Safe Lander <= 1.900 m/s => 1900 uM/s
 #define SAFE_UMETER_PER_SECOND 4000
 
 
-// Thrust power, in mMeters per second
-// Assume XY full thrust provides  5 millimeter/second
-// Assume  Z full thrust provides 10 millimeter/second
-#define THRUST_UMETER_INC_X  5000/TIME_LOOPS_PER_SECOND
-#define THRUST_UMETER_INC_Y  5000/TIME_LOOPS_PER_SECOND
-#define THRUST_UMETER_INC_Z  2000/(JOYSTICK_Z_MAX-JOYSTICK_Z_MID)
+// Thrust power, in uMeters per second per second
+// Assume XY full thrust provides 25 millimeter/second²
+// Assume  Z thrust is proportional to the slider, ~45 millimeter/second² at full
+#define THRUST_UMETER_INC_X  25000L
+#define THRUST_UMETER_INC_Y  25000L
+#define THRUST_UMETER_INC_Z     75L	// per slider count past the dead zone
+
+// Move mode: direct speed in uMeters per second (no inertia)
+#define MOVE_UMETER_INC_X    25000L
+#define MOVE_UMETER_INC_Y    25000L
+#define MOVE_UMETER_INC_Z       15L	// per slider count past the dead zone
 
 // Fuel Units
 // Assume 1 millimeter/second = 1 unit
 #define FUEL_SUPPLY_INIT 1000
-#define FUEL_X_INC         10	// fuel unit to mMeters per second
-#define FUEL_Y_INC         10	// fuel unit to mMeters per second
-#define FUEL_Z_INC         20	// fuel unit to mMeters per second
+#define FUEL_X_INC         50	// fuel units per second of X thrust
+#define FUEL_Y_INC         50	// fuel units per second of Y thrust
+#define FUEL_Z_INC        100	// fuel units per second of Z thrust
 
 
 // Game Space
@@ -100,6 +108,17 @@
 #define ROCKET_TOWER_SE  3
 #define ROCKET_TOWER_MAX 4
 
+#define ROCKET_GROUND_MAX	9		// 3 x 3 grid of ground motors, named by column and row
+
+#define GROUND_X_SIZE	((X_POS_MAX-X_POS_MIN)/3L)	// size of each ground square, in uMeters
+#define GROUND_Y_SIZE	((Y_POS_MAX-Y_POS_MIN)/3L)
+#define GROUND_STEPS_PER_ROTATION	24L	// ground motor steps per spindle rotation
+
+// Position of the Pan&Tilt 'antenna', at the middle of the front edge on the ground
+#define ANTENNA_X_POS	((X_POS_MAX-X_POS_MIN)/2L)
+#define ANTENNA_Y_POS	Y_POS_MIN
+#define ANTENNA_Z_POS	Z_POS_MIN
+
 #define ROCKET_TOWER_NW_ADDR	0x80
 #define ROCKET_TOWER_NE_ADDR	0x81
 #define ROCKET_TOWER_SW_ADDR	0x82
@@ -116,6 +135,11 @@
 
 // Spindle: diameter = 8 mm, circumference = 3.141 * 8 mm = 25.128, uM/step = (25.128 * 1000)/200 = 125.64 uM/step
 #define ROCKET_TOWER_STEP_PER_UM10  1256L // 125.6 * 10 uMx10 per step (grab one more digit of integer math precision)
+
+// Tower microsteps per full step, as set by the motor board's DRV8834 mode pins (1,2,4,8,16)
+// All tower step counts, and the motor board commands, are in microsteps
+#define ROCKET_TOWER_MICROSTEPS    8L
+#define ROCKET_TOWER_REVOLUTION    (ROCKET_TOWER_SPOOL_STEPS * ROCKET_TOWER_MICROSTEPS)
 #define UM10_PER_MILLIMETER        10000L // 1000  * 10 uMx10 per millimeter
 
 // Motor speed: assume auto speed
@@ -150,6 +174,22 @@ struct ROCKET_TOWER_S {
 	int32_t	speed;			// stepper motor speed
 };
 
+struct ROCKET_GROUND_S {
+	const char* name;		// name of the ground square (column,row)
+
+	int32_t	pos_x_min;		// extent of the ground square (uM)
+	int32_t	pos_x_max;
+	int32_t	pos_y_min;
+	int32_t	pos_y_max;
+
+	int32_t	step_count;		// ground motor step count
+	int32_t	step_goal;		// ground motor step goal
+
+	int32_t	um2step_slope;	// linear equation for um per step
+	int32_t	um2step_scaler;	// scale the slope for extra digits of precision
+	int32_t	um2step_offset;	//
+};
+
 struct ROCKET_SPACE_S {
 	int32_t	rocket_x;			// current game-space rocket position, in uMeters
 	int32_t	rocket_y;
@@ -159,17 +199,25 @@ struct ROCKET_SPACE_S {
 	int32_t	rocket_goal_y;
 	int32_t	rocket_goal_z;
 
-	int32_t	rocket_delta_x;		// current game-space rocket speed, in uMeters
+	int32_t	rocket_delta_x;		// current game-space rocket speed, in uMeters per second
 	int32_t	rocket_delta_y;
 	int32_t	rocket_delta_z;
 
+	int32_t	rocket_rem_x;		// sub-uMeter position remainders (uM*mSec), carried between frames
+	int32_t	rocket_rem_y;
+	int32_t	rocket_rem_z;
+	int32_t	rocket_rem_dx;		// sub-uMeter/s speed remainders, carried between frames
+	int32_t	rocket_rem_dy;
+	int32_t	rocket_rem_dz;
+	int32_t	rocket_rem_fuel;	// partial fuel unit remainder
+
 	int32_t	rocket_fuel;		// current fuel level, in fuel units
 
 	int32_t	thrust_x;			// current thruster value, in fuel units
 	int32_t	thrust_y;
 	int32_t	thrust_z;
 
-	int32_t gravity_delta;		// GRAVITY_UMETER_PER_SECOND
+	int32_t gravity_delta;		// GRAVITY_UMETER_PER_SECOND, in uMeters per second per second
 	int32_t	speed_max;			//  minimum usec per step
 };
 
@@ -178,12 +226,60 @@ struct ROCKET_SPACE_S {
 #define ROCKET_MOTOR_CMD_STOP   	's'
 #define ROCKET_MOTOR_CMD_PRESET 	'p'
 #define ROCKET_MOTOR_CMD_DEST   	'd'
-#define ROCKET_MOTOR_CMD_NEXT   	'n'
+#define ROCKET_MOTOR_CMD_NEXT   	'n'	// four step increments, then the frame period in mSec
 #define ROCKET_MOTOR_CMD_NORMAL		'N'
 #define ROCKET_MOTOR_CMD_CALIBRATE	'C'
 
+/* limits of the 16-bit command values */
+#define ROCKET_MOTOR_INCREMENT_MAX	32767L	// largest 'n' increment, larger ones are sent in parts
+#define ROCKET_MOTOR_POSITION_MAX	65535L	// largest 'l' tower position (unsigned)
+
+/* status frame read from the Rocket Motor board (16-bit values are MSB first) */
+#define ROCKET_MOTOR_STATUS_VERSION			1
+#define ROCKET_MOTOR_STATUS_PROGRESS		0	// current move status as percentage completed
+#define ROCKET_MOTOR_STATUS_VERSION_OFFSET	1	// ROCKET_MOTOR_STATUS_VERSION
+#define ROCKET_MOTOR_STATUS_SEQUENCE		2	// incremented for each read
+#define ROCKET_MOTOR_STATUS_FLAGS			3	// ROCKET_MOTOR_FLAG_*
+#define ROCKET_MOTOR_STATUS_ROCKET_REMAIN	4	// rocket move's remaining mSec
+#define ROCKET_MOTOR_STATUS_GROUND_REMAIN	6	// ground move's remaining mSec
+#define ROCKET_MOTOR_STATUS_LOCATION		8	// rocket motor locations NW,NE,SW,SE (unsigned)
+#define ROCKET_MOTOR_STATUS_DESTINATION		16	// rocket motor destinations NW,NE,SW,SE (unsigned)
+#define ROCKET_MOTOR_STATUS_ROCKET_ERRORS	24	// rocket step timing errors
+#define ROCKET_MOTOR_STATUS_GROUND_ERRORS	26	// ground step timing errors
+#define ROCKET_MOTOR_STATUS_GROUND_MOVING	28	// bit per ground motor not yet at its destination
+#define ROCKET_MOTOR_STATUS_CMD_OVERFLOW	30	// dropped commands (saturated)
+#define ROCKET_MOTOR_STATUS_CHECKSUM		31	// all bytes sum to zero
+#define ROCKET_MOTOR_STATUS_LEN				32
+
+#define ROCKET_MOTOR_FLAG_ROCKET_POWER		0x01
+#define ROCKET_MOTOR_FLAG_GROUND_POWER		0x02
+#define ROCKET_MOTOR_FLAG_ROCKET_MOVING		0x04
+#define ROCKET_MOTOR_FLAG_GROUND_MOVING		0x08
+#define ROCKET_MOTOR_FLAG_ROCKET_NEXT		0x10	// a rocket segment is queued
+#define ROCKET_MOTOR_FLAG_CMD_PENDING		0x20	// commands sent but not yet in the frame
+
+struct ROCKET_MOTOR_STATUS_S {
+	uint8_t  progress;			// move percent done
+	uint8_t  sequence;			// frame sequence number
+	uint8_t  flags;				// ROCKET_MOTOR_FLAG_*
+	uint8_t  cmd_overflow;		// commands dropped by the motor board
+	uint16_t rocket_remain_ms;	// remaining move time
+	uint16_t ground_remain_ms;
+	uint16_t location[ROCKET_TOWER_MAX];	// tower motor microsteps
+	uint16_t destination[ROCKET_TOWER_MAX];
+	uint16_t rocket_errors;		// step timing errors
+	uint16_t ground_errors;
+	uint16_t ground_moving;		// bit per ground motor
+	uint32_t frames;			// valid frames received
+	uint32_t frames_bad;		// frames with a bad version or checksum
+	uint32_t sends_lost;		// commands dropped, or that failed after they were queued
+	uint32_t resyncs;			// position presets sent to recover from lost commands
+};
+
 extern struct ROCKET_SPACE_S r_space;
 extern struct ROCKET_TOWER_S r_towers[ROCKET_TOWER_MAX];
+extern struct ROCKET_GROUND_S r_ground[ROCKET_GROUND_MAX];
+extern struct ROCKET_MOTOR_STATUS_S r_motor_status;
 
 bool init_rocket_hardware();
 void init_rocket_game (int32_t pos_x, int32_t pos_y, int32_t pos_z, int32_t fuel, int32_t gravity, int32_t mode);
@@ -194,10 +290,14 @@ void compute_rocket_cable_lengths_verbose();
 void move_rocket_next_position();
 void simulate_move_rocket_next_position();
 uint8_t query_rocket_progress();
+bool rocket_status_parse(uint8_t *buf, uint32_t len);
 void rocket_increment_send(int32_t increment_nw, int32_t increment_ne, int32_t increment_sw, int32_t increment_se);
+int32_t rocket_frame_scale(int32_t per_second, int32_t *remainder);
 
 void set_rocket_position();
-void rocket_position_send();
-void rocket_command_send(uint8_t command);
+bool rocket_increment_pending();
+bool rocket_position_send();
+bool ground_position_send();
+bool rocket_command_send(uint8_t command);
 
 
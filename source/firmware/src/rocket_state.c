@@ -48,6 +48,16 @@
 #include "rocket_space.h"
 #include "rocket_state.h"
 #include "rocket_math.h"
+#include "rocket_lcd.h"
+#include "rocket_hist.h"
+#include "rocket_trace.h"
+#include "rocket_frame.h"
+#include "rocket_profile.h"
+#include "rocket_checkpoint.h"
+#include "rocket_log.h"
+#include "rocket_io.h"
+#include "rocket_button.h"
+#include "rocket_bench.h"
 
 
 /*
@@ -59,7 +69,6 @@
 static uint32_t StateGuiCount=0;
 static char buffer[1000];
 
-#define StateGuiMax 160
 struct StateGuiRec state_array[StateGuiMax];
 int32_t state_now=0;	// current state
 char * state_next_frame=NULL;	// optional state next loop
@@ -67,6 +76,7 @@ static int32_t  state_prev;	// Previous state name (for pause/resume)
 
 static void display_state();
 static int32_t find_state(char *select_state);
+static void layout_line_2(char *layout,char *display_2);
 
 static int16_t state_depth=0;
 
@@ -92,6 +102,7 @@ static void StateGuiAdd(char *state_name,uint32_t flags,char *display_1,char *di
 	state_array[StateGuiCount].state_flags = flags;			// Optional state flags
 	strcpy(state_array[StateGuiCount].display_1,display_1); 	// Display string Line 1 (16 chars) (empty string for no change)
 	strcpy(state_array[StateGuiCount].display_2,display_2); 	// Display string Line 2 (16 chars)
+	layout_line_2(state_array[StateGuiCount].layout_2,display_2);	// Display Line 2, padded and menu-reversed
 	state_array[StateGuiCount].k1 = k1;						// Key1 goto state name (Use <STATE_NOP> for no action)
 	state_array[StateGuiCount].k2 = k2;						// Key2 goto state name
 	state_array[StateGuiCount].state_enter = state_enter;	// Callback on state entry (Use <ACTION_NOP> for no action)
@@ -100,100 +111,134 @@ static void StateGuiAdd(char *state_name,uint32_t flags,char *display_1,char *di
 	StateGuiCount++;
 }
 
+/* copy at most one LCD line of text, always terminated */
+static void lcd_line_copy(char *line,char *text) {
+	int32_t i;
+
+	for (i=0;(i<LCD_DISPLAY_POS_MAX) && ('\0' != text[i]);i++)
+		line[i] = text[i];
+	line[i] = '\0';
+}
+
 void set_lcd_display(int32_t line,char *buffer) {
 	if (LCD_BUFFER_1 == line) {
-		strncpy(state_array[state_now].display_1,buffer,LCD_DISPLAY_POS_MAX);
-		state_array[state_now].display_1[LCD_DISPLAY_POS_MAX]='\0';
+		lcd_line_copy(state_array[state_now].display_1,buffer);
 	}
 	if (LCD_BUFFER_2 == line) {
-		strncpy(state_array[state_now].display_2,buffer,LCD_DISPLAY_POS_MAX);
-		state_array[state_now].display_2[LCD_DISPLAY_POS_MAX]='\0';
+		lcd_line_copy(state_array[state_now].display_2,buffer);
+		layout_line_2(state_array[state_now].layout_2,state_array[state_now].display_2);
+	}
+}
+
+/* overwrite a field within the current display line (e.g. a compass name) */
+static void set_lcd_display_field(int32_t line,uint8_t pos,const char *field,uint8_t len) {
+	char text[LCD_DISPLAY_POS_MAX+1];
+
+	if (pos >= LCD_DISPLAY_POS_MAX)
+		return;
+	if ((pos+len) > LCD_DISPLAY_POS_MAX)
+		len = LCD_DISPLAY_POS_MAX - pos;
+	sprintf(text,"%-16.16s",(LCD_BUFFER_1 == line) ? state_array[state_now].display_1 : state_array[state_now].display_2);
+	memcpy(&text[pos],field,len);
+	set_lcd_display(line,text);
+}
+
+/*
+ * layout_line_2 : pad the second line, and flip the menu labels if needed
+ *
+ *  This is resolved when the text is set (at table build or by set_lcd_display)
+ *  and cached with the state, so that display_state() only copies it.
+ *
+ *  Case 1: two strings separated by spaces (normal)
+ *  Case 2: one string on left
+ *  Case 3: one string on right
+ *  Case 4: one long string
+ *  Case 5: no strings, just spaces (e.g. pass through states)
+ *
+ */
+
+static void layout_line_2(char *layout,char *display_2) {
+	char text[LCD_DISPLAY_POS_MAX];
+	uint8_t len=0,first_space=0,last_space=LCD_DISPLAY_POS_MAX-1;
+
+	while ((len < LCD_DISPLAY_POS_MAX) && ('\0' != display_2[len])) len++;
+
+	// empty string for no change
+	if (0 == len) {
+		layout[0] = '\0';
+		return;
 	}
+
+	memcpy(text,display_2,len);
+	memset(&text[len],' ',LCD_DISPLAY_POS_MAX-len);
+	layout[LCD_DISPLAY_POS_MAX]='\0';
+
+	if (!STATE_REVERSE_MENUS) {
+		memcpy(layout,text,LCD_DISPLAY_POS_MAX);
+		return;
+	}
+
+	while ((first_space < LCD_DISPLAY_POS_MAX) && (' ' != text[first_space])) first_space++;
+	while ((last_space > 0) && (' ' != text[last_space])) last_space--;
+
+	memset(layout,' ',LCD_DISPLAY_POS_MAX);
+
+	// first word goes to the right
+	if (first_space > 0)
+		memcpy(&layout[LCD_DISPLAY_POS_MAX-first_space],text,first_space);
+
+	// last word goes to the left
+	if ((last_space < (LCD_DISPLAY_POS_MAX-1)) && (last_space >= first_space))
+		memcpy(layout,&text[last_space+1],(LCD_DISPLAY_POS_MAX-1)-last_space);
+
+	// the middle keeps its place between them
+	if (first_space < last_space)
+		memcpy(&layout[(LCD_DISPLAY_POS_MAX-1)-last_space],&text[first_space],last_space-first_space+1);
 }
 
 static void display_state() {
 	char *display_1 = state_array[state_now].display_1;
-	char *display_2 = state_array[state_now].display_2;
+	char *layout_2  = state_array[state_now].layout_2;
 
 	// protect the display length
 	state_array[state_now].display_1[LCD_DISPLAY_POS_MAX]='\0';
-	state_array[state_now].display_2[LCD_DISPLAY_POS_MAX]='\0';
 
 	// check if inherited state
 	if (0 == strcmp(STATE_INHERIT_S,display_1))
 		display_1 = state_array[state_prev].display_1;
-	if (0 == strcmp(STATE_INHERIT_S,display_2))
-		display_2 = state_array[state_prev].display_2;
+	if (0 == strcmp(STATE_INHERIT_S,state_array[state_now].display_2))
+		layout_2 = state_array[state_prev].layout_2;
 
 	if (0 < strlen(display_1)) {
 		// pad if not empty
 		sprintf(r_control.lcd_line0,"%-16s",display_1);
-	} else {
-		display_1[0] = '\0';
 	}
 
-	if (0 < strlen(display_2))
-		// pad and/or reverse if not empty
-		if (STATE_REVERSE_MENUS) {
-			// flip the menu labels,
-			// Case 1: two strings separated by spaces (normal)
-			// Case 2: one string on left
-			// Case 3: one string on right
-			// Case 4: one long string
-			// Case 5: no strings, just spaces (e.g. pass through states)
-			uint8_t first_space=0,last_space=15,i;
-
-			for (i=0;i<=32;i++) buffer[i]=' ';
-			sprintf(&buffer[16],"%-16s",display_2);
-
-			while ((' ' != buffer[16+first_space]) && (first_space<16)) first_space++;
-			while ((' ' != buffer[16+last_space ]) && (last_space > 0)) last_space--;
-
-			if (first_space > 0)
-				strncpy(&buffer[16-first_space],&buffer[16],first_space);
-
-			if ((last_space < 15) && (last_space >= first_space))
-				strncpy(buffer,&buffer[16+last_space+1],15-last_space);
-
-			if (first_space < last_space)
-				strncpy(&buffer[15-last_space],&buffer[16+first_space],last_space-first_space+1);
-
-			buffer[16]='\0';
-			strcpy(r_control.lcd_line1,buffer);
-		} else {
-			sprintf(r_control.lcd_line1,"%-16s",display_2);
-		}
-	else {
-		display_2[0] = '\0';
+	// the second line is already padded and/or reversed
+	if (0 < strlen(layout_2)) {
+		strcpy(r_control.lcd_line1,layout_2);
 	}
 
 	if (verbose && (0x0000 == (state_array[state_now].state_flags & STATE_NO_VERBOSE))) {
-		log("\n");
-		sprintf(buffer,"/----------------\\ State=%s, Depth=%d\n",state_array[state_now].state_name,state_depth);
-		log(buffer);
-		sprintf(buffer,"|%s|\n",r_control.lcd_line0);
-		log(buffer);
-		sprintf(buffer,"|%s|\n",r_control.lcd_line1);
-		log(buffer);
-		log("\\----------------/\n");
-		sprintf(buffer,"1:=%s, 2=%s\n",
+		RLOG_INF(LOG_F_STATE_TOP,state_array[state_now].state_name,state_depth);
+		RLOG_TEXT(LOG_LEVEL_INF,LOG_F_STATE_LINE,r_control.lcd_line0);
+		RLOG_TEXT(LOG_LEVEL_INF,LOG_F_STATE_LINE,r_control.lcd_line1);
+		RLOG_INF(LOG_F_STATE_BOTTOM);
+		RLOG_INF(LOG_F_STATE_KEYS,
 			(STATE_NOP == state_array[state_now].k1)?"None":state_array[state_now].k1,
 			(STATE_NOP == state_array[state_now].k2)?"None":state_array[state_now].k2);
-		log(buffer);
 	}
 
-	// Send text to screen
-	if (IO_LCD_ENABLE) {
-		if (strlen(r_control.lcd_line0)) groveLcdPrint(i2c, 0, 0, r_control.lcd_line0, strlen(r_control.lcd_line0));
-		if (strlen(r_control.lcd_line1)) groveLcdPrint(i2c, 1, 0, r_control.lcd_line1, strlen(r_control.lcd_line1));
-	}
+	// Send text to the framebuffer, the changes are sent at the end of the frame
+	if (strlen(r_control.lcd_line0)) lcd_fb_line(0, r_control.lcd_line0);
+	if (strlen(r_control.lcd_line1)) lcd_fb_line(1, r_control.lcd_line1);
 }
 
 static int32_t find_state(char *select_state) {
 	int32_t i;
 	if (STATE_NOP == select_state)
 		return STATE_NOT_FOUND;
-	for (i=0;i<StateGuiMax;i++) {
+	for (i=0;i<StateGuiCount;i++) {
 		if (0 == strcmp(select_state,state_array[i].state_name))
 			return i;
 	}
@@ -201,8 +246,6 @@ static int32_t find_state(char *select_state) {
 }
 
 static void do_goto_state(char *select_state_name, bool skip_display) {
-	int32_t display_this_state=true;
-
 	// increment the state depth
 	state_depth++;
 
@@ -230,23 +273,25 @@ static void do_goto_state(char *select_state_name, bool skip_display) {
 
 	// execute any state epilog function
 	if (ACTION_NOP != state_array[state_now].state_exit) {
+		int32_t exit_state=state_now;
+		uint32_t trace_cycles=trace_start();
 		state_array[state_now].state_exit();
+		trace_stop(exit_state,TRACE_EXIT,trace_cycles);
 	}
 
 	// assert new state
 	state_prev= state_now;
 	state_now = state_next;
+	trace_transition(state_prev,state_now);
 
-	log_val("NEW_STATE=%s\n",state_array[state_now].state_name);
+	RLOG_INF(LOG_F_NEW_STATE,state_array[state_now].state_name);
 
 	// execute any state prolog function
 	if (ACTION_NOP != state_array[state_now].state_enter) {
 		int32_t expected_state=state_now;
+		uint32_t trace_cycles=trace_start();
 		state_array[state_now].state_enter();
-		// See if the callback changed the state
-		if (state_now != expected_state) {
-			display_this_state=false;
-		}
+		trace_stop(expected_state,TRACE_ENTER,trace_cycles);
 	}
 
 	// display the new state
@@ -285,13 +330,13 @@ void next_state(char *select_state_name) {
 static struct CompassRec calibrate_compass;
 
 static void display_motor_status (char *msg) {
-	PRINT("\n%s:NW=%ld, NE=%ld, SW=%ld, SE=%ld\n",
+	PRINT("\n%s:NW=%d, NE=%d, SW=%d, SE=%d\n",
 		msg,
 		r_towers[ROCKET_TOWER_NW].step_count,
 		r_towers[ROCKET_TOWER_NE].step_count,
 		r_towers[ROCKET_TOWER_SW].step_count,
 		r_towers[ROCKET_TOWER_SE].step_count);
-	PRINT("        nm :NW=%ld, NE=%ld, SW=%ld, SE=%ld\n\n",
+	PRINT("        nm :NW=%d, NE=%d, SW=%d, SE=%d\n\n",
 		r_towers[ROCKET_TOWER_NW].length,
 		r_towers[ROCKET_TOWER_NE].length,
 		r_towers[ROCKET_TOWER_SW].length,
@@ -318,7 +363,7 @@ static void S_Calibrate_Init_enter () {
 static void S_CalibrateHome_loop () {
 	// measure against the calibration compass
 	compass_select(COMPASS_CALC_HOME,&calibrate_compass);
-	strncpy(&state_array[state_now].display_2[5],calibrate_compass.name,2);
+	set_lcd_display_field(LCD_BUFFER_2,5,calibrate_compass.name,2);
 	display_state();
 
 	// send the increment
@@ -337,7 +382,7 @@ static void S_CalibrateHome_Done_enter () {
 	// And go back to normal mode
 	rocket_command_send(ROCKET_MOTOR_CMD_NORMAL);
 
-	if (DEBUG_VERBOSE_MOVE) PRINT("At Home: (%6ld,%6ld,%6ld) NW=(%6ld,%6ld),NE=(%6ld,%6ld),SW=(%6ld,%6ld),SE=(%6ld,%6ld)\n",
+	if (DEBUG_VERBOSE_MOVE) PRINT("At Home: (%6d,%6d,%6d) NW=(%6d,%6d),NE=(%6d,%6d),SW=(%6d,%6d),SE=(%6d,%6d)\n",
 		micro2millimeter(r_space.rocket_goal_x),micro2millimeter(r_space.rocket_goal_y),micro2millimeter(r_space.rocket_goal_z),
 		micro2millimeter(r_towers[ROCKET_TOWER_NW].length), r_towers[ROCKET_TOWER_NW].step_count,
 		micro2millimeter(r_towers[ROCKET_TOWER_NE].length), r_towers[ROCKET_TOWER_NE].step_count,
@@ -369,7 +414,7 @@ static void S_Calibrate_Position_enter () {
 static void S_Calibrate_Position_loop () {
 	// measure against the calibration compass
 	compass_select(COMPASS_CALC_POS,&calibrate_compass);
-	strncpy(&state_array[state_now].display_2[5],calibrate_compass.name,5);
+	set_lcd_display_field(LCD_BUFFER_2,5,calibrate_compass.name,5);
 	display_state();
 }
 
@@ -377,7 +422,7 @@ static void S_Calibrate_Position_Go_enter () {
 	const char *name = calibrate_compass.name;
 
 	// ############# TODO DEBUG CODE
-	PRINT("MOVE_TO:%s at (%6ld,%6ld,%6ld)\n",
+	PRINT("MOVE_TO:%s at (%6d,%6d,%6d)\n",
 		name,micro2millimeter(calibrate_compass.x),micro2millimeter(calibrate_compass.y),micro2millimeter(calibrate_compass.z));
 
 	// fly the rocket to this position
@@ -389,13 +434,15 @@ static void S_Calibrate_Position_Go_enter () {
 
 static void S_Flight_Linear_loop () {
 	if (r_flight.frame_count >= r_flight.frame_max) {
-		if (DEBUG_VERBOSE_MOVE) PRINT("Now at:(%6ld,%6ld,%6ld) NW=(%6ld,%6ld),NE=(%6ld,%6ld),SW=(%6ld,%6ld),SE=(%6ld,%6ld)\n",
-			micro2millimeter(r_space.rocket_x),micro2millimeter(r_space.rocket_y),micro2millimeter(r_space.rocket_z),
-			micro2millimeter(r_towers[ROCKET_TOWER_NW].length), r_towers[ROCKET_TOWER_NW].step_count,
-			micro2millimeter(r_towers[ROCKET_TOWER_NE].length), r_towers[ROCKET_TOWER_NE].step_count,
-			micro2millimeter(r_towers[ROCKET_TOWER_SW].length), r_towers[ROCKET_TOWER_SW].step_count,
-			micro2millimeter(r_towers[ROCKET_TOWER_SE].length), r_towers[ROCKET_TOWER_SE].step_count
-			);
+		if (DEBUG_VERBOSE_MOVE) {
+			RLOG_DBG(LOG_F_FLIGHT_POS,
+				micro2millimeter(r_space.rocket_x),micro2millimeter(r_space.rocket_y),micro2millimeter(r_space.rocket_z));
+			RLOG_DBG(LOG_F_FLIGHT_TOWERS,
+				micro2millimeter(r_towers[ROCKET_TOWER_NW].length), r_towers[ROCKET_TOWER_NW].step_count,
+				micro2millimeter(r_towers[ROCKET_TOWER_NE].length), r_towers[ROCKET_TOWER_NE].step_count,
+				micro2millimeter(r_towers[ROCKET_TOWER_SW].length), r_towers[ROCKET_TOWER_SW].step_count,
+				micro2millimeter(r_towers[ROCKET_TOWER_SE].length), r_towers[ROCKET_TOWER_SE].step_count);
+		}
 		compute_rocket_cable_lengths_verbose();
 		goto_state((char *) r_flight.state_done);
 	} else {
@@ -422,7 +469,7 @@ static void S_Calibrate_Circle_enter () {
 static void S_Calibrate_Circle_loop () {
 	// measure against the calibration compass
 	compass_select(COMPASS_CALC_CIRC,&calibrate_compass);
-	strncpy(&state_array[state_now].display_2[7],calibrate_compass.name,strlen(calibrate_compass.name));
+	set_lcd_display_field(LCD_BUFFER_2,7,calibrate_compass.name,strlen(calibrate_compass.name));
 	display_state();
 }
 
@@ -467,29 +514,29 @@ static void S_Calibrate_Circle_Go_enter () {
 
 		// fly the rocket in a circle
 		if         ('Z' == name[0]) {
-			flight_circular(0,0,CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND, ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L, 360/(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND));
+			flight_circular(0,0,CIRCLE_TEST_DEGREES_SECOND, ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L, (360*1000L)/CIRCLE_TEST_DEGREES_SECOND);
 		} else 	if ('Y' == name[0]) {
-			flight_circular(0,CIRCLE_TEST_DEGREES_SECOND*2/FRAMES_PER_SECOND,0, ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L, 360/(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND));
+			flight_circular(0,CIRCLE_TEST_DEGREES_SECOND*2,0, ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L, (360*1000L)/CIRCLE_TEST_DEGREES_SECOND);
 		} else 	if ('X' == name[0]) {
-			flight_circular(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND,0,0, ROCKET_HOME_X+0,ROCKET_HOME_Y+0,ROCKET_HOME_Z+150000L, 360/(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND));
+			flight_circular(CIRCLE_TEST_DEGREES_SECOND,0,0, ROCKET_HOME_X+0,ROCKET_HOME_Y+0,ROCKET_HOME_Z+150000L, (360*1000L)/CIRCLE_TEST_DEGREES_SECOND);
 		} else 	if (0 == strcmp("AllLow",name)) {
 			flight_circular(0,
-			                1,
-			                CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND,
+			                CIRCLE_TEST_DEGREES_SECOND/8,
+			                CIRCLE_TEST_DEGREES_SECOND,
 			                ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L,
-			                (2*360)/(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND));
+			                (2*360*1000L)/CIRCLE_TEST_DEGREES_SECOND);
 		} else 	if (0 == strcmp("AllMed",name)) {
-			flight_circular((CIRCLE_TEST_DEGREES_SECOND/8)/FRAMES_PER_SECOND,
-			                (CIRCLE_TEST_DEGREES_SECOND/4)/FRAMES_PER_SECOND,
-			                CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND,
+			flight_circular(CIRCLE_TEST_DEGREES_SECOND/8,
+			                CIRCLE_TEST_DEGREES_SECOND/4,
+			                CIRCLE_TEST_DEGREES_SECOND,
 			                ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L,
-			                (2*360)/(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND));
+			                (2*360*1000L)/CIRCLE_TEST_DEGREES_SECOND);
 		} else 	if (0 == strcmp("AllHgh",name)) {
-			flight_circular((CIRCLE_TEST_DEGREES_SECOND/4)/FRAMES_PER_SECOND,
-			                (CIRCLE_TEST_DEGREES_SECOND/2)/FRAMES_PER_SECOND,
-			                CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND,
+			flight_circular(CIRCLE_TEST_DEGREES_SECOND/4,
+			                CIRCLE_TEST_DEGREES_SECOND/2,
+			                CIRCLE_TEST_DEGREES_SECOND,
 			                ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L,
-			                (2*360)/(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND));
+			                (2*360*1000L)/CIRCLE_TEST_DEGREES_SECOND);
 		} else {
 			next_state("S_Calibrate_Circle_Select");
 			return;
@@ -502,7 +549,7 @@ static void S_Calibrate_Circle_Go_enter () {
 }
 
 void S_Calibrate_BumbleBee_Go_enter () {
-	int32_t randnum = task_cycle_get_32()/2L /*sys_rand32_get()*/;
+	int32_t randnum = rocket_rand()/2L;
 	int32_t x,y,z,a,b;
 
 	if (BUMBLEBEE_MAX <= bumblebee_pass) {
@@ -532,13 +579,15 @@ void S_Calibrate_BumbleBee_Go_enter () {
 
 static void S_Flight_Circle_loop () {
 	if (r_flight.frame_count >= r_flight.frame_max) {
-		if (DEBUG_VERBOSE_MOVE) PRINT("Now at:(%6ld,%6ld,%6ld) NW=(%6ld,%6ld),NE=(%6ld,%6ld),SW=(%6ld,%6ld),SE=(%6ld,%6ld)\n",
-			micro2millimeter(r_space.rocket_x),micro2millimeter(r_space.rocket_y),micro2millimeter(r_space.rocket_z),
-			micro2millimeter(r_towers[ROCKET_TOWER_NW].length), r_towers[ROCKET_TOWER_NW].step_count,
-			micro2millimeter(r_towers[ROCKET_TOWER_NE].length), r_towers[ROCKET_TOWER_NE].step_count,
-			micro2millimeter(r_towers[ROCKET_TOWER_SW].length), r_towers[ROCKET_TOWER_SW].step_count,
-			micro2millimeter(r_towers[ROCKET_TOWER_SE].length), r_towers[ROCKET_TOWER_SE].step_count
-			);
+		if (DEBUG_VERBOSE_MOVE) {
+			RLOG_DBG(LOG_F_FLIGHT_POS,
+				micro2millimeter(r_space.rocket_x),micro2millimeter(r_space.rocket_y),micro2millimeter(r_space.rocket_z));
+			RLOG_DBG(LOG_F_FLIGHT_TOWERS,
+				micro2millimeter(r_towers[ROCKET_TOWER_NW].length), r_towers[ROCKET_TOWER_NW].step_count,
+				micro2millimeter(r_towers[ROCKET_TOWER_NE].length), r_towers[ROCKET_TOWER_NE].step_count,
+				micro2millimeter(r_towers[ROCKET_TOWER_SW].length), r_towers[ROCKET_TOWER_SW].step_count,
+				micro2millimeter(r_towers[ROCKET_TOWER_SE].length), r_towers[ROCKET_TOWER_SE].step_count);
+		}
 		goto_state((char *) r_flight.state_done);
 	} else {
 		flight_circular_loop();
@@ -546,16 +595,18 @@ static void S_Flight_Circle_loop () {
 		set_lcd_display(LCD_BUFFER_1,buffer);
 		display_state();
 
-		if (DEBUG_VERBOSE_MOVE) PRINT("Now at:(%6ld,%6ld,%6ld)A(%6ld,%6ld,%6ld)Motors=(%6ld,%6ld,%6ld,%6ld)\n",
-			micro2millimeter(r_space.rocket_x),micro2millimeter(r_space.rocket_y),micro2millimeter(r_space.rocket_z),
-			r_flight.current_ax,
-			r_flight.current_ay,
-			r_flight.current_az,
-			r_towers[ROCKET_TOWER_NW].step_count,
-			r_towers[ROCKET_TOWER_NE].step_count,
-			r_towers[ROCKET_TOWER_SW].step_count,
-			r_towers[ROCKET_TOWER_SE].step_count
-			);
+		if (DEBUG_VERBOSE_MOVE) {
+			RLOG_DBG(LOG_F_FLIGHT_POS,
+				micro2millimeter(r_space.rocket_x),micro2millimeter(r_space.rocket_y),micro2millimeter(r_space.rocket_z));
+			RLOG_DBG(LOG_F_FLIGHT_ANGLES,
+				r_flight.current_ax/1000,
+				r_flight.current_ay/1000,
+				r_flight.current_az/1000,
+				r_towers[ROCKET_TOWER_NW].step_count,
+				r_towers[ROCKET_TOWER_NE].step_count,
+				r_towers[ROCKET_TOWER_SW].step_count,
+				r_towers[ROCKET_TOWER_SE].step_count);
+		}
 	}
 }
 
@@ -581,7 +632,7 @@ static void S_Attract_Select_enter () {
 }
 
 static void S_Attract_Go_loop () {
-	int32_t randnum = task_cycle_get_32()/2L;
+	int32_t randnum = rocket_rand()/2L;
 	int32_t x,y,z,a,b;
 
 	// reset to initial attract mode when past end
@@ -620,11 +671,11 @@ static void S_Attract_Go_loop () {
 	} else if (11 == attract_pass) {
 		// run circular pattern
 		attract_pass++;
-		flight_circular((CIRCLE_TEST_DEGREES_SECOND/8)/FRAMES_PER_SECOND,
-						(CIRCLE_TEST_DEGREES_SECOND/4)/FRAMES_PER_SECOND,
-						CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND,
+		flight_circular(CIRCLE_TEST_DEGREES_SECOND/8,
+						CIRCLE_TEST_DEGREES_SECOND/4,
+						CIRCLE_TEST_DEGREES_SECOND,
 						ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L,
-						(2*360)/(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND));
+						(2*360*1000L)/CIRCLE_TEST_DEGREES_SECOND);
 		r_flight.state_done="S_Attract_Go";
 		next_state("S_Flight_Circle");
 	}
@@ -642,7 +693,7 @@ static void S_Calibrate_Ground_enter () {
 static void S_Calibrate_Ground_loop () {
 	// measure against the calibration compass
 	compass_select(COMPASS_CALC_GROUND,&calibrate_compass);
-	strncpy(&state_array[state_now].display_2[7],calibrate_compass.name,strlen(calibrate_compass.name));
+	set_lcd_display_field(LCD_BUFFER_2,7,calibrate_compass.name,strlen(calibrate_compass.name));
 	display_state();
 }
 
@@ -681,14 +732,31 @@ static void S_Calibrate_Ground_Go_enter () {
 /**** TEST MOTOR STATUS ********************************************************/
 
 
-static void S_Test_Motor_Status_loop () {
-	uint8_t buf[10];
-	uint32_t len = 1;
-	buf[0] = (uint8_t) '?';
+static struct IO_FUTURE_S motor_status;
 
-	i2c_read(i2c,buf,len,ROCKET_MOTOR_I2C_ADDRESS);
-	sprintf(state_array[state_now].display_1,"Status=%4d",buf[0]);
-	display_state();
+static void S_Test_Motor_Status_enter () {
+	// a query still in flight from the last visit will complete into this future
+	if (!motor_status.pending) {
+		io_future_init(&motor_status);
+	}
+}
+
+static void S_Test_Motor_Status_loop () {
+	// show the answer to the previous frame's query, then ask again
+	if (!motor_status.pending) {
+		if (DEV_OK != motor_status.rc) {
+			sprintf(state_array[state_now].display_1,"Status=none");
+			display_state();
+		} else if (motor_status.len > 0) {
+			if (rocket_status_parse(motor_status.buf, motor_status.len)) {
+				sprintf(state_array[state_now].display_1,"Status=%3d #%3d",r_motor_status.progress,r_motor_status.sequence);
+			} else {
+				sprintf(state_array[state_now].display_1,"Status=bad");
+			}
+			display_state();
+		}
+		io_in_i2c(ROCKET_MOTOR_I2C_ADDRESS, ROCKET_MOTOR_STATUS_LEN, IO_PRIO_MOTOR, &motor_status);
+	}
 }
 
 
@@ -699,7 +767,6 @@ static int32_t calculateSpeed () {
 	speed = abs(r_space.rocket_delta_x) +
 	        abs(r_space.rocket_delta_y) +
 	        abs(r_space.rocket_delta_z);
-	speed *= (int32_t) FRAMES_PER_SECOND;
 	return(speed);
 }
 
@@ -748,19 +815,19 @@ static void updateLedDisplays (int32_t speed) {
 		lcdColorState = lcdColorState_new;
 	    switch(lcdColorState) {
 	        case LCD_COLOR_STATE_GOOD:
-           		groveLcdColorSet(i2c, 0, 200, 100);	// light green
+           		io_lcd_color(0, 200, 100);	// light green
 	            break;
 	        case LCD_COLOR_STATE_WARN:
-           		groveLcdColorSet(i2c, 200, 200, 0);	// yellow
+           		io_lcd_color(200, 200, 0);	// yellow
 	            break;
 	        case LCD_COLOR_STATE_BAD:
-           		groveLcdColorSet(i2c, 200, 100, 0);	// orange
+           		io_lcd_color(200, 100, 0);	// orange
 	            break;
 	        case LCD_COLOR_STATE_DANGER:
-           		groveLcdColorSet(i2c, 200, 20, 20);	// red
+           		io_lcd_color(200, 20, 20);	// red
 	            break;
 	        default:
-           		groveLcdColorSet(i2c, 0, 100, 200);
+           		io_lcd_color(0, 100, 200);
 	            break;
 	    }
 	}
@@ -776,7 +843,8 @@ static void S_Main_Menu_enter () {
 	send_Sound(SOUND_ATTRACT);
 	send_NeoPixel(NEOPIXEL_ATTRACT);
 	//groveLcdClear(i2c);
-	groveLcdInit(i2c);
+	io_lcd_init();
+	lcd_fb_invalidate();
 }
 
 
@@ -789,18 +857,14 @@ static void S_Game_Start_enter () {
 	checkpoint(10101);
 
 	// init the panic timer
-	panic_timer = task_tick_get_32();
+	panic_timer = r_game.game_time_ms;
 
 	// start the show
 	send_Sound(SOUND_GET_READY);
 	send_NeoPixel(NEOPIXEL_GET_READY); /* this will also preset the speed/height LEDs */
 	checkpoint(10103);
-	/* preset the I2C LED */
-	seg_writeDigitNum(0, 0x0f, 0); /* 'F' */
-	seg_writeDigitNum(1, 0x11, 0); /* 'U' */
-	seg_writeDigitNum(3, 0x0e, 0); /* 'E' */
-	seg_writeDigitNum(4, 0x10, 0); /* 'L' */
-	bp_writeDisplay();
+	/* preset the I2C LED: 'F' 'U' 'E' 'L' */
+	io_out_value(IO_OUT_BACKPACK_DIGITS, (0x0fL << 24) | (0x11L << 16) | (0x0eL << 8) | 0x10L);
 	checkpoint(10104);
 
 	// preset LCD color status
@@ -823,7 +887,7 @@ static void S_Game_Ready_enter () {
 	updateLedDisplays(0L);
 
 	// wait 2 seconds before we actually start
-	flight_wait(FRAMES_PER_SECOND * 2);
+	flight_wait(2000L);
 	r_flight.state_done="S_Game_Play";
 	next_state("S_Flight_Wait");
 	checkpoint(10107);
@@ -864,16 +928,18 @@ static void S_Game_Play_loop () {
 		// display the rocket state
 		//	 "1234567890123456",
 		sprintf(state_array[state_now].display_1,"X=%5d Y=%5d",r_space.rocket_x/1000,r_space.rocket_y/1000);
-		sprintf(state_array[state_now].display_2,"Z=%5d f=%5d",r_space.rocket_z/1000,r_space.rocket_fuel);
+		sprintf(buffer,"Z=%5d f=%5d",r_space.rocket_z/1000,r_space.rocket_fuel);
+		set_lcd_display(LCD_BUFFER_2,buffer);
 		display_state();
 	} else if (GAME_DISPLAY_RAW_CABLE == r_game.play_display_mode) {
 		// display the rocket state
 		sprintf(state_array[state_now].display_1,"NW=%4d NE=%4d",
 			r_towers[ROCKET_TOWER_NW].length_goal/1000,
 			r_towers[ROCKET_TOWER_NE].length_goal/1000);
-		sprintf(state_array[state_now].display_2,"SW=%4d SE=%4d",
+		sprintf(buffer,"SW=%4d SE=%4d",
 			r_towers[ROCKET_TOWER_SW].length_goal/1000,
 			r_towers[ROCKET_TOWER_SE].length_goal/1000);
+		set_lcd_display(LCD_BUFFER_2,buffer);
 		display_state();
 	} else if (GAME_DISPLAY_RAW_STEPS == r_game.play_display_mode)  {
 		sprintf(buffer,"NW=%05d E=%05d",
@@ -912,10 +978,11 @@ static void S_Game_Done_enter () {
 	int32_t speed = calculateSpeed();
 
 	// reset the LCD backgroun color
-	groveLcdInit(i2c);
-	groveLcdColorSet(i2c, 0, 100, 200);
+	io_lcd_init();
+	lcd_fb_invalidate();
+	io_lcd_color(0, 100, 200);
 
-	win_timeout = (10L * sys_clock_ticks_per_sec);
+	win_timeout = 10000L;
 	set_lcd_display(LCD_BUFFER_2,"Main      Replay");
 
 	if (SAFE_UMETER_PER_SECOND < speed) {
@@ -933,17 +1000,17 @@ static void S_Game_Done_enter () {
 
 		if (IO_WINNING_SCORE) {
 			if (highest_score < score) {
-				win_timeout = (4L * sys_clock_ticks_per_sec);
+				win_timeout = 4000L;
 				set_lcd_display(LCD_BUFFER_2,"!NEW HIGH SCORE!");
 			}
 		}
 	}
 	set_lcd_display(LCD_BUFFER_1,buffer);
-	win_timethen = task_tick_get_32();
+	win_timethen = r_game.game_time_ms;
 }
 
 static void S_Game_Done_loop () {
-	int32_t win_timenow = task_tick_get_32();
+	int32_t win_timenow = r_game.game_time_ms;
 
 	if (win_timeout < (win_timenow - win_timethen)) {
 
@@ -960,8 +1027,8 @@ static void S_Game_Done_loop () {
 }
 
 static void S_Game_Panic_enter () {
-	uint32_t panic_timer_now = task_tick_get_32();
-	if ((5L * sys_clock_ticks_per_sec) > (panic_timer_now - panic_timer)) {
+	uint32_t panic_timer_now = r_game.game_time_ms;
+	if (5000L > (panic_timer_now - panic_timer)) {
 		// double panic < 5 seconds means stop game
 		next_state("S_Game_Stop");
 	} else {
@@ -1049,6 +1116,23 @@ static void S_Opt_Fuel_Nolimit_Enter () {
 	jump_state("S_Main_Menu");
 }
 
+static void S_Opt_Rate_5_Enter () {
+	r_game.frame_ms = 1000L/5;
+	jump_state("S_Main_Menu");
+}
+static void S_Opt_Rate_25_Enter () {
+	r_game.frame_ms = 1000L/25;
+	jump_state("S_Main_Menu");
+}
+static void S_Opt_Rate_50_Enter () {
+	r_game.frame_ms = 1000L/50;
+	jump_state("S_Main_Menu");
+}
+static void S_Opt_Rate_100_Enter () {
+	r_game.frame_ms = 1000L/100;
+	jump_state("S_Main_Menu");
+}
+
 static void S_Opt_Pos_Center_Enter () {
 	r_game.start_option = GAME_START_CENTER;
 	jump_state("S_Main_Menu");
@@ -1069,19 +1153,18 @@ static void S_Test_enter () {
 
 static void S_IO_STATE_loop () {
 	// display the raw I/O input controls for board bringup
-	sprintf(buffer,"[I/O] X=%3d Y=%3d Z=%3d A=%d B=%d | D4=%d, D5=%d, D6=%d, D7=%d, D8=%d\n",
+	RLOG_INF(LOG_F_IO_STATE,
 		r_control.analog_x,
 		r_control.analog_y,
 		r_control.analog_z,
 		r_control.button_a,
-		r_control.button_b,
+		r_control.button_b);
+	RLOG_INF(LOG_F_IO_GPIO,
 		gpioInputGet(4),
 		gpioInputGet(5),
 		gpioInputGet(6),
 		gpioInputGet(7),
-		gpioInputGet(8)
-		);
-	log(buffer);
+		gpioInputGet(8));
 }
 
 
@@ -1092,7 +1175,7 @@ static void S_Test_I2C_enter () {
 	static uint8_t x = 0;
 	uint8_t buf[100];
 
-	strncpy(buf,msg,strlen(msg));
+	memcpy(buf,msg,strlen(msg));
 	buf[strlen(msg)]=x;
 
 	send_rocket_display(buf, strlen(msg)+1);
@@ -1115,9 +1198,7 @@ static void S_Test_I2C_enter () {
 
 static void S_Test_Segment_Open_enter () {
 	if (IO_LED_BACKPACK_ENABLE) {
-		bp_setdevice(i2c);
-		bp_begin();
-		bp_clear();
+		io_out_value(IO_OUT_BACKPACK_INIT, 0);
 	}
 	jump_state("S_Test_Segment_Select");
 }
@@ -1126,7 +1207,7 @@ static void S_Test_Segment_enter () {
 	static uint8_t x = 123;
 
 	if (IO_LED_BACKPACK_ENABLE) {
-		seg_writeNumber(x);
+		io_out_value(IO_OUT_BACKPACK,x);
 	}
 	x++;
 	jump_state("S_Test_Segment_Select");
@@ -1300,10 +1381,9 @@ static void S_Test_Antennae_loop () {
 
 	// pass Z to current motor's speed
 	if (4 < abs(value_z_prev-r_control.analog_z)) {
-		sprintf(buffer,"[%c] Pan=%0x,Tilt=%0x, Z=%04d\n",
+		RLOG_INF(LOG_F_TEST_ANTENNAE,
 			(0 == antenna_number) ? 'P':'T',
 			antenna_pan,antenna_tilt,r_control.analog_z);
-		log(buffer);
 		send_Pan_Tilt(antenna_pan,antenna_tilt);
 		value_z_prev = r_control.analog_z;
 	}
@@ -1330,13 +1410,11 @@ static void S_Test_LedRgb_loop () {
 	int32_t blue = (r_control.analog_z & 0x0f00 >> 8) * 64;
 
 	// pass Z to LED RGB
-	sprintf(buffer,"[LED RGB] Z=%#04x RGB=%d,%d,%d\n",
+	RLOG_INF(LOG_F_TEST_LEDRGB,
 		r_control.analog_z,
 		red,
 		green,
-		blue
-		);
-	log(buffer);
+		blue);
 }
 static void S_Test_LedRgb_exit () {
 	// turn LED RGB off
@@ -1359,8 +1437,7 @@ static void S_Test_Sound_enter () {
 
 static void S_Test_Sound_loop () {
 	// pass Z to current motor's speed
-	sprintf(buffer,"[Sound & Neo %d] Play\n",sound_number);
-	log(buffer);
+	RLOG_INF(LOG_F_TEST_SOUND,sound_number);
 	send_Sound(sound_number);
 	send_NeoPixel(sound_number);
 }
@@ -1379,6 +1456,122 @@ static void S_Test_Sound_Next_enter () {
 }
 
 
+/**** TEST TRACE ********************************************************/
+
+static void S_Test_Trace_enter () {
+	int32_t worst=trace_worst(TRACE_LOOP);
+
+	trace_dump();
+
+	// show the state loop with the worst p99 time
+	if (STATE_NOT_FOUND == worst) {
+		set_lcd_display(LCD_BUFFER_1,"Trace: no data");
+	} else {
+		sprintf(buffer,"W:%s",&state_array[worst].state_name[2]);
+		set_lcd_display(LCD_BUFFER_1,buffer);
+	}
+}
+
+static void S_Test_Trace_Reset_enter () {
+	trace_reset();
+	jump_state("S_Test_Trace_Go");
+}
+
+
+/**** TEST JITTER ********************************************************/
+
+static void S_Test_Jitter_enter () {
+	frame_report();
+}
+
+static void S_Test_Jitter_loop () {
+	// p99 period jitter (uSec), overruns, worst lateness (mSec)
+	sprintf(buffer,"J%d O%d L%d",
+		hist_cycles2usec(hist_percentile(&r_frame_stats.jitter,99)),
+		r_frame_stats.overruns,
+		r_frame_stats.late_max_us / 1000);
+	set_lcd_display(LCD_BUFFER_1,buffer);
+	display_state();
+}
+
+static void S_Test_Jitter_Reset_enter () {
+	frame_sched_clear();
+	jump_state("S_Test_Jitter_Go");
+}
+
+
+/**** TEST TIMING ********************************************************/
+
+static uint8_t timing_phase = 0;
+
+static void S_Test_Timing_Select_enter () {
+	profile_dump();
+	lcd_fb_report();
+	timing_phase = 0;
+	jump_state("S_Test_Timing_Go");
+}
+
+static void S_Test_Timing_loop () {
+	struct ROCKET_HIST_S *hist = profile_hist(timing_phase);
+
+	// the phase's p99 and max times (uSec)
+	sprintf(buffer,"%s %d/%d",
+		profile_name(timing_phase),
+		hist_cycles2usec(hist_percentile(hist,99)),
+		hist_cycles2usec(hist->max));
+	set_lcd_display(LCD_BUFFER_1,buffer);
+	display_state();
+}
+
+static void S_Test_Timing_Next_enter () {
+	timing_phase++;
+	if (timing_phase >= PROF_PHASE_MAX)
+		timing_phase = 0;
+	jump_state("S_Test_Timing_Go");
+}
+
+
+/**** TEST CHECKPOINTS ********************************************************/
+
+static void S_Test_Checkpoints_Dump_enter () {
+	checkpoint_dump(CHECKPOINT_DUMP_MAX);
+
+	// the boot count, and where the code was before the last reset (one LCD line)
+	snprintf(buffer,LCD_COL_MAX+1,"Boot%d was:%d",r_checkpoints.boots,checkpoint_before_boot());
+	jump_state("S_Test_Checkpoints_Go");
+	set_lcd_display(LCD_BUFFER_1,buffer);
+}
+
+
+/**** TEST BENCH ********************************************************/
+
+static uint8_t bench_kernel = 0;
+
+static void S_Test_Bench_Select_enter () {
+	bench_run();
+	bench_report();
+	bench_kernel = 0;
+	jump_state("S_Test_Bench_Go");
+}
+
+static void S_Test_Bench_loop () {
+	// the kernel's mean and worst times (nSec)
+	sprintf(buffer,"%s %d/%d",
+		r_bench[bench_kernel].label,
+		r_bench[bench_kernel].ns_mean,
+		r_bench[bench_kernel].ns_worst);
+	set_lcd_display(LCD_BUFFER_1,buffer);
+	display_state();
+}
+
+static void S_Test_Bench_Next_enter () {
+	bench_kernel++;
+	if (bench_kernel >= BENCH_KERNEL_MAX)
+		bench_kernel = 0;
+	jump_state("S_Test_Bench_Go");
+}
+
+
 /**** TEST MOTOR STEPPING ********************************************************/
 
 static uint32_t motor_nextset_value=1L;
@@ -1391,7 +1584,7 @@ static void test_set_motor_position(uint32_t motor_position) {
 	rocket_command_send(ROCKET_MOTOR_CMD_PRESET);
 }
 static void S_TestMotor_NextSet_enter () {
-	PRINT("\nMotor_NextSet=%lx\n",motor_nextset_value);
+	PRINT("\nMotor_NextSet=%x\n",motor_nextset_value);
 	test_set_motor_position(motor_nextset_value);
 	motor_nextset_value = motor_nextset_value << 1;
 	if (motor_nextset_value > 0x100000L) motor_nextset_value = 0;
@@ -1413,12 +1606,12 @@ static void S_TestMotor_MinusStep_enter () {
 }
 
 static void S_TestMotor_Plus360_enter () {
-	rocket_increment_send (200, 200, 200, 200);
+	rocket_increment_send (ROCKET_TOWER_REVOLUTION, ROCKET_TOWER_REVOLUTION, ROCKET_TOWER_REVOLUTION, ROCKET_TOWER_REVOLUTION);
 	jump_state("S_TestMotor_Plus360");
 }
 
 static void S_TestMotor_Minus360_enter () {
-	rocket_increment_send (-200, -200, -200, -200);
+	rocket_increment_send (-ROCKET_TOWER_REVOLUTION, -ROCKET_TOWER_REVOLUTION, -ROCKET_TOWER_REVOLUTION, -ROCKET_TOWER_REVOLUTION);
 	jump_state("S_TestMotor_Minus360");
 }
 
@@ -1504,7 +1697,7 @@ static void cable_steps_move(int32_t x, int32_t y, int32_t z) {
 }
 
 static void rotation_test(int32_t ax, int32_t ay, int32_t az) {
-	r_flight.current_ax = ax; r_flight.current_ay = ay; r_flight.current_az = az;
+	r_flight.current_ax = ax*1000L; r_flight.current_ay = ay*1000L; r_flight.current_az = az*1000L;
 	flight_circular_loop();
 	PRINT("CIRCLE(%3d,%3d,%3d)=>(%8d,%8d,%8d) \n",
 		ax, ay, az,
@@ -1513,16 +1706,19 @@ static void rotation_test(int32_t ax, int32_t ay, int32_t az) {
 
 static void all_rotation_test (int16_t x_degrees,int16_t y_degrees,int16_t z_degrees) {
 	rigid_rotation_compute (x_degrees,y_degrees,z_degrees,ROCKET_HOME_X+100000L,ROCKET_HOME_Y+0,ROCKET_HOME_Z+150000L);
-	printf("ROT(%d,%d,%d) => %ld,%ld,%ld\n",x_degrees,y_degrees,z_degrees,r_flight.current_x,r_flight.current_y,r_flight.current_z);
+	printf("ROT(%d,%d,%d) => %d,%d,%d\n",x_degrees,y_degrees,z_degrees,r_flight.current_x,r_flight.current_y,r_flight.current_z);
 }
 
 /**** TEST STATE SANITY ********************************************************/
 
 static void S_Test_Sanity_Base_enter () {
 
+	// the sanity reports print synchronously, so first let the logger catch up
+	log_flush();
+
 	self_test=true;
 
-	PRINT("At Home: (%6ld,%6ld,%6ld) NW=(%6ld,%6ld),NE=(%6ld,%6ld),SW=(%6ld,%6ld),SE=(%6ld,%6ld)\n",
+	PRINT("At Home: (%6d,%6d,%6d) NW=(%6d,%6d),NE=(%6d,%6d),SW=(%6d,%6d),SE=(%6d,%6d)\n",
 		micro2millimeter(r_space.rocket_goal_x),micro2millimeter(r_space.rocket_goal_y),micro2millimeter(r_space.rocket_goal_z),
 		micro2millimeter(r_towers[ROCKET_TOWER_NW].length), r_towers[ROCKET_TOWER_NW].step_count,
 		micro2millimeter(r_towers[ROCKET_TOWER_NE].length), r_towers[ROCKET_TOWER_NE].step_count,
@@ -1532,11 +1728,11 @@ static void S_Test_Sanity_Base_enter () {
 
 
 	PRINT("\n=== All Rotation test ===\n");
-	flight_circular((CIRCLE_TEST_DEGREES_SECOND/4)/FRAMES_PER_SECOND,
-					(CIRCLE_TEST_DEGREES_SECOND/2)/FRAMES_PER_SECOND,
-					CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND,
+	flight_circular(CIRCLE_TEST_DEGREES_SECOND/4,
+					CIRCLE_TEST_DEGREES_SECOND/2,
+					CIRCLE_TEST_DEGREES_SECOND,
 					ROCKET_HOME_X+0, ROCKET_HOME_Y+0, ROCKET_HOME_Z+150000L,
-					(2*360)/(CIRCLE_TEST_DEGREES_SECOND/FRAMES_PER_SECOND));
+					(2*360*1000L)/CIRCLE_TEST_DEGREES_SECOND);
 	all_rotation_test (0,0,     0);
 	all_rotation_test (0,0,    45);
 	all_rotation_test (0,0,180   );
@@ -1560,6 +1756,8 @@ static void S_Test_Sanity_State_enter () {
 	int32_t state_now_orig;
 	bool state_is_called;
 
+	log_flush();
+
 	// set the state table self test flag
 	self_test=true;
 	state_now_orig = state_now;
@@ -1615,6 +1813,8 @@ static void S_Test_Sanity_Antennae_enter () {
 	int32_t rocket_goal_y_orig = r_space.rocket_goal_y;
 	int32_t rocket_goal_z_orig = r_space.rocket_goal_z;
 
+	log_flush();
+
 	r_space.rocket_goal_x = X_POS_MIN;
 	r_space.rocket_goal_y = Y_POS_MAX;
 	for (r_space.rocket_goal_z=0L;r_space.rocket_goal_z<=Z_POS_MAX;r_space.rocket_goal_z += (Z_POS_MAX/4)) {
@@ -1645,15 +1845,17 @@ static void S_Test_Sanity_Positions_enter () {
 	int32_t rocket_z_orig = r_space.rocket_z;
 	int32_t game_mode_orig = r_game.game_mode;
 
+	log_flush();
+
 	// set the state table self test flag
 	self_test=true;
 
 	PRINT("\n========================================\n\n");
-	PRINT("Rocket(x,y,x)=(%ld,%ld,%ld) in uM\n",r_space.rocket_x,r_space.rocket_y,r_space.rocket_z);
+	PRINT("Rocket(x,y,x)=(%d,%d,%d) in uM\n",r_space.rocket_x,r_space.rocket_y,r_space.rocket_z);
 	PRINT("Tower  b        a        scaler\n");
 	PRINT("------ -------- -------- -------\n");
 	for (i=ROCKET_TOWER_NW;i<ROCKET_TOWER_MAX;i++) {
-		PRINT("%6s %8ld, %8ld\n",r_towers[i].name,
+		PRINT("%6s %8d %8d %7d\n",r_towers[i].name,
 			r_towers[i].um2step_slope >> r_towers[i].um2step_scaler,
 			r_towers[i].um2step_offset,r_towers[i].um2step_scaler);
 	}
@@ -1690,6 +1892,8 @@ static void S_Test_Sanity_Tables_enter () {
 	int32_t rocket_z_orig = r_space.rocket_z;
 	int32_t game_mode_orig = r_game.game_mode;
 
+	log_flush();
+
 	// set the state table self test flag
 	self_test=true;
 	r_game.game_mode = GAME_SIMULATE;
@@ -1733,7 +1937,7 @@ static void S_Test_Sanity_Tables_enter () {
 	r_space.rocket_x=ROCKET_HOME_X+10000L;
 	r_space.rocket_y=ROCKET_HOME_Y;
 	r_space.rocket_z=ROCKET_HOME_Z;
-	flight_circular(0,0,0, ROCKET_HOME_X, ROCKET_HOME_Y, ROCKET_HOME_Z, 360/(20/FRAMES_PER_SECOND));
+	flight_circular(0,0,0, ROCKET_HOME_X, ROCKET_HOME_Y, ROCKET_HOME_Z, (360*1000L)/20);
 	PRINT("RADIUS(%8d) \n",r_flight.radius);
 	rotation_test(0,0,0);
 	rotation_test(0,0,90);
@@ -1746,7 +1950,7 @@ static void S_Test_Sanity_Tables_enter () {
 	r_space.rocket_x=    0L;
 	r_space.rocket_y=10000L;
 	r_space.rocket_z=    0L;
-	flight_circular(0,0,0, ROCKET_HOME_X, ROCKET_HOME_Y, ROCKET_HOME_Z, 360/(20/FRAMES_PER_SECOND));
+	flight_circular(0,0,0, ROCKET_HOME_X, ROCKET_HOME_Y, ROCKET_HOME_Z, (360*1000L)/20);
 	rotation_test(45,0,0);
 	rotation_test(90,0,0);
 	rotation_test(270,0,0);
@@ -1820,7 +2024,7 @@ static void S_Test_Sanity_Tables_enter () {
 /**** HIGH NAME ENTER ********************************************************/
 
 int16_t name_pos = 0;
-char high_name[9] = "         ";
+char high_name[10] = "         ";
 
 void S_Name_enter () {
 	name_pos = 0;
@@ -1830,9 +2034,8 @@ void S_Name_enter () {
 	display_state();
 
 	// turn on the cursor control display
-	groveLcdCursorSet(i2c,0,name_pos+7);
-	groveLcdCursor(i2c,1);
-	groveLcdBlink(i2c,1);
+	lcd_fb_cursor(0,name_pos+7);
+	io_lcd_cursor(true,true);
 
 	goto_state("S_Enter_Name");
 }
@@ -1845,8 +2048,8 @@ void S_Name_Char_enter () {
 //	sprintf(buffer,"Name:  %s",high_name);
 //	set_lcd_display(LCD_BUFFER_1,buffer);
 //	display_state();
-	groveLcdPrint(i2c, 0, name_pos+7, &high_name[name_pos], 1);
- 	groveLcdCursorSet(i2c,0,name_pos+7);
+	lcd_fb_write(0, name_pos+7, &high_name[name_pos], 1);
+	lcd_fb_cursor(0,name_pos+7);
 
 	goto_state ("S_Enter_Name");
 }
@@ -1856,7 +2059,7 @@ void S_Name_Next_enter () {
 	if (8 < name_pos) {
 		goto_state("S_High_Score_Show");
 	} else{
-		groveLcdCursorSet (i2c,0,name_pos+7);
+		lcd_fb_cursor(0,name_pos+7);
 		goto_state("S_Enter_Name");
 	}
 }
@@ -1864,8 +2067,8 @@ void S_Name_Next_enter () {
 void S_High_Score_enter () {
 
 	// turn off the cursor control display
-	groveLcdCursor(i2c,0);
-	groveLcdBlink(i2c,0);
+	lcd_fb_cursor(LCD_CURSOR_NONE,0);
+	io_lcd_cursor(false,false);
 
 	strcpy(highest_name,high_name);
 	printf("High Score Name is: %s\n", high_name);
@@ -1904,6 +2107,7 @@ void init_state () {
 	if (!self_test) {
 		state_now=0;
 		state_prev=0;
+		trace_reset();
 	}
 
 //	 "1234567890123456",
@@ -2346,7 +2550,7 @@ void init_state () {
 	 "Select ...",
 //	 "1234567890123456",
 	 "Next   Start_Pos",
-	 "S_Opt_Back","S_Opt_Pos_Center",
+	 "S_Opt_Rate","S_Opt_Pos_Center",
 	 ACTION_NOP,ACTION_NOP,ACTION_NOP);
 
 		StateGuiAdd("S_Opt_Pos_Center",
@@ -2388,6 +2592,85 @@ void init_state () {
 		 ACTION_NOP,ACTION_NOP,ACTION_NOP);
 
 
+// Opt: Frame Rate
+
+	StateGuiAdd("S_Opt_Rate",
+	 STATE_NO_FLAGS,
+	 "Select ...",
+//	 "1234567890123456",
+	 "Next  Frame_Rate",
+	 "S_Opt_Back","S_Opt_Rate_5",
+	 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Opt_Rate_5",
+		 STATE_NO_FLAGS,
+		 "Frame Rate...",
+	//	 "1234567890123456",
+		 "Next        5 Hz",
+		 "S_Opt_Rate_25","S_Opt_Rate_5_Select",
+		 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+			StateGuiAdd("S_Opt_Rate_5_Select",
+			 STATE_NO_VERBOSE,
+			 "",
+			 "",
+			 STATE_NOP,STATE_NOP,
+			 S_Opt_Rate_5_Enter,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Opt_Rate_25",
+		 STATE_NO_FLAGS,
+		 "Frame Rate...",
+	//	 "1234567890123456",
+		 "Next       25 Hz",
+		 "S_Opt_Rate_50","S_Opt_Rate_25_Select",
+		 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+			StateGuiAdd("S_Opt_Rate_25_Select",
+			 STATE_NO_VERBOSE,
+			 "",
+			 "",
+			 STATE_NOP,STATE_NOP,
+			 S_Opt_Rate_25_Enter,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Opt_Rate_50",
+		 STATE_NO_FLAGS,
+		 "Frame Rate...",
+	//	 "1234567890123456",
+		 "Next       50 Hz",
+		 "S_Opt_Rate_100","S_Opt_Rate_50_Select",
+		 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+			StateGuiAdd("S_Opt_Rate_50_Select",
+			 STATE_NO_VERBOSE,
+			 "",
+			 "",
+			 STATE_NOP,STATE_NOP,
+			 S_Opt_Rate_50_Enter,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Opt_Rate_100",
+		 STATE_NO_FLAGS,
+		 "Frame Rate...",
+	//	 "1234567890123456",
+		 "Next      100 Hz",
+		 "S_Opt_Rate_Back","S_Opt_Rate_100_Select",
+		 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+			StateGuiAdd("S_Opt_Rate_100_Select",
+			 STATE_NO_VERBOSE,
+			 "",
+			 "",
+			 STATE_NOP,STATE_NOP,
+			 S_Opt_Rate_100_Enter,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Opt_Rate_Back",
+		 STATE_NO_FLAGS,
+		 "Frame Rate...",
+	//	 "1234567890123456",
+		 "Next   Main_Menu",
+		 "S_Opt_Rate_5","S_Main_Menu",
+		 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+
 	StateGuiAdd("S_Opt_Back",
 	 STATE_NO_FLAGS,
 	 "Select ...",
@@ -2759,7 +3042,7 @@ void init_state () {
 	//	 "1234567890123456",
 		 "Done",
 		 "S_Main_Menu","S_Main_Menu",
-		 ACTION_NOP,S_Test_Motor_Status_loop,ACTION_NOP);
+		 S_Test_Motor_Status_enter,S_Test_Motor_Status_loop,ACTION_NOP);
 
 	StateGuiAdd("S_Test_I2cDisplayTest",
 	 STATE_NO_FLAGS,
@@ -2865,7 +3148,7 @@ void init_state () {
 	 "Test...",
 //	 "1234567890123456",
 	 "Next   Sound/Neo",
-	 "S_Test_Back","S_Test_Sound_Select",
+	 "S_Test_Trace","S_Test_Sound_Select",
 	 ACTION_NOP,ACTION_NOP,ACTION_NOP);
 
 		StateGuiAdd("S_Test_Sound_Select",
@@ -2890,6 +3173,135 @@ void init_state () {
 		 STATE_NOP,STATE_NOP,
 		 S_Test_Sound_Next_enter,ACTION_NOP,ACTION_NOP);
 
+	StateGuiAdd("S_Test_Trace",
+	 STATE_NO_FLAGS,
+	 "Test...",
+//	 "1234567890123456",
+	 "Next       Trace",
+	 "S_Test_Jitter","S_Test_Trace_Go",
+	 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Trace_Go",
+		 STATE_NO_FLAGS,
+		 "Trace...",
+	//	 "1234567890123456",
+		 "Exit       Reset",
+		 "S_Test_Select","S_Test_Trace_Reset",
+		 S_Test_Trace_enter,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Trace_Reset",
+		 STATE_NO_FLAGS,
+		 "",
+		 "",
+		 STATE_NOP,STATE_NOP,
+		 S_Test_Trace_Reset_enter,ACTION_NOP,ACTION_NOP);
+
+	StateGuiAdd("S_Test_Jitter",
+	 STATE_NO_FLAGS,
+	 "Test...",
+//	 "1234567890123456",
+	 "Next      Jitter",
+	 "S_Test_Timing","S_Test_Jitter_Go",
+	 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Jitter_Go",
+		 STATE_NO_VERBOSE,
+		 "Jitter...",
+	//	 "1234567890123456",
+		 "Exit       Reset",
+		 "S_Test_Select","S_Test_Jitter_Reset",
+		 S_Test_Jitter_enter,S_Test_Jitter_loop,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Jitter_Reset",
+		 STATE_NO_FLAGS,
+		 "",
+		 "",
+		 STATE_NOP,STATE_NOP,
+		 S_Test_Jitter_Reset_enter,ACTION_NOP,ACTION_NOP);
+
+	StateGuiAdd("S_Test_Timing",
+	 STATE_NO_FLAGS,
+	 "Test...",
+//	 "1234567890123456",
+	 "Next      Timing",
+	 "S_Test_Checkpoints","S_Test_Timing_Select",
+	 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Timing_Select",
+		 STATE_NO_FLAGS,
+		 "",
+		 "",
+		 STATE_NOP,STATE_NOP,
+		 S_Test_Timing_Select_enter,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Timing_Go",
+		 STATE_NO_VERBOSE,
+		 "Timing...",
+	//	 "1234567890123456",
+		 "Exit        Next",
+		 "S_Test_Select","S_Test_Timing_Next",
+		 ACTION_NOP,S_Test_Timing_loop,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Timing_Next",
+		 STATE_NO_FLAGS,
+		 "",
+		 "",
+		 STATE_NOP,STATE_NOP,
+		 S_Test_Timing_Next_enter,ACTION_NOP,ACTION_NOP);
+
+	StateGuiAdd("S_Test_Checkpoints",
+	 STATE_NO_FLAGS,
+	 "Test...",
+//	 "1234567890123456",
+	 "Next Checkpoints",
+	 "S_Test_Bench","S_Test_Checkpoints_Dump",
+	 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Checkpoints_Dump",
+		 STATE_NO_FLAGS,
+		 "",
+		 "",
+		 STATE_NOP,STATE_NOP,
+		 S_Test_Checkpoints_Dump_enter,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Checkpoints_Go",
+		 STATE_NO_FLAGS,
+		 "Checkpoints...",
+	//	 "1234567890123456",
+		 "Exit        Dump",
+		 "S_Test_Select","S_Test_Checkpoints_Dump",
+		 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+	StateGuiAdd("S_Test_Bench",
+	 STATE_NO_FLAGS,
+	 "Test...",
+//	 "1234567890123456",
+	 "Next       Bench",
+	 "S_Test_Back","S_Test_Bench_Select",
+	 ACTION_NOP,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Bench_Select",
+		 STATE_NO_FLAGS,
+		 "",
+		 "",
+		 STATE_NOP,STATE_NOP,
+		 S_Test_Bench_Select_enter,ACTION_NOP,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Bench_Go",
+		 STATE_NO_VERBOSE,
+		 "Bench (nSec)...",
+	//	 "1234567890123456",
+		 "Exit        Next",
+		 "S_Test_Select","S_Test_Bench_Next",
+		 ACTION_NOP,S_Test_Bench_loop,ACTION_NOP);
+
+		StateGuiAdd("S_Test_Bench_Next",
+		 STATE_NO_FLAGS,
+		 "",
+		 "",
+		 STATE_NOP,STATE_NOP,
+		 S_Test_Bench_Next_enter,ACTION_NOP,ACTION_NOP);
+
 	StateGuiAdd("S_Test_Back",
 	 STATE_NO_FLAGS,
 	 "Test...",
@@ -2945,12 +3357,28 @@ void init_state () {
 }
 
 
+/*
+ * state_button_hold - the buttons that the current state treats as on/off (BUTTON_HOLD_*)
+ *
+ */
+
+uint8_t state_button_hold() {
+	uint8_t hold = 0;
+
+	if (state_array[state_now].state_flags & STATE_BUTTON_HOLD_A)
+		hold |= BUTTON_HOLD_A;
+	if (state_array[state_now].state_flags & STATE_BUTTON_HOLD_B)
+		hold |= BUTTON_HOLD_B;
+	return hold;
+}
+
 /*
  * state_loop - called from main loop
  *
  */
 
 void state_loop() {
+	uint8_t button;
 
 	/* New frame, new state? */
 	if (NULL != state_next_frame) {
@@ -2958,24 +3386,23 @@ void state_loop() {
 		goto_state(state_next_frame);
 	}
 
-	/* Process Buttons (default mode is toggle) */
-	if (r_control.button_a && r_control.button_b) {
+	/* Process Buttons (one event per press, or per frame while a 'hold' button is down, see rocket_button.c) */
+	button = r_control.button_event;
+	if (BUTTON_EVENT_CHORD == button) {
 		goto_state("S_Main_Menu");
-	} else if (r_control.button_a && !r_control.button_a_prev) {
+	} else if (BUTTON_EVENT_A == button) {
 		goto_state(state_array[state_now].k1);
-	} else if (r_control.button_b && !r_control.button_b_prev) {
+	} else if (BUTTON_EVENT_B == button) {
 		goto_state(state_array[state_now].k2);
 	}
-	if (0x0000 == (state_array[state_now].state_flags & STATE_BUTTON_HOLD_A)) {
-		r_control.button_a_prev = r_control.button_a;
-	}
-	if (0x0000 == (state_array[state_now].state_flags & STATE_BUTTON_HOLD_B)) {
-		r_control.button_b_prev = r_control.button_b;
-	}
 
 	// execute any state loop function
-	if (ACTION_NOP != state_array[state_now].state_loop)
+	if (ACTION_NOP != state_array[state_now].state_loop) {
+		int32_t loop_state=state_now;
+		uint32_t trace_cycles=trace_start();
 		state_array[state_now].state_loop();
+		trace_stop(loop_state,TRACE_LOOP,trace_cycles);
+	}
 
 }
 
@@ -40,6 +40,8 @@
 #define STATE_INHERIT_1	((char *)1L)	// inherit button #1 state from parent
 #define STATE_INHERIT_2	((char *)2L)	// inherit button #2 state from parent
 
+#define StateGuiMax 168	// size of the state table
+
 #define LCD_BUFFER_1  1 // top line of LCD
 #define LCD_BUFFER_2  2 // bottom line of LCD
 
@@ -48,6 +50,7 @@ struct StateGuiRec {
 	uint32_t	state_flags;		// Optional state flags
 	char 		display_1[LCD_DISPLAY_POS_MAX+100]; 	// Display string Line 1 (16 chars) (empty string for no change)
 	char		display_2[LCD_DISPLAY_POS_MAX+100]; 	// Display string Line 2 (16 chars)
+	char		layout_2[LCD_DISPLAY_POS_MAX+1];	// Display Line 2, padded and menu-reversed (empty for no change)
 	char*		k1;			// Key1 goto state name (Use <STATE_NOP> for no action)
 	char*		k2;			// Key2 goto state name
 	void		(*state_enter)(); // Callback on state entry (Use <ACTION_NOP> for no action)
@@ -59,6 +62,7 @@ struct StateGuiRec {
 
 void init_state();
 void state_loop();
+uint8_t state_button_hold();
 void goto_state(char *select_state_name);
 void set_lcd_display(int line,char *buffer);
 
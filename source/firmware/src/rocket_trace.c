@@ -0,0 +1,181 @@
+/* rocket_trace.c - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/*
+ * Theory of Implementation
+ *  - Binary tracer for the state machine, enabled by DEBUG_TRACE_ENABLE
+ *  - Each transition, and each enter/exit callback, is recorded into a ring
+ *    buffer as a fixed-size binary record (no formatting in the frame path)
+ *  - Every enter/loop/exit callback duration is added to a per-state histogram,
+ *    keyed by the state ID (the index into the state table)
+ *  - The "Test > Trace" menu state dumps the per-state min/mean/p99/max to the
+ *    console, so that slow callbacks that blow the frame time can be found
+ */
+
+#include <zephyr.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "rocket.h"
+#include "rocket_state.h"
+#include "rocket_hist.h"
+#include "rocket_trace.h"
+
+extern struct StateGuiRec state_array[];
+
+static struct TRACE_EVENT_S trace_ring[TRACE_EVENT_MAX];
+static uint32_t trace_next = 0;		// next ring slot (free running)
+static struct ROCKET_HIST_S trace_hist[StateGuiMax][TRACE_CALLBACK_MAX];
+
+static char *trace_type_name[TRACE_CALLBACK_MAX+1] = {"enter","loop","exit","goto"};
+
+/*
+ * trace_reset : clear the ring and the histograms
+ *
+ */
+
+void trace_reset() {
+	int32_t i,j;
+
+	trace_next = 0;
+	memset(trace_ring,0,sizeof(trace_ring));
+	for (i=0;i<StateGuiMax;i++)
+		for (j=0;j<TRACE_CALLBACK_MAX;j++)
+			hist_reset(&trace_hist[i][j]);
+}
+
+static void trace_record(int32_t state, uint8_t type, uint8_t from, uint32_t cycles, uint32_t duration) {
+	struct TRACE_EVENT_S *event = &trace_ring[trace_next & (TRACE_EVENT_MAX-1)];
+
+	event->cycles   = cycles;
+	event->duration = duration;
+	event->state    = (uint16_t) state;
+	event->type     = type;
+	event->from     = from;
+	trace_next++;
+}
+
+/*
+ * trace_start/trace_stop : bracket a state callback
+ *
+ */
+
+uint32_t trace_start() {
+	if (DEBUG_TRACE_ENABLE) {
+		return task_cycle_get_32();
+	}
+	return 0;
+}
+
+void trace_stop(int32_t state, uint8_t type, uint32_t cycle_start) {
+	uint32_t duration;
+
+	if (!DEBUG_TRACE_ENABLE || (state < 0) || (state >= StateGuiMax) || (type >= TRACE_CALLBACK_MAX))
+		return;
+
+	duration = task_cycle_get_32() - cycle_start;
+	hist_add(&trace_hist[state][type],duration);
+
+	// the loop callbacks run every frame, keep them out of the ring
+	if (TRACE_LOOP != type) {
+		trace_record(state,type,0,cycle_start,duration);
+	}
+}
+
+void trace_transition(int32_t from, int32_t to) {
+	if (DEBUG_TRACE_ENABLE) {
+		trace_record(to,TRACE_TRANSITION,(uint8_t) from,task_cycle_get_32(),0);
+	}
+}
+
+/*
+ * trace_worst : return the state with the largest p99 for this callback type
+ *
+ */
+
+int32_t trace_worst(uint8_t type) {
+	int32_t i,worst=STATE_NOT_FOUND;
+	uint32_t p99,worst_p99=0;
+
+	for (i=0;i<StateGuiMax;i++) {
+		if (0 == trace_hist[i][type].count)
+			continue;
+		p99 = hist_percentile(&trace_hist[i][type],99);
+		if ((STATE_NOT_FOUND == worst) || (p99 > worst_p99)) {
+			worst = i;
+			worst_p99 = p99;
+		}
+	}
+	return worst;
+}
+
+/*
+ * trace_dump : print the per-state timing table and the recent events
+ *
+ */
+
+void trace_dump() {
+	struct ROCKET_HIST_S *hist;
+	struct TRACE_EVENT_S *event;
+	uint32_t first,i,cycle_prev=0;
+	int32_t state;
+	uint8_t type;
+
+	PRINT("\n=== State Trace (usec) ===\n");
+	PRINT("%-32s %-5s %6s %8s %8s %8s %8s\n","State","Call","Count","Min","Mean","P99","Max");
+	for (state=0;state<StateGuiMax;state++) {
+		for (type=0;type<TRACE_CALLBACK_MAX;type++) {
+			hist = &trace_hist[state][type];
+			if (0 == hist->count)
+				continue;
+			PRINT("%-32s %-5s %6d %8d %8d %8d %8d\n",
+				state_array[state].state_name,
+				trace_type_name[type],
+				hist->count,
+				hist_cycles2usec(hist->min),
+				hist_cycles2usec(hist_mean(hist)),
+				hist_cycles2usec(hist_percentile(hist,99)),
+				hist_cycles2usec(hist->max));
+		}
+	}
+
+	PRINT("\n=== Recent Events (usec since previous) ===\n");
+	first = (trace_next > TRACE_EVENT_MAX) ? (trace_next - TRACE_EVENT_MAX) : 0;
+	for (i=first;i<trace_next;i++) {
+		event = &trace_ring[i & (TRACE_EVENT_MAX-1)];
+		if (TRACE_TRANSITION == event->type) {
+			PRINT("%8d goto  %s -> %s\n",
+				(i == first) ? 0 : hist_cycles2usec(event->cycles - cycle_prev),
+				state_array[event->from].state_name,
+				state_array[event->state].state_name);
+		} else {
+			PRINT("%8d %-5s %s (%d usec)\n",
+				(i == first) ? 0 : hist_cycles2usec(event->cycles - cycle_prev),
+				trace_type_name[event->type],
+				state_array[event->state].state_name,
+				hist_cycles2usec(event->duration));
+		}
+		cycle_prev = event->cycles;
+	}
+	PRINT("==========================\n\n");
+}
@@ -0,0 +1,45 @@
+/* rocket_trace.h - Rocket Lander Game */
+
+/*
+ *  Copyright (c) 2016 Wind River Systems, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+/*
+ * <credits>
+ *   { David Reyna,  david.reyna@windriver.com,  },
+ * </credits>
+ *
+ */
+
+/* Trace event types */
+#define TRACE_ENTER			0	// state entry callback
+#define TRACE_LOOP			1	// state loop callback
+#define TRACE_EXIT			2	// state exit callback
+#define TRACE_CALLBACK_MAX	3
+#define TRACE_TRANSITION	3	// state change (no duration)
+
+#define TRACE_EVENT_MAX		512	// transition ring size (power of two)
+
+struct TRACE_EVENT_S {
+	uint32_t cycles;	// time stamp (cycles) at start of event
+	uint32_t duration;	// callback duration (cycles)
+	uint16_t state;		// state ID (new state for transitions)
+	uint8_t  type;		// event type
+	uint8_t  from;		// previous state ID for transitions (low byte)
+};
+
+void trace_reset();
+uint32_t trace_start();
+void trace_stop(int32_t state, uint8_t type, uint32_t cycle_start);
+void trace_transition(int32_t from, int32_t to);
+void trace_dump();
+int32_t trace_worst(uint8_t type);
@@ -18,6 +18,7 @@
 //  Modified record:
 //    Author: david.reyna@windriver.com
 //    Date: 12 February, 2016 - add ASCII support, patch for sync timeout, for Rocket/Galileo support
+//    Date: 2016 - add displayRaw() for segments rendered by the Rocket/Galileo
 //
 /*******************************************************************************/
 #include "TM1637.h"
@@ -183,6 +184,26 @@ void TM1637::display(char *DispData)
   stop();           //
 }
 
+//display function.Write already rendered segments to full-screen,
+//in one auto-increment transfer (no coding, the point bit is the caller's)
+void TM1637::displayRaw(uint8_t SegData[])
+{
+  uint8_t i;
+  start();          //start signal sent to TM1637 from MCU
+  writeByte(ADDR_AUTO);//
+  stop();           //
+  start();          //
+  writeByte(Cmd_SetAddr);//
+  for(i=0;i < 4;i ++)
+  {
+    writeByte(SegData[i]);        //
+  }
+  stop();           //
+  start();          //
+  writeByte(Cmd_DispCtrl);//
+  stop();           //
+}
+
 //******************************************
 void TM1637::display(uint8_t BitAddr,int8_t DispData)
 {
@@ -51,6 +51,7 @@ class TM1637
     void display(int8_t DispData[]);
 	void display(char *DispData);
     void display(uint8_t BitAddr,int8_t DispData);
+    void displayRaw(uint8_t SegData[]);//already rendered segments, one transfer
     void clearDisplay(void);
     void set(uint8_t = BRIGHT_TYPICAL,uint8_t = 0x40,uint8_t = 0xc0);//To take effect the next time it displays.
     void point(boolean PointFlag);//whether to light the clock point ":".To take effect the next time it displays.
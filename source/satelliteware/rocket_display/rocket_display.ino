@@ -29,6 +29,7 @@
  * The supported devices are:
  *   LED1 for hight value (Grove - 4-Digit Display)
  *   LED2 for speed value (Grove - 4-Digit Display)
+ *     (the Galileo renders the four digits, these are the raw segment bytes)
  *   3-bit output for sound board (Adafruit Audio FX Sound Board)
  *   Neopixel patterns (Adafruit NeoPixel Digital RGB LED Strip)
  *   LED-RGB output (Grove - Chainable RGB LED)
@@ -177,26 +178,21 @@ MicroAve ave_loop;
 // hardware asynchronous update handlers
 //
 
+#define LED_DIGITS 4
 boolean tigger_led1 = false;
-byte led1_a;byte led1_b;byte led1_c;byte led1_d;
+byte led1_seg[LED_DIGITS];
 void write_led1() {
   if (ENABLE_LED1) {
-    tm1637_1.display(0,led1_a);
-    tm1637_1.display(1,led1_b);
-    tm1637_1.display(2,led1_c);
-    tm1637_1.display(3,led1_d);
+    tm1637_1.displayRaw(led1_seg);
   }
   tigger_led1 = false;
 }
 
 boolean tigger_led2 = false;
-byte led2_a;byte led2_b;byte led2_c;byte led2_d;
+byte led2_seg[LED_DIGITS];
 void write_led2() {
   if (ENABLE_LED2) {
-    tm1637_2.display(0,led2_a);
-    tm1637_2.display(1,led2_b);
-    tm1637_2.display(2,led2_c);
-    tm1637_2.display(3,led2_d);
+    tm1637_2.displayRaw(led2_seg);
   }
   tigger_led2 = false;
 }
@@ -525,12 +521,12 @@ void receiveEvent(int howMany) {
   if (0 < read_count) {
 
     if ('1' == (char) buffer[0]) {
-    led1_a = buffer[1];  led1_b = buffer[2]; led1_c = buffer[3]; led1_d = buffer[4];
+    for (i=0;i<LED_DIGITS;i++) led1_seg[i] = buffer[i+1];
     tigger_led1 = true;
     }
 
     if ('2' == (char) buffer[0]) {
-    led2_a = buffer[1];  led2_b = buffer[2]; led2_c = buffer[3]; led2_d = buffer[4];
+    for (i=0;i<LED_DIGITS;i++) led2_seg[i] = buffer[i+1];
     tigger_led2 = true;
     }
 
@@ -602,17 +598,17 @@ void display_debug() {
   
   Serial.println("Unit test features ...");
 
-  led1_a = (led1/1000) % 10;
-  led1_b = (led1/100 ) % 10;
-  led1_c = (led1/10  ) % 10;
-  led1_d =  led1       % 10;
+  led1_seg[0] = tm1637_1.coding((led1/1000) % 10);
+  led1_seg[1] = tm1637_1.coding((led1/100 ) % 10);
+  led1_seg[2] = tm1637_1.coding((led1/10  ) % 10);
+  led1_seg[3] = tm1637_1.coding( led1       % 10);
   write_led1();
   led1++;
 
-  led2_a = (led2/1000) % 10;
-  led2_b = (led2/100 ) % 10;
-  led2_c = (led2/10  ) % 10;
-  led2_d =  led2       % 10;
+  led2_seg[0] = tm1637_2.coding((led2/1000) % 10);
+  led2_seg[1] = tm1637_2.coding((led2/100 ) % 10);
+  led2_seg[2] = tm1637_2.coding((led2/10  ) % 10);
+  led2_seg[3] = tm1637_2.coding( led2       % 10);
   write_led2();
   led2++;
 
@@ -33,13 +33,46 @@
  *   (d) One enable bit for the 74LS138 muxes, when the selects are stable
  *   (e) One control for all motors SLEEP input
  *   (f) One input control for all motors SLEEP input
+ *   (g) Two microstep mode outputs (M0 can float) for the rocket controllers' M0/M1 inputs;
+ *       the surface controllers are strapped for full steps
  *   
- * 3) Main Loop
- *   - The main loop cycles as fast a possible, counting the micro seconds passed
- *   - Each motor has a micro second countdown timeout, at which time the next micro-step is taken
+ * 3) Step Scheduler and Main Loop
+ *   - The steps are issued from the Timer1 compare interrupt, so step timing does not
+ *     depend on what the main loop (serial debug, I2C, dispatch) is doing
+ *   - Each motor group has a timer tick countdown for its master clock, which runs at
+ *     the step rate of the group's longest motor move
+ *   - At each master step, a digital differential analyser (Bresenham) steps each motor
+ *     of the group in exact proportion to its share of the move, so all of the motors
+ *     finish together, with no division in the interrupt
+ *   - Timer1 runs in CTC mode, and each interrupt reprograms the compare value for the
+ *     nearest countdown across the active groups; the countdowns are reloaded by adding
+ *     the step period, so a late interrupt does not add drift
+ *   - The timer is stopped when no motor has steps remaining
+ *   - Each group is a separate scheduler context, served in priority order (see motor_groups[]),
+ *     and its DDA visits only the motors that have steps in the move
+ *   - A lower priority group yields its master step when a higher priority group is due to step
+ *     sooner than the lower group's pulses take, and then steps right after it, so the ground's
+ *     terrain changes never delay the rocket's tower steps
+ *   - Each group measures its own step latency (how late its master steps run, see 'H')
+ *   - The main loop runs each group's context in turn: the requests, the timing error
+ *     reports and the power timeouts; it also handles the debug commands
  *   - The timeout is calculalted for the number of steps needed, proportional to the longest motor move
  *   - The timeframe is nominally 1/5 second (the time between updates from the main Rocket controller)
  *   - A speed limit is enforced as per the motors, so a move may cross many timeframes
+ *   - The master clock follows linear acceleration and deceleration ramps (AVR446), with the
+ *     period updated incrementally at each master step: c' = c - 2c/(4n+1) while accelerating,
+ *     and the inverse while decelerating, where n is the step count of the ramp so far
+ *   - The deceleration starts when the remaining master steps reach n, so a move always
+ *     stops on its destination
+ *   - An increment that arrives while the group is moving becomes the group's next segment
+ *     (further increments add to it), which the step interrupt starts as soon as the current
+ *     segment ends, with no stop and no countdown reset
+ *   - The current segment then only decelerates to the junction speed, the fastest speed at
+ *     which no motor's speed changes at the junction by more than it could change starting
+ *     from rest, and no faster than either segment's cruise
+ *   - A request is planned from a snapshot of the group with the step interrupt running
+ *     (integer math only), and then committed under a short interrupt lock, so the step
+ *     and I2C interrupts are never held off for the planning
  *   - The motors are moved to full power when any move command is received
  *   - The motors are moved to SLEEP/STBY after 2 seconds when there is no activity
  *   
@@ -49,14 +82,23 @@
  *   (c) motor boundary input tested, if triggered motion is stopped
  *   (d) the select enable set is set, triggering the respective STEP motor bit
  *   (e) the select enable set is unset after 2 mSec
+ *   (f) this is all done in the step interrupt, which only flags the group's activity;
+ *       the power on is done when the move is dispatched, and the power off by the main loop
  *   
  * 5) I2C Handler
+ *   - The receive interrupt only queues each message into a command FIFO, which the main
+ *     loop drains in order, so a command can no longer overwrite one not yet dispatched
  *   - There I2C messages are received from the main Rocket controller to control motion:
  *     'S' : Stop
  *     'P' : Preset where the rocket is now (e.g. calibration initial position from master)
  *     'D' : go to a new Destination (e.g. goto to game start location)
  *     'I' : Next move increment (e.g. joystick change)
  *     '0'..'c': send 32-bit location value to respective motor (for 'p' and 'd')
+ *   - Every read returns the same status frame (see STATUS_*), with a sequence number and a
+ *     checksum. The main loop prebuilds it each pass, so the request interrupt only adds the
+ *     current locations and the checksum, and does not hold off the step interrupt
+ *   - The frame flags the commands still queued (or executed after it was built), so the
+ *     master never reads a stale 100% for a move it has just sent
  *
  * 6) Serial Monitor:Debug
  *   - Several commands are provided to do board bringup and test functionality. See 'show_help()'
@@ -64,7 +106,12 @@
  *   - Increase the verbose level while testing master Rocket board motor communicaton
  *
  * 7) Dimensions
- *   - All stepper dimentions are in 16 bits (to conserve memory resources)
+ *   - The rocket motors are microstepped (see MOTOR_MICRO_A), and all of the rocket's step counts,
+ *     including those sent by the main Rocket controller, are in microsteps
+ *   - The speed limits and accelerations are given in full steps, and each group scales them
+ *     by its microsteps
+ *   - The motor positions are in 32 bits, the I2C command and status values stay in 16 bits
+ *     (the tower positions as unsigned values, up to 65535 microsteps)
  *   - All time dimensions are in 32 bits (in micro seconds)
  *   - No long moves are done in this driver directly because of need for continual
  *     mapping of linear motion to the tower cable spherical coordinate system
@@ -72,6 +119,7 @@
 
 #include <Wire.h>
 #include <inttypes.h>
+#include <util/delay.h>
 #include "MicroAve.h"
 
 #include <Stepper.h>
@@ -79,14 +127,19 @@
 // General Enables
 #define ENABLE_I2C      1   // Enable the I2C slave mode
 
-#define ENABLE_MEASURE_LOOP     1 // measure main loop time
+#define ENABLE_MEASURE_LOOP     0 // measure main loop time
 #define ENABLE_MEASURE_I2C      0 // measure I2C processing time
 #define ENABLE_MEASURE_UPDATE   0 // measure incremental movement update time
-#define ENABLE_MEASURE_LATENCY  0 // measure latency for motor incement timeout versus goal
+#define ENABLE_MEASURE_LATENCY  1 // measure each group's master step latency versus its deadline
+
+#define ENABLE_RAMPS            1 // acceleration and deceleration ramps, else moves start and stop at full speed
+#define ENABLE_BLEND            1 // blend increments at a junction speed, else they merge into the current move
 
 // setup I2C port
 #define ROCKET_MOTOR_I2C_ADDRESS 19
 #define I2C_READ_MAX 20
+#define CMD_FIFO_MAX  8   // queued I2C commands (a power of 2)
+#define CMD_LEN_MAX  12   // longest queued command ('n' with the frame period)
 
 /* request write commands */
 #define REQUEST_STOP         's'  // send stop
@@ -95,14 +148,30 @@
 #define REQUEST_INCREMENT    'n'  // set the request mode
 #define REQUEST_ROCKET_LOC   'l'  // set the request mode
 
-#define REQUEST_COMMAND      '?'  // set the request mode
-
-/* request read commands */
-#define REQUEST_COMMAND      '?'  // set the request mode
-#define REQUEST_MOVE_STATUS  'S'  // return current move status as percentage completed
-#define REQUEST_TIME_STATUS  'T'  // return current move's remaining microseconds
-#define REQUEST_SPEED_LIMIT  'L'  // return minimum micro seconds per step
-#define REQUEST_POSITION     'P'  // return position
+/* read status frame: every read returns this fixed layout (16-bit values are MSB first),
+ * and a read of only the first byte gets the move progress, as before */
+#define STATUS_VERSION          1
+#define STATUS_PROGRESS         0  // current move status as percentage completed
+#define STATUS_VERSION_OFFSET   1  // STATUS_VERSION
+#define STATUS_SEQUENCE         2  // incremented for each read
+#define STATUS_FLAGS            3  // STATUS_FLAG_*
+#define STATUS_ROCKET_REMAIN    4  // rocket move's remaining milliseconds
+#define STATUS_GROUND_REMAIN    6  // ground move's remaining milliseconds
+#define STATUS_LOCATION         8  // rocket motor locations NW,NE,SW,SE (unsigned microsteps)
+#define STATUS_DESTINATION     16  // rocket motor destinations NW,NE,SW,SE (including any queued segment)
+#define STATUS_ROCKET_ERRORS   24  // rocket group timing errors
+#define STATUS_GROUND_ERRORS   26  // ground group timing errors
+#define STATUS_GROUND_MOVING   28  // bit per ground motor not yet at its destination
+#define STATUS_CMD_OVERFLOW    30  // dropped commands (saturates at 255)
+#define STATUS_CHECKSUM        31  // two's complement of the sum of the other bytes
+#define STATUS_LEN             32  // the Wire library's transmit buffer size
+
+#define STATUS_FLAG_ROCKET_POWER  0x01
+#define STATUS_FLAG_GROUND_POWER  0x02
+#define STATUS_FLAG_ROCKET_MOVING 0x04
+#define STATUS_FLAG_GROUND_MOVING 0x08
+#define STATUS_FLAG_ROCKET_NEXT   0x10  // a rocket segment is queued
+#define STATUS_FLAG_CMD_PENDING   0x20  // received commands are not yet reflected in the frame
 
 //
 // which Arduino
@@ -113,7 +182,7 @@
 #define IS_TRINKET
 
 /* ======== ARDUINO MICRO PORT ASSIGNMENTS ========= */
-#ifdef IS_TRINKET
+#if defined(IS_TRINKET) || defined(IS_UNO)
 #define MOTOR_SELECT_0  3
 #define MOTOR_SELECT_1  4
 #define MOTOR_SELECT_2  5
@@ -129,15 +198,32 @@
 #define MOTOR_POWER_A_LED 16   // power PWM output LED pin, set A (rocket)
 #define MOTOR_POWER_B_LED 17   // power PWM output LED pin, set B (surface)
 #define MOTOR_LIMIT_NO_PIN 0   // This motor does not have limit switch implemented
+#define MOTOR_MODE_M0_PIN  7   // rocket DRV8834 M0 microstep mode (driven or floating)
+#define MOTOR_MODE_M1_PIN 13   // rocket DRV8834 M1 microstep mode (driven only, it has the board LED)
+
+/* Step fast path: the same pins as AVR ports (ATmega328P, Pro Trinket and Uno) */
+#define MOTOR_PORT_FAST
+#define MOTOR_SELECT_PORT   PORTD         // MOTOR_SELECT_0..2 = PD3..PD5, MOTOR_SELECT_3N = PD6
+#define MOTOR_SELECT_SHIFT  3
+#define MOTOR_SELECT_MASK   (_BV(PD3) | _BV(PD4) | _BV(PD5) | _BV(PD6))
+#define MOTOR_SELECT_3N_BIT _BV(PD6)
+#define MOTOR_CONTROL_PORT  PORTB         // MOTOR_SELECT_3 = PB0, MOTOR_SELECT_EN = PB1, MOTOR_DIR = PB2
+#define MOTOR_CONTROL_MASK  (_BV(PB0) | _BV(PB2))
+#define MOTOR_SELECT_3_BIT  _BV(PB0)
+#define MOTOR_SELECT_EN_BIT _BV(PB1)
+#define MOTOR_DIR_BIT       _BV(PB2)
 
 #endif
 
 /* ======== ARDUINO MICRO PORT ASSIGNMENTS ========= */
 #ifdef IS_MICRO
+// NOTE: the Micro's I2C is on pins 2/3, so the selects need new pins here,
+// and with no MOTOR_PORT_FAST the steps use the digitalWrite() path
 #endif
 
 /* ======== ARDUINO UNO PORT ASSIGNMENTS ========= */
 #ifdef IS_UNO
+// The Uno shares the Trinket assignments (same ATmega328P pins)
 #endif
 
 //
@@ -145,11 +231,35 @@
 //
 
 /* Time */
-#define FRAMES_PER_SECOND        5  // 1/5 second, as per rocket control cpu
-#define USECONDS_PER_FRAME 200000L  // 1/5 second
+#define FRAMES_PER_SECOND        5  // default 1/5 second, as per rocket control cpu
+#define USECONDS_PER_FRAME 200000L  // default 1/5 second, else as sent in the increment command
+#define USECONDS_PER_FRAME_MIN 10000L // 1/100 second
 #define MOTOR_SPEED_A_MAX     1250  // minimum microseconds per step => maximum speed (mSec) = 240 rpm (NOTE:1000 mSec too fast for NEMA-17)
 #define MOTOR_SPEED_B_MAX     2048  // minimum microseconds per step => maximum speed (mSec) = 240 rpm (NOTE:1000 mSec too fast for NEMA-17)
 #define MOTOR_SPEED_AUTO        0L  // internal message - speed is auto-calculated per frame
+#define MOTOR_ACCEL_A        8000L  // acceleration in steps per second^2 (0 to 800 steps/sec in 40 steps)
+#define MOTOR_ACCEL_B        4000L  // acceleration in steps per second^2 (0 to 488 steps/sec in 30 steps)
+#define MOTOR_MICRO_A           8   // rocket microsteps per step, as per the DRV8834 mode (1,2,4,8,16,32), and the main board's ROCKET_TOWER_MICROSTEPS
+#define MOTOR_MICRO_B           1   // surface microsteps per step (mode inputs strapped)
+#define RAMP_SHIFT              8   // ramp step periods are in 1/256 timer ticks
+#define RAMP_C0_FACTOR      0.676   // AVR446 first step period correction
+
+/* Step timer (Timer1, 16-bit, CTC mode, prescale 64 => 4 uSec ticks at 16 MHz) */
+#define STEP_TIMER_PRESCALE     64
+#define STEP_TIMER_CLOCK_SELECT (_BV(CS11) | _BV(CS10)) // prescale 64
+#define STEP_TIMER_TICKS_MAX    65536L // longest compare period, longer countdowns wait another period
+#define STEP_TIMER_TICKS_MARGIN 8      // minimum ticks ahead of the counter when reprogramming the compare
+#define STEP_YIELD_USEC        50      // a group yields to a higher priority group due this soon (a 9 motor step)
+#define USEC_TO_TICKS(u) ((((uint32_t) (u)) * (F_CPU / 1000000L) + (STEP_TIMER_PRESCALE - 1)) / STEP_TIMER_PRESCALE) // round up, never faster than asked
+#define TICKS_TO_USEC(t) ((((uint32_t) (t)) * STEP_TIMER_PRESCALE) / (F_CPU / 1000000L))
+
+/* Step pulse timing, per the DRV8834 (STEP high/low >= 1.9 uSec, DIR setup/hold >= 200 nSec)
+ * plus the 74LS138 select propagation (< 50 nSec) */
+#define STEP_SETUP_USEC    0.5  // selects and DIR stable before the enable
+#define STEP_PULSE_USEC    2.0  // enable (STEP) pulse width
+#define STEP_HOLD_USEC     0.5  // DIR held after the STEP edge, before the next motor's selects
+#define MOTOR_SELECT_UNUSED 15  // a select with no motor attached, for timing the pulse
+#define STEP_BENCH_COUNT  1000  // pulses to time for the 't' command
 
 /* Space */
 #define MOTOR_DIR_A_INVERT    true  // Clockwise turn pulls the string - invert dir so that +steps => +cable length
@@ -170,6 +280,7 @@
 #define MOTOR_21  11
 #define MOTOR_22  12
 #define MOTOR_MAX 13
+#define GROUP_MOTOR_MAX 9  // most motors in a group
 
 // Motor set actions
 #define ACTION_NONE       0
@@ -192,7 +303,7 @@
   * c = sqrt(580^2 + 588.2^2) = 826 mm
   * s = (826 mm * 1000 um/mm) / 125.64 uM/step = 6575 steps = 33 turns = 8 seconds
  */
-#define MOTOR_DEST_MAX      6575L  // maximum step count
+#define MOTOR_DEST_MAX      6575L  // maximum step count, in full steps
 #define MOTOR_DEST_MIN          0  // minimum step count
 
 /* Spindle: diameter = 8 mm, circumference = 3.141 * 8 mm = 25.128, uM/step = (25.128 * 1000)/200 = 125.64 uM/step */
@@ -208,7 +319,6 @@
 MicroAve *ave_i2c;
 MicroAve *ave_loop;
 MicroAve *ave_update;
-MicroAve *ave_latency;
 
 /* Debugging */
 #define VERBOSE_MAX 3
@@ -217,8 +327,22 @@ uint8_t verbose = 1;  // verbose level: 0=off, 1=errors,ping, 2=moves, 3=I2C
 #define PING_LOOP_INIT   2000000L // display first ping at 2 seconds
 uint8_t test_motor_min=0;
 uint8_t test_motor_max=MOTOR_MAX;
-/* Request command mode */
-uint8_t request_command = REQUEST_MOVE_STATUS;
+/* Status frame sequence */
+uint8_t status_sequence = 0;
+
+/* Command FIFO: single producer (the I2C receive interrupt), single consumer (the main loop) */
+struct CMD_S {
+  uint8_t len;
+  uint8_t buffer[CMD_LEN_MAX];
+};
+CMD_S cmd_fifo[CMD_FIFO_MAX];
+volatile uint8_t cmd_head = 0;  // next slot to write, owned by the interrupt
+volatile uint8_t cmd_tail = 0;  // next slot to read, owned by the main loop
+volatile uint16_t cmd_overflow = 0; // commands dropped because the FIFO was full
+
+/* Status frame, prebuilt by the main loop and sent by the request interrupt */
+uint8_t status_frame[STATUS_LEN];
+uint8_t status_cmd_tail = 0;    // cmd_tail when status_frame was built
 
 
 //
@@ -229,14 +353,16 @@ class MotorControllerGroup {
   public:
     // constructors:
     MotorControllerGroup(const char * motor_name, int8_t select_min, int8_t select_max, uint16_t rev_steps, 
-      uint16_t micro_steps, uint8_t power_port, uint16_t maximum_speed, boolean dir_invert);
+      uint16_t micro_steps, uint8_t power_port, uint16_t maximum_speed, uint32_t accel, boolean dir_invert);
 
     // member functions
     void activity_trigger();
     boolean activity_loop(int32_t u_sec_passed);
     void request_action(uint8_t action);
     void request_speed(uint32_t speed);
+    void request_frame(uint32_t frame_usec);
     void power(boolean on);
+    void microstep_mode(uint8_t m0_pin, uint8_t m1_pin);
     void displayStatus();
 
     /* member variables */
@@ -245,30 +371,86 @@ class MotorControllerGroup {
     int8_t motor_max;             // last  group motor's select
     uint16_t step_count;          // steps per revolution
     uint16_t step_micro_count;    // micro steps set in the controller
-    uint16_t max_speed;           // max speed, minimum uSec per step
+    uint16_t max_speed;           // max speed, minimum uSec per (micro) step
+    uint32_t acceleration;        // ramp acceleration, in (micro) steps per second^2
     boolean direction_invert;     // invert direction control
     uint8_t power_pin;            // pin for power control
     uint8_t power_led_pin;        // pin for power on LED
     boolean power_on;             // is the power on
     uint8_t pending_action;       // flag that an action is requested
     uint32_t req_microseconds_per_step;  // requested action speed, in countdown useconds
+    uint32_t frame_microseconds;  // controller frame period, to spread each increment over
     int32_t activity_countdown;   // timoutout for activity power on
+    volatile boolean step_activity; // a step was taken by the step interrupt
+
+    /* step scheduler (master clock of the group's DDA, shared with the step interrupt) */
+    volatile uint32_t dda_steps;  // master steps remaining in the move
+    uint32_t dda_total;           // master steps in the move (the longest motor move)
+    uint32_t microseconds_per_step; // master step period, in useconds
+    uint32_t ticks_per_step;      // master step period, in timer ticks
+    int32_t  ticks_step_count;    // countdown to the next master step, in timer ticks
+    uint16_t time_step_errors;    // number of master steps that fell a full step period behind
+    uint16_t time_step_errors_shown; // error count last reported by the main loop
+    uint8_t  dda_motors[GROUP_MOTOR_MAX]; // motors with steps in the move, the only ones the DDA visits
+    uint8_t  dda_motor_count;     // number of motors in dda_motors
+    uint16_t step_yields;         // master steps deferred for a higher priority group
+    MicroAve *ave_latency;        // master step latency (ENABLE_MEASURE_LATENCY)
+
+    /* acceleration ramp of the master clock */
+    uint32_t ramp_c0;             // first step period from rest, in 1/256 ticks
+    uint32_t ramp_period;         // current step period, in 1/256 ticks
+    uint32_t ramp_min;            // cruise step period of the move, in 1/256 ticks
+    uint32_t ramp_n;              // ramp steps to the current speed (and so, to stop)
+    uint32_t ramp_exit_n;         // ramp steps at the end of the segment (the junction speed), 0 to stop
+    uint32_t ramp_v0;             // speed of the first ramp step, in steps per second (16 bits)
+
+    /* next segment (one increment of lookahead), started by the step interrupt */
+    volatile boolean next_valid;  // the next segment is ready
+    uint32_t next_total;          // master steps in the next segment
+    uint32_t next_microseconds_per_step; // master step period of the next segment, in useconds
+    uint32_t next_ramp_min;       // cruise step period of the next segment, in 1/256 ticks
+    volatile uint8_t dda_segment; // count of segments started by the step interrupt, to detect one starting under a plan
 };
 
 MotorControllerGroup::MotorControllerGroup(const char * motor_name, int8_t select_min, int8_t select_max, uint16_t rev_steps, 
-  uint16_t micro_steps, uint8_t power_port, uint16_t maximum_speed, boolean dir_invert) {
+  uint16_t micro_steps, uint8_t power_port, uint16_t maximum_speed, uint32_t accel, boolean dir_invert) {
   name = motor_name;
   motor_min = select_min;
   motor_max = select_max;
   step_count = rev_steps;
   step_micro_count = micro_steps;
   power_pin = power_port;
-  max_speed = maximum_speed;
+  // the limits are in full steps, the group moves in microsteps
+  max_speed = maximum_speed / micro_steps;
+  acceleration = accel * micro_steps;
   power_on = false;
   direction_invert = dir_invert;
   
   activity_countdown = 0L;
+  step_activity = false;
+  dda_steps = 0L;
+  dda_total = 0L;
+  microseconds_per_step = 0L;
+  ticks_per_step = 0L;
+  ticks_step_count = 0L;
+  time_step_errors = 0;
+  time_step_errors_shown = 0;
+  dda_motor_count = 0;
+  step_yields = 0;
+  ave_latency = NULL;
+
+  // first step period from rest: c0 = 0.676 * f * sqrt(2 / accel), in 1/256 ticks
+  ramp_c0 = (uint32_t) (RAMP_C0_FACTOR * (F_CPU / STEP_TIMER_PRESCALE) * sqrt(2.0 / (double) acceleration) * (1 << RAMP_SHIFT));
+  ramp_period = ramp_c0;
+  ramp_min = ramp_c0;
+  ramp_n = 0L;
+  ramp_exit_n = 0L;
+  ramp_v0 = min((uint32_t) ((float) (F_CPU / STEP_TIMER_PRESCALE) * (1 << RAMP_SHIFT) / (float) ramp_c0),(uint32_t) 0xffffL);
+  next_valid = false;
+  next_total = 0L;
+  dda_segment = 0;
   pending_action = ACTION_NONE;
+  frame_microseconds = USECONDS_PER_FRAME;
 
   power_led_pin = (MOTOR_POWER_A_PIN == power_pin) ? MOTOR_POWER_A_LED:MOTOR_POWER_B_LED;
     
@@ -285,6 +467,11 @@ void MotorControllerGroup::request_speed(uint32_t speed) {
   req_microseconds_per_step = speed;
 }
 
+void MotorControllerGroup::request_frame(uint32_t frame_usec) {
+  if (frame_usec < USECONDS_PER_FRAME_MIN) frame_usec = USECONDS_PER_FRAME_MIN;
+  frame_microseconds = frame_usec;
+}
+
 // Power enable is active low
 void MotorControllerGroup::power(boolean on) {
   power_on = on;
@@ -293,6 +480,19 @@ void MotorControllerGroup::power(boolean on) {
   delayMicroseconds(100); 
 }
 
+/* Set the DRV8834 microstep mode, as (M1,M0): 1=(0,0) 2=(0,1) 4=(0,Z) 8=(1,0) 16=(1,1) 32=(1,Z) */
+void MotorControllerGroup::microstep_mode(uint8_t m0_pin, uint8_t m1_pin) {
+  pinMode(m1_pin,OUTPUT);
+  digitalWrite(m1_pin, (step_micro_count >= 8) ? HIGH:LOW);
+
+  if ((4 == step_micro_count) || (32 == step_micro_count)) {
+    pinMode(m0_pin,INPUT);  // floating
+  } else {
+    pinMode(m0_pin,OUTPUT);
+    digitalWrite(m0_pin, ((2 == step_micro_count) || (16 == step_micro_count)) ? HIGH:LOW);
+  }
+}
+
 void MotorControllerGroup::activity_trigger() {
     // set the motors to high power
     if (!power_on) 
@@ -303,6 +503,11 @@ void MotorControllerGroup::activity_trigger() {
     
 boolean MotorControllerGroup::activity_loop(int32_t u_sec_passed) {
   boolean ret = false;
+  // any steps since the last pass? (a byte flag, no lock needed)
+  if (step_activity) {
+    step_activity = false;
+    activity_countdown = ACTIVITY_POWERDOWN_COUNT;
+  }
   // activity timeout?
   if (activity_countdown) {
     activity_countdown -= (int32_t) u_sec_passed;
@@ -329,10 +534,75 @@ void MotorControllerGroup::displayStatus() {
   Serial.print(",");
   Serial.print(step_micro_count);
   Serial.print(") MaxSpeed=");
-  Serial.println(max_speed);
+  Serial.print(max_speed);
+  Serial.print(" Speed=");
+  Serial.print(microseconds_per_step);
+  Serial.print(" Accel=");
+  Serial.print(acceleration);
+  if (time_step_errors) {
+    Serial.print(" ERROR_TIMING=");
+    Serial.print(time_step_errors);
+  }
+  if (step_yields) {
+    Serial.print(" Yields=");
+    Serial.print(step_yields);
+  }
+  Serial.println("");
 }
 
 
+//
+// step pulse output
+//
+
+/* Portable path: the Arduino pin API (about 4 uSec per digitalWrite) */
+void motor_step_pin(uint8_t select, boolean dir_high) {
+  /* which motor */
+  digitalWrite(MOTOR_SELECT_0, (select & 0x01) ? HIGH:LOW);
+  digitalWrite(MOTOR_SELECT_1, (select & 0x02) ? HIGH:LOW);
+  digitalWrite(MOTOR_SELECT_2, (select & 0x04) ? HIGH:LOW);
+  digitalWrite(MOTOR_SELECT_3, (select & 0x08) ? HIGH:LOW);
+  digitalWrite(MOTOR_SELECT_3N,(select & 0x08) ? LOW:HIGH);
+
+  /* what direction */
+  digitalWrite(MOTOR_DIR, (dir_high) ? HIGH:LOW);
+  _delay_us(STEP_SETUP_USEC);
+
+  /* execute the step (MOTOR_SELECT_EN is active low) */
+  digitalWrite(MOTOR_SELECT_EN, LOW);
+  _delay_us(STEP_PULSE_USEC);
+  digitalWrite(MOTOR_SELECT_EN, HIGH);
+  _delay_us(STEP_HOLD_USEC);
+}
+
+#ifdef MOTOR_PORT_FAST
+/* Fast path: one port write for the low selects, one for select 3 and DIR.
+ * The read-modify-writes share the ports with the power pins, so this runs
+ * in the step interrupt, or in the main loop with the step timer stopped */
+void motor_step_port(uint8_t select, boolean dir_high) {
+  uint8_t select_bits = (select & 0x07) << MOTOR_SELECT_SHIFT;
+  uint8_t control_bits = 0;
+
+  if (0 == (select & 0x08)) select_bits |= MOTOR_SELECT_3N_BIT;
+  else control_bits |= MOTOR_SELECT_3_BIT;
+  if (dir_high) control_bits |= MOTOR_DIR_BIT;
+
+  MOTOR_SELECT_PORT  = (MOTOR_SELECT_PORT  & ~MOTOR_SELECT_MASK ) | select_bits;
+  MOTOR_CONTROL_PORT = (MOTOR_CONTROL_PORT & ~MOTOR_CONTROL_MASK) | control_bits;
+  _delay_us(STEP_SETUP_USEC);
+
+  /* execute the step (MOTOR_SELECT_EN is active low) */
+  MOTOR_CONTROL_PORT &= ~MOTOR_SELECT_EN_BIT;
+  _delay_us(STEP_PULSE_USEC);
+  MOTOR_CONTROL_PORT |= MOTOR_SELECT_EN_BIT;
+  _delay_us(STEP_HOLD_USEC);
+}
+#define motor_step_pulse motor_step_port
+#else
+#define motor_step_pulse motor_step_pin
+#endif
+
+
 //
 // motor class
 //
@@ -344,7 +614,7 @@ class Motor {
 
     // member functions
     void init(const char * motor_name, int8_t motor_select, MotorControllerGroup *motor_controller, int8_t motor_home_pin, int16_t motor_home_offset);
-    void step_loop(uint32_t u_sec_passed);
+    void step();
     void displayStatus();
     void reset();
     uint32_t remaining_steps();
@@ -354,19 +624,16 @@ class Motor {
     uint8_t  select;           // motor select value 0..15
     int8_t   home_pin;         // home position input pin (MOTOR_LIMIT_NO_PIN if not implemented for this motor)
     int16_t  home_offset;      // home offset from home switch trigger
-    int16_t  step_location;    // current location of stepper motor, in steps
-    int16_t  step_destination; // goal location of stepper motor, in steps
-    uint32_t microseconds_step_count; // speed loop current useconds countdown
-    uint32_t microseconds_per_step;   // speed loop total count, in countdown useconds
+    volatile int32_t step_location;    // current location of stepper motor, in (micro) steps
+    volatile int32_t step_destination; // goal location of stepper motor, in (micro) steps
+    uint32_t dda_delta;        // steps of this motor in the group's move
+    uint32_t dda_error;        // DDA accumulator, a step each time it passes the group's total
+    int8_t   step_dir;         // direction of the last step (+1,-1), 0 if at rest
+    int32_t  next_delta;       // steps of this motor in the group's next segment
     MotorControllerGroup *controller; // motor controller definition for this moter
 
     /* pending actions */
-    int16_t request_value;      // value for action
-
-    /* error testing analytics */
-    uint32_t time_step_last;    // number of microseconds since last step
-    uint32_t time_step_loops;   // number of time loops since last step
-    uint16_t time_step_errors;  // number of under-time step errors
+    int32_t request_value;      // value for action
     
   private:
 };
@@ -388,104 +655,27 @@ void Motor::reset() {
   step_location = 0L;
   step_destination = 0L;
   request_value = 0L;
-  microseconds_step_count = 0L;
-  microseconds_per_step = 0L;
-
-  time_step_last=0L;
-  time_step_errors=0; 
-  time_step_loops=0;
+  dda_delta = 0L;
+  dda_error = 0L;
+  step_dir = 0;
+  next_delta = 0;
 }
 
 uint32_t Motor::remaining_steps() {
   return (uint32_t) abs(step_destination - step_location);
 }
 
-// Synchronously advance the motor positions here
-void Motor::step_loop(uint32_t u_sec_passed) {
-  uint32_t time_step_now;
-  
-  // has enough time passed for a step?
-  microseconds_step_count += u_sec_passed;
-  time_step_loops++;
-  if ((step_location           != step_destination     ) &&
-      (microseconds_step_count >= microseconds_per_step) ) {
-
-    // capture the latency
-    if (ENABLE_MEASURE_LATENCY) {
-      ave_latency->addValue(microseconds_step_count - microseconds_per_step);
-    }
-
-    // undertime protection code
-    time_step_now = micros();
-    if (time_step_last) {
-      if ((verbose > 0) && (time_step_now == time_step_last)) {
-        // NOTE: verbose console sends will overlap with stepper counting, causing loop
-        // delays, so there will be some loops that reach their countdown in one
-        // pass, and in this test it can appear that no time passed, especially with
-        // the >=4 uSec reolution. This is normal and is not an error.
-      } else if (controller->max_speed > (time_step_now - time_step_last)) {
-        /* not enough time - wait again */
-        time_step_errors++;
-        time_step_last = time_step_now;
-
-        if (verbose > 0) {
-          Serial.println("");
-          Serial.print("###ERROR_TIMING:[");
-          Serial.print(name);
-          Serial.print("]loc=");
-          Serial.print(step_location);
-          Serial.print(",dest=");
-          Serial.print(step_destination);
-          Serial.print(",last=");
-          Serial.print(time_step_last);
-          Serial.print(",now=");
-          Serial.print(time_step_now);
-          Serial.print(",inc=");
-          Serial.print(u_sec_passed);
-          Serial.print(",count=");
-          Serial.print(microseconds_step_count);
-          Serial.print(",max=");
-          Serial.print(microseconds_per_step);
-          Serial.print(",loops=");
-          Serial.print(time_step_loops);
-          Serial.println("");     
-        }
-
-        return;
-      }
-    }
-    time_step_last = time_step_now;
-    time_step_loops=0L;
-
-    // reset the step count to 0 to insure full time for next step
-    microseconds_step_count = 0L;
-
-    /* which motor */
-    digitalWrite(MOTOR_SELECT_0, (select & 0x01) ? HIGH:LOW);
-    digitalWrite(MOTOR_SELECT_1, (select & 0x02) ? HIGH:LOW);
-    digitalWrite(MOTOR_SELECT_2, (select & 0x04) ? HIGH:LOW);
-    digitalWrite(MOTOR_SELECT_3, (select & 0x08) ? HIGH:LOW);
-    digitalWrite(MOTOR_SELECT_3N,(select & 0x08) ? LOW:HIGH);
-
-    /* what direction */
-    if (step_location < step_destination) {
-      step_location++;
-      digitalWrite(MOTOR_DIR, (controller->direction_invert) ? LOW:HIGH);
-      delayMicroseconds(4); //wait 4 microSec
-    } else {
-      step_location--;
-      digitalWrite(MOTOR_DIR, (controller->direction_invert) ? HIGH:LOW);
-      delayMicroseconds(4); //wait 4 microSec
-    }
-
-    /* execute the step (MOTOR_SELECT_EN is active low) */
-    digitalWrite(MOTOR_SELECT_EN, LOW);
-    delayMicroseconds(4); //wait 4 microSec
-    digitalWrite(MOTOR_SELECT_EN, HIGH);
-    delayMicroseconds(4); //wait 4 microSec
-
-    /* reset the power-off countdown */
-    controller->activity_trigger();
+// Advance the motor position one step, called from the step interrupt
+void Motor::step() {
+  /* which motor, what direction, and the step */
+  if (step_location < step_destination) {
+    step_location++;
+    step_dir = 1;
+    motor_step_pulse(select, !controller->direction_invert);
+  } else if (step_location > step_destination) {
+    step_location--;
+    step_dir = -1;
+    motor_step_pulse(select, controller->direction_invert);
   }
 }
 
@@ -496,14 +686,8 @@ void Motor::displayStatus() {
   Serial.print(step_location);
   Serial.print(" steps, dest=");
   Serial.print(step_destination);
-  Serial.print(" steps, speed:");
-  Serial.print(microseconds_per_step);
-  Serial.print(" mSec, Controller=");
+  Serial.print(" steps, Controller=");
   Serial.print(controller->name);  
-  if (time_step_errors) {
-    Serial.print(", ERROR_TIMING=");
-    Serial.print(time_step_errors);
-  }
   Serial.println("");
 }
 
@@ -512,10 +696,204 @@ void Motor::displayStatus() {
 // Create the motor objects
 //
 
-MotorControllerGroup rocket_group("NEMA-14", MOTOR_NW, MOTOR_SE,200, 1, MOTOR_POWER_A_PIN, MOTOR_SPEED_A_MAX, MOTOR_DIR_A_INVERT);
-MotorControllerGroup ground_group("SPIRAL" , MOTOR_00, MOTOR_22, 24, 1, MOTOR_POWER_B_PIN, MOTOR_SPEED_B_MAX, MOTOR_DIR_B_INVERT);
+MotorControllerGroup rocket_group("NEMA-14", MOTOR_NW, MOTOR_SE,200, MOTOR_MICRO_A, MOTOR_POWER_A_PIN, MOTOR_SPEED_A_MAX, MOTOR_ACCEL_A, MOTOR_DIR_A_INVERT);
+MotorControllerGroup ground_group("SPIRAL" , MOTOR_00, MOTOR_22, 24, MOTOR_MICRO_B, MOTOR_POWER_B_PIN, MOTOR_SPEED_B_MAX, MOTOR_ACCEL_B, MOTOR_DIR_B_INVERT);
 Motor motors[MOTOR_MAX];
 
+/* the scheduler contexts, in priority order: the rocket's motion comes first */
+#define GROUP_MAX 2
+MotorControllerGroup *motor_groups[GROUP_MAX] = {&rocket_group, &ground_group};
+
+
+//
+// Step scheduler (Timer1 compare interrupt)
+//
+
+volatile boolean step_timer_running = false;
+uint32_t step_timer_period = 0L; // ticks from the last compare match to the next one
+
+/* Program the next compare match, at least a margin ahead of the counter (interrupts are off) */
+void step_timer_program(uint32_t ticks) {
+  uint16_t now = TCNT1;
+  if (ticks > STEP_TIMER_TICKS_MAX) ticks = STEP_TIMER_TICKS_MAX;
+  if (ticks < ((uint32_t) now + STEP_TIMER_TICKS_MARGIN)) ticks = (uint32_t) now + STEP_TIMER_TICKS_MARGIN;
+  OCR1A = (uint16_t) (ticks - 1);
+  step_timer_period = ticks;
+}
+
+/* Ticks passed since the last compare match, to offset a countdown loaded between matches (interrupts are off) */
+uint32_t step_timer_now() {
+  return (step_timer_running) ? (uint32_t) TCNT1 : 0L;
+}
+
+/* Start the timer for new steps, or pull in the next compare if a new countdown is nearer (interrupts are off) */
+void step_timer_start() {
+  if (!step_timer_running) {
+    TCCR1B = 0;
+    TCNT1 = 0;
+    step_timer_program(STEP_TIMER_TICKS_MARGIN);
+    TIFR1 = _BV(OCF1A);
+    TIMSK1 |= _BV(OCIE1A);
+    TCCR1B = _BV(WGM12) | STEP_TIMER_CLOCK_SELECT;
+    step_timer_running = true;
+  } else {
+    step_timer_program((uint32_t) TCNT1 + STEP_TIMER_TICKS_MARGIN);
+  }
+}
+
+void step_timer_stop() {
+  TCCR1B = 0;
+  TIMSK1 &= ~_BV(OCIE1A);
+  step_timer_running = false;
+}
+
+void step_timer_init() {
+  TCCR1A = 0;   // no PWM outputs, normal port operation for the pins
+  step_timer_stop();
+}
+
+/* Next step period of a group's ramp (AVR446), there is a division only while the speed changes */
+void group_ramp(MotorControllerGroup *motor_group) {
+  uint32_t c = motor_group->ramp_period;
+  uint32_t n = motor_group->ramp_n;
+
+  boolean stopping = (n > motor_group->ramp_exit_n) && (motor_group->dda_steps <= (n - motor_group->ramp_exit_n));
+
+  if (stopping || (c < motor_group->ramp_min)) {
+    // decelerate, to stop at the destination (or the junction speed) or down to a slower cruise
+    if (n > 0) {
+      c += (c << 1) / ((n << 2) - 1);
+      n--;
+    }
+    if (!stopping && (c > motor_group->ramp_min)) c = motor_group->ramp_min;
+    if (0 == n) c = max(motor_group->ramp_c0,motor_group->ramp_min);
+  } else if (c > motor_group->ramp_min) {
+    // accelerate to the cruise
+    n++;
+    c -= (c << 1) / ((n << 2) + 1);
+    if (c < motor_group->ramp_min) c = motor_group->ramp_min;
+  }
+
+  motor_group->ramp_period = c;
+  motor_group->ramp_n = n;
+}
+
+/* List the motors with steps in a group's move, so the DDA skips the rest (interrupts are off) */
+void group_dda_select(MotorControllerGroup *motor_group) {
+  int8_t i;
+
+  motor_group->dda_motor_count = 0;
+  for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
+    if (0L != motors[i].dda_delta) motor_group->dda_motors[motor_group->dda_motor_count++] = i;
+  }
+}
+
+/* Start a group's next segment where the current one ended (from the step interrupt) */
+void group_next_start(MotorControllerGroup *motor_group) {
+  int8_t i;
+
+  for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
+    motors[i].step_destination += motors[i].next_delta;
+    motors[i].dda_delta = (uint32_t) abs(motors[i].next_delta);
+    motors[i].dda_error = motor_group->next_total / 2;
+    motors[i].next_delta = 0;
+  }
+  motor_group->dda_total = motor_group->next_total;
+  motor_group->dda_steps = motor_group->next_total;
+  motor_group->microseconds_per_step = motor_group->next_microseconds_per_step;
+  motor_group->ramp_min = motor_group->next_ramp_min;
+  motor_group->ramp_exit_n = 0L;
+  motor_group->next_valid = false;
+  motor_group->dda_segment++;
+  if (!ENABLE_RAMPS) motor_group->ticks_per_step = motor_group->ramp_min >> RAMP_SHIFT;
+  group_dda_select(motor_group);
+}
+
+/* Take a group's master step, which is due, and step the DDA of its moving motors */
+void group_step(MotorControllerGroup *motor_group) {
+  uint8_t i;
+  Motor *motor;
+
+  // capture the latency
+  if (ENABLE_MEASURE_LATENCY) {
+    motor_group->ave_latency->addValue(TICKS_TO_USEC(-motor_group->ticks_step_count));
+  }
+
+  // each motor steps when its share of the move carries over the total
+  for (i=0;i<motor_group->dda_motor_count;i++) {
+    motor = &motors[motor_group->dda_motors[i]];
+    motor->dda_error += motor->dda_delta;
+    if (motor->dda_error >= motor_group->dda_total) {
+      motor->dda_error -= motor_group->dda_total;
+      motor->step();
+    }
+  }
+  motor_group->dda_steps--;
+
+  // continue with the next segment, at the current speed
+  if ((0L == motor_group->dda_steps) && motor_group->next_valid) {
+    group_next_start(motor_group);
+  }
+
+  // the period to the next master step
+  if (ENABLE_RAMPS) {
+    group_ramp(motor_group);
+    motor_group->ticks_per_step = motor_group->ramp_period >> RAMP_SHIFT;
+  }
+
+  // reload from the deadline rather than from now, so that latency does not add drift
+  motor_group->ticks_step_count += motor_group->ticks_per_step;
+  if (0L >= motor_group->ticks_step_count) {
+    // a full step period behind, restart the cadence from now
+    motor_group->time_step_errors++;
+    motor_group->ticks_step_count = motor_group->ticks_per_step;
+  }
+
+  /* reset the power-off countdown (done by the main loop) */
+  motor_group->step_activity = true;
+}
+
+/* Serve the groups in priority order */
+ISR(TIMER1_COMPA_vect) {
+  uint8_t g;
+  MotorControllerGroup *motor_group;
+  int32_t ticks_passed = (int32_t) step_timer_period;
+  int32_t ticks_next = STEP_TIMER_TICKS_MAX; // nearest deadline of the groups still moving
+  int32_t ticks_due;
+  boolean active = false;
+
+  for (g=0;g<GROUP_MAX;g++) {
+    motor_group = motor_groups[g];
+    if (0L == motor_group->dda_steps)
+      continue;
+
+    // has enough time passed for a master step?
+    motor_group->ticks_step_count -= ticks_passed;
+    ticks_due = motor_group->ticks_step_count;
+    if (0L >= ticks_due) {
+      if (ticks_next <= (int32_t) USEC_TO_TICKS(STEP_YIELD_USEC)) {
+        // a higher priority group steps before this one could finish, so go right after it
+        motor_group->step_yields++;
+        ticks_due = ticks_next;
+      } else {
+        group_step(motor_group);
+        ticks_due = motor_group->ticks_step_count;
+      }
+    }
+
+    if (0L != motor_group->dda_steps) {
+      active = true;
+      if (ticks_next > ticks_due) ticks_next = ticks_due;
+    }
+  }
+
+  if (active) {
+    step_timer_program((uint32_t) ticks_next);
+  } else {
+    step_timer_stop();
+  }
+}
+
 
 //
 // setup()
@@ -544,6 +922,12 @@ void setup() {
   pinMode(MOTOR_POWER_A_LED,OUTPUT);
   pinMode(MOTOR_POWER_B_LED,OUTPUT);
 
+  // set the rocket controllers' microstep mode
+  rocket_group.microstep_mode(MOTOR_MODE_M0_PIN,MOTOR_MODE_M1_PIN);
+
+  // set up the step timer, stopped until there is a move
+  step_timer_init();
+
   // setup rocket motors
   motors[ 0].init("NW", MOTOR_NW, &rocket_group,MOTOR_LIMIT_NO_PIN,0);
   motors[ 1].init("NE", MOTOR_NE, &rocket_group,MOTOR_LIMIT_NO_PIN,0);
@@ -575,18 +959,17 @@ void setup() {
   if (ENABLE_MEASURE_I2C)     ave_i2c = new MicroAve();
   if (ENABLE_MEASURE_LOOP)    ave_loop = new MicroAve();
   if (ENABLE_MEASURE_UPDATE)  ave_update = new MicroAve();
-  if (ENABLE_MEASURE_LATENCY) ave_latency = new MicroAve();
+  if (ENABLE_MEASURE_LATENCY) {
+    for (i=0;i<GROUP_MAX;i++) {
+      motor_groups[i]->ave_latency = new MicroAve();
+    }
+  }
 
   // set the motor update refresh time thresholds
   // normal refresh is 200uS, assume 300uS means the user has paused
   if (ENABLE_MEASURE_UPDATE) ave_update->setThreshold(0,300);
 
-  // set the step uppdate latency buckets
-  if (ENABLE_MEASURE_LATENCY) {
-    for (i=0;i < HISTOGRAM_MAX; i++) {
-      ave_latency->setHistBucket(i,i*(256/HISTOGRAM_MAX));
-    }
-  }
+  status_build();
 
   Serial.println("Setup Done!");
   show_help();
@@ -604,105 +987,255 @@ void setup() {
 #define ACTION_HOME       4
 #define ACTION_STOP       5
 
-/* Synchronously process pending motor commands here */
-boolean action_dispatcher(MotorControllerGroup *motor_group) {
+/* Drop a group's queued segment (interrupts are off) */
+void group_next_clear(MotorControllerGroup *motor_group) {
   int8_t i;
-  uint32_t move_time,longest_move,diff;
-  uint32_t microseconds_per_step;
-  boolean request_change=false;
-  boolean request_move=false;
 
-  if (ACTION_STOP == motor_group->pending_action) {
-    motor_group->pending_action = ACTION_NONE;
-    for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
-      // declare current location as the destination
-      motors[i].step_destination = motors[i].step_location;
-    }
-    motor_group->activity_trigger();
-    request_change = true;
+  for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
+    motors[i].next_delta = 0;
   }
+  motor_group->next_valid = false;
+  motor_group->ramp_exit_n = 0L;
+}
 
-  if (ACTION_PRESET == motor_group->pending_action) {
-    motor_group->pending_action = ACTION_NONE;
-    for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
-      motors[i].step_location    = motors[i].request_value;
-      motors[i].step_destination = motors[i].request_value;
-    }
-    motor_group->activity_trigger();
-    request_change = true;
+/* A motor's share of a segment, delta/total, in Q15 (both shifted down to keep the product in 32 bits) */
+int32_t segment_share(int32_t delta, uint32_t total) {
+  while (total > 0xffffL) {
+    delta /= 2;
+    total >>= 1;
   }
+  return ((delta * 32768L) / (int32_t) total);
+}
 
-  if (ACTION_MOVE == motor_group->pending_action) {
-    motor_group->pending_action = ACTION_NONE;
-    for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
-      motors[i].step_destination = motors[i].request_value;
+/* Cruise of a move of total master steps, in useconds per step */
+uint32_t group_cruise(MotorControllerGroup *motor_group, uint32_t total) {
+  uint32_t microseconds_per_step = motor_group->req_microseconds_per_step;
+
+  if (microseconds_per_step == MOTOR_SPEED_AUTO) {
+    microseconds_per_step = motor_group->frame_microseconds/total;
+  }
+  if (microseconds_per_step < motor_group->max_speed)
+    microseconds_per_step =  motor_group->max_speed;
+  return(microseconds_per_step);
+}
+
+/* Add the requested increments to a moving group's next segment, and set the junction speed.
+ * It plans from a snapshot with the step interrupt running, and commits under a short lock
+ * (re-planning if a segment started meanwhile). False if the group has come to rest, the
+ * requests are left for a new move. */
+boolean group_next_add(MotorControllerGroup *motor_group) {
+  int8_t i,j;
+  int32_t d1[GROUP_MOTOR_MAX],d2[GROUP_MOTOR_MAX];
+  uint32_t total,dda_total,segment;
+  uint32_t microseconds_per_step,microseconds_per_step_now;
+  uint32_t ramp_exit_n;
+  int32_t du,du_max;
+  uint32_t v_junction,v_limit;
+
+  for (;;) {
+    /* snapshot the current segment and the queued one */
+    noInterrupts();
+    if (0L == motor_group->dda_steps) {
+      interrupts();
+      return(false);
     }
-    request_change = true;
-    request_move = true;
+    segment = motor_group->dda_segment;
+    dda_total = motor_group->dda_total;
+    microseconds_per_step_now = motor_group->microseconds_per_step;
+    for (i=motor_group->motor_min,j=0;i<=motor_group->motor_max;i++,j++) {
+      d1[j] = (int32_t) motors[i].dda_delta;
+      if (motors[i].step_destination < motors[i].step_location) d1[j] = -d1[j];
+      d2[j] = motors[i].next_delta;
+    }
+    interrupts();
+
+    /* the next segment, as for a new move */
+    total = 0L;
+    for (i=motor_group->motor_min,j=0;i<=motor_group->motor_max;i++,j++) {
+      d2[j] += motors[i].request_value;
+      if (total < (uint32_t) abs(d2[j])) total = abs(d2[j]);
+    }
+    if (0L != total) {
+      microseconds_per_step = group_cruise(motor_group,total);
+
+      /* junction speed: each motor moves u = delta/total steps per master step, so at a master
+       * speed v its speed changes by v*|u1-u2|, which must stay within the first ramp step's speed */
+      du_max = 0L;
+      for (j=0;j<=(motor_group->motor_max - motor_group->motor_min);j++) {
+        du = abs(segment_share(d1[j],dda_total) - segment_share(d2[j],total));
+        if (du_max < du) du_max = du;
+      }
+      v_junction = 1000000L / max(microseconds_per_step_now,microseconds_per_step);
+      if (0L != du_max) {
+        v_limit = (motor_group->ramp_v0 << 15) / (uint32_t) du_max;
+        if (v_junction > v_limit) v_junction = v_limit;
+      }
+      // ramp steps to the junction speed: n = v^2 / (2 * accel), v kept within 16 bits for the square
+      if (v_junction > 0xffffL) v_junction = 0xffffL;
+      ramp_exit_n = ((v_junction * v_junction) / motor_group->acceleration) / 2;
+    }
+
+    /* commit, unless the segment it was planned against has ended */
+    noInterrupts();
+    if (0L == motor_group->dda_steps) {
+      interrupts();
+      return(false);
+    }
+    if (segment == motor_group->dda_segment) break;
+    interrupts();
   }
 
-  if (ACTION_INCREMENT == motor_group->pending_action) {
-    motor_group->pending_action = ACTION_NONE;
-    for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
-      motors[i].step_destination += motors[i].request_value;
-      motors[i].request_value = 0;
+  // increments that cancel out leave nothing to do
+  if (0L == total) {
+    group_next_clear(motor_group);
+  } else {
+    for (i=motor_group->motor_min,j=0;i<=motor_group->motor_max;i++,j++) {
+      motors[i].next_delta = d2[j];
     }
-    request_change = true;
-    request_move = true;
+    motor_group->next_total = total;
+    motor_group->next_microseconds_per_step = microseconds_per_step;
+    motor_group->next_ramp_min = USEC_TO_TICKS(microseconds_per_step) << RAMP_SHIFT;
+    motor_group->ramp_exit_n = ramp_exit_n;
+    motor_group->next_valid = true;
+  }
+  interrupts();
+
+  for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
+    motors[i].request_value = 0;
   }
+  return(true);
+}
+
+/* Synchronously process pending motor commands here */
+boolean action_dispatcher(MotorControllerGroup *motor_group) {
+  int8_t i,j;
+  uint8_t action = motor_group->pending_action;
+  int32_t location[GROUP_MOTOR_MAX];
+  int32_t destination[GROUP_MOTOR_MAX];
+  uint32_t move_time,longest_move,diff;
+  uint32_t microseconds_per_step,ramp_min;
+  boolean was_moving;
+
+  // the requests are only written by the command loop, the step interrupt shares the motor state
+  if (ACTION_NONE == action) return(false);
+  motor_group->pending_action = ACTION_NONE;
 
-   if (request_change) {
-   /* reset countdown counters for any request */
+  if ((ACTION_STOP == action) || (ACTION_PRESET == action)) {
+    // an absolute request replaces any queued segment
+    noInterrupts();
+    group_next_clear(motor_group);
     for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
-      motors[i].microseconds_step_count = 0L;
+      if (ACTION_PRESET == action) motors[i].step_location = motors[i].request_value;
+      // declare current location as the destination
+      motors[i].step_destination = motors[i].step_location;
     }
+    motor_group->dda_steps = 0L;
+    interrupts();
+    motor_group->activity_trigger();
+    return(true);
+  }
+
+  if ((ACTION_MOVE != action) && (ACTION_INCREMENT != action)) {
+    return(false);
+  }
+
+  // an increment to a moving group is queued as the next segment, to follow the current one without a stop
+  if (ENABLE_BLEND && (ACTION_INCREMENT == action) && group_next_add(motor_group)) {
+    return(true);
   }
 
-  /* if no pending move request we are done here */
-  if (!request_move) {
-    return(request_change);
+  /* snapshot the group, an absolute move replaces any queued segment */
+  noInterrupts();
+  if (ACTION_MOVE == action) group_next_clear(motor_group);
+  for (i=motor_group->motor_min,j=0;i<=motor_group->motor_max;i++,j++) {
+    location[j] = motors[i].step_location;
+    destination[j] = motors[i].step_destination;
   }
+  interrupts();
 
   /*
-   * optimize the move request across the motors
+   * optimize the move request across the motors, with the step interrupt running
    *
    */
 
   /* compute the longest move and critical path */
   longest_move = 0L;
-  for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
+  was_moving = true;
+  for (i=motor_group->motor_min,j=0;i<=motor_group->motor_max;i++,j++) {
+    if (ACTION_MOVE == action) {
+      destination[j] = motors[i].request_value;
+    } else {
+      destination[j] += motors[i].request_value;
+      motors[i].request_value = 0;
+    }
+    diff = (uint32_t) abs(destination[j] - location[j]);
+    if (longest_move < diff) longest_move = diff;
+    /* a motor that reverses must first stop, so restart the ramp from rest */
+    if ((0L != diff) && (motors[i].step_dir == ((destination[j] > location[j]) ? -1 : 1))) {
+      was_moving = false;
+    }
+  }
+
+  /* compute time for longest move, with the speed limit */
+  microseconds_per_step = group_cruise(motor_group,max(longest_move,(uint32_t) 1L));
+  ramp_min = USEC_TO_TICKS(microseconds_per_step) << RAMP_SHIFT;
+
+  /* commit: the longest move again from where the motors are now, the steps taken meanwhile only nudge the cruise */
+  noInterrupts();
+  was_moving = was_moving && (0L != motor_group->dda_steps);
+  longest_move = 0L;
+  for (i=motor_group->motor_min,j=0;i<=motor_group->motor_max;i++,j++) {
+    motors[i].step_destination = destination[j];
     diff = motors[i].remaining_steps();
     if (longest_move < diff) longest_move = diff;
   }
 
-  /* if there is no actual movement, we are done (avoid division by zero) */
-  if (0 == longest_move) return(true);
+  /* if there is no actual movement, we are done */
+  if (0 == longest_move) {
+    motor_group->dda_steps = 0L;
+    interrupts();
+    return(true);
+  }
 
-  /* compute time for longest move */
-  microseconds_per_step = motor_group->req_microseconds_per_step;
-  if (microseconds_per_step == MOTOR_SPEED_AUTO) {
-    microseconds_per_step = USECONDS_PER_FRAME/longest_move;
+  /* set up the master clock, the first step is one period from now */
+  motor_group->microseconds_per_step = microseconds_per_step;
+  motor_group->dda_total = longest_move;
+  motor_group->dda_steps = longest_move;
+  motor_group->ramp_min = ramp_min;
+  if (!ENABLE_RAMPS) {
+    motor_group->ticks_per_step = ramp_min >> RAMP_SHIFT;
+    motor_group->ticks_step_count = motor_group->ticks_per_step + step_timer_now();
+  } else if (!was_moving) {
+    // start from rest, or at the cruise if that is slower than the first ramp step
+    motor_group->ramp_n = 0L;
+    motor_group->ramp_period = max(motor_group->ramp_c0,motor_group->ramp_min);
+    motor_group->ticks_per_step = motor_group->ramp_period >> RAMP_SHIFT;
+    motor_group->ticks_step_count = motor_group->ticks_per_step + step_timer_now();
   }
+  // else carry on from the current speed and step countdown, the ramp moves to the new cruise
 
-  /* enforce the speed limit */
-  if (microseconds_per_step < motor_group->max_speed)
-    microseconds_per_step =  motor_group->max_speed;
+  /* set up the DDA for each motor, starting half way to spread the steps evenly */
+  for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
+    motors[i].dda_delta = motors[i].remaining_steps();
+    motors[i].dda_error = longest_move / 2;
+  }
+  group_dda_select(motor_group);
+  step_timer_start();
+  interrupts();
+
+  /* power up the motors for the move */
+  motor_group->activity_trigger();
 
- 
-  /* compute countdown time for each motor */
   move_time = microseconds_per_step * longest_move;
+
   if (verbose > 1) {
     Serial.print("MOVE[");
     Serial.print(move_time);
     Serial.print("]:");
   }
   for (i=motor_group->motor_min;i<=motor_group->motor_max;i++) {
-    motors[i].microseconds_per_step = move_time / motors[i].remaining_steps();
-
     if (verbose > 1) {
-      Serial.print(motors[i].remaining_steps());
-      Serial.print(",");
-      Serial.print(motors[i].microseconds_per_step);
+      Serial.print(motors[i].dda_delta);
       Serial.print(":");
     }
   }
@@ -724,9 +1257,9 @@ void test_motor_move(int16_t count, int32_t speed) {
 Serial.println("test_motor_move:");
 Serial.println(i);
     if (MOTOR_FORWARD_REVOLUTION == count) {
-      motors[i].request_value = motors[i].controller->step_count;
+      motors[i].request_value = (int32_t) motors[i].controller->step_count * motors[i].controller->step_micro_count;
     } else if (MOTOR_BACKWARD_REVOLUTION == count) {
-      motors[i].request_value = -motors[i].controller->step_count;
+      motors[i].request_value = -((int32_t) motors[i].controller->step_count * motors[i].controller->step_micro_count);
     } else {
       motors[i].request_value=count;
     }
@@ -735,6 +1268,40 @@ Serial.println(i);
   } 
 }
 
+/* time the step output paths, giving the maximum aggregate step rate (interrupt overhead not included) */
+void step_bench_show(const char *msg, uint32_t usec) {
+  Serial.print(msg);
+  Serial.print(": ");
+  Serial.print((usec * 1000L) / STEP_BENCH_COUNT);
+  Serial.print(" nSec/step, max ");
+  Serial.print((1000000L * STEP_BENCH_COUNT) / usec);
+  Serial.println(" steps/sec");
+}
+
+void step_bench() {
+  uint16_t i;
+  uint32_t usec_start;
+
+  if (step_timer_running) {
+    Serial.println("Step bench: wait for the motors to stop");
+    return;
+  }
+
+  usec_start = micros();
+  for (i=0;i<STEP_BENCH_COUNT;i++) {
+    motor_step_pin(MOTOR_SELECT_UNUSED, (i & 1));
+  }
+  step_bench_show("Step digitalWrite",micros() - usec_start);
+
+#ifdef MOTOR_PORT_FAST
+  usec_start = micros();
+  for (i=0;i<STEP_BENCH_COUNT;i++) {
+    motor_step_port(MOTOR_SELECT_UNUSED, (i & 1));
+  }
+  step_bench_show("Step port       ",micros() - usec_start);
+#endif
+}
+
 void show_help() {
   Serial.println("");
   Serial.println("Rocket Motor: Unit Test Commands:");
@@ -746,10 +1313,44 @@ void show_help() {
   Serial.println("  b : advance motors one revolution");
   Serial.println("  h : goto high position");
   Serial.println("  l : goto low position (home)");
+  Serial.println("  t : time the step pulse, port versus digitalWrite");
   Serial.println("  v : toggle the verbose level (default: 0=off)");
   Serial.println("");
 }
 
+//
+// group context, from the main loop
+//
+
+/* Run a group's main loop context: its requests, its timing error report, its power timeout.
+ * Returns true if the group just powered down */
+boolean group_loop(MotorControllerGroup *motor_group, uint32_t usec_diff) {
+  uint16_t errors;
+
+  // Handle any pending change request
+  if (ACTION_NONE != motor_group->pending_action) {
+    action_dispatcher(motor_group);
+  }
+
+  // report the steps that fell behind (the step interrupt only counts them)
+  if (verbose > 0) {
+    noInterrupts();
+    errors = motor_group->time_step_errors;
+    interrupts();
+    if (errors != motor_group->time_step_errors_shown) {
+      motor_group->time_step_errors_shown = errors;
+      Serial.print("###ERROR_TIMING:[");
+      Serial.print(motor_group->name);
+      Serial.print("]errors=");
+      Serial.print(errors);
+      Serial.print(",usec_per_step=");
+      Serial.println(motor_group->microseconds_per_step);
+    }
+  }
+
+  return motor_group->activity_loop(usec_diff);
+}
+
 //
 // loop()
 //
@@ -765,33 +1366,25 @@ void loop() {
   uint32_t usec_diff;
   uint8_t verbose_orig = verbose;
   boolean quick_display = false;
+  boolean powered_down[GROUP_MAX];
 
   if (ENABLE_MEASURE_LOOP) ave_loop->setStop();
 
-  // Handle any pending change requests
-  if (ACTION_NONE != rocket_group.pending_action) {
-    action_dispatcher(&rocket_group);
-    return;
-  }
-  if (ACTION_NONE != ground_group.pending_action) {
-    action_dispatcher(&ground_group);
-    return;
-  }
-    
-  // get the current time
+  // Execute the queued I2C commands
+  command_loop();
+
+  // get the current time (the unsigned difference is correct across a roll over)
   usec_now = micros();
-  /* if there was a roll over, restart timer and wait this turn out */
-  if (usec_now < usec_last) {
-    usec_last = usec_now;
-    return;
-  }
   usec_diff = usec_now - usec_last;
   usec_last = usec_now;
 
-  // advance the individual motor states
-  for (i=0;i<MOTOR_MAX;i++) {
-    motors[i].step_loop(usec_diff);
+  // run each group's context, in priority order
+  for (i=0;i<GROUP_MAX;i++) {
+    powered_down[i] = group_loop(motor_groups[i], usec_diff);
   }
+
+  // refresh the status frame, now that the commands are dispatched
+  status_build();
   
   // is there a debug request?
   if (Serial.available()) {
@@ -841,6 +1434,10 @@ void loop() {
       // Controller status
       rocket_group.displayStatus();
       ground_group.displayStatus();
+      if (cmd_overflow) {
+        Serial.print("ERROR_CMD_OVERFLOW=");
+        Serial.println(cmd_overflow);
+      }
       // Motor status
       for (int8_t i=test_motor_min; i<= test_motor_max; i++) {
         motors[i].displayStatus();
@@ -854,17 +1451,33 @@ void loop() {
       if (ENABLE_MEASURE_I2C)  ave_i2c->displayResults("i2c",true);
       if (ENABLE_MEASURE_LOOP) ave_loop->displayResults("loop",true);
       if (ENABLE_MEASURE_UPDATE) ave_update->displayResults("Inc_loop",false);
-      if (ENABLE_MEASURE_LATENCY) ave_latency->displayResults("Latency",true);
+      if (ENABLE_MEASURE_LATENCY) {
+        for (i=0;i<GROUP_MAX;i++) {
+          motor_groups[i]->ave_latency->displayResults(motor_groups[i]->name,true);
+        }
+      }
     }
     
     if ('r' == char_in) {
+      noInterrupts();
       for (i=0;i<MOTOR_MAX;i++) {
         motors[i].reset();
       }
+      for (i=0;i<GROUP_MAX;i++) {
+        motor_groups[i]->dda_steps = 0L;
+        motor_groups[i]->time_step_errors = 0;
+        motor_groups[i]->time_step_errors_shown = 0;
+        motor_groups[i]->step_yields = 0;
+      }
+      interrupts();
       if (ENABLE_MEASURE_I2C) ave_i2c->reset();
       if (ENABLE_MEASURE_LOOP) ave_loop->reset();
       if (ENABLE_MEASURE_UPDATE) ave_update->reset();
-      if (ENABLE_MEASURE_LATENCY) ave_latency->reset();
+      if (ENABLE_MEASURE_LATENCY) {
+        for (i=0;i<GROUP_MAX;i++) {
+          motor_groups[i]->ave_latency->reset();
+        }
+      }
     }
 
     // move the motors forward one step
@@ -897,6 +1510,11 @@ void loop() {
         delayMicroseconds(2048);
       }
     }
+    // time the step pulse output, to an unused select
+    if ('t' == char_in) {
+      step_bench();
+    }
+
     // move the motors forward one revolution
     if ('2' == char_in) {
       test_motor_move(MOTOR_FORWARD_REVOLUTION,20000L);
@@ -971,11 +1589,11 @@ void loop() {
   // show status of recent activity
   disp_min = MOTOR_MAX;
   disp_max = MOTOR_MAX;
-  if (rocket_group.activity_loop(usec_diff)) {
+  if (powered_down[0]) {
     disp_min = MOTOR_NW;
     disp_max = MOTOR_SE;
   }
-  if (ground_group.activity_loop(usec_diff)) {
+  if (powered_down[1]) {
     if (MOTOR_MAX == disp_min) disp_min = MOTOR_00;
     disp_max = MOTOR_22;
   }
@@ -985,7 +1603,7 @@ void loop() {
     Serial.print(disp_min);
     Serial.print("]:");
     for (i=disp_min; i<= disp_max; i++) {
-      sprintf(buffer,"%04d ",motors[i].step_location);
+      sprintf(buffer,"%04ld ",(long) motors[i].step_location);
       Serial.print(buffer);
     }
     Serial.println("");
@@ -1018,6 +1636,7 @@ void receiveEvent(int16_t howMany) {
 
   uint8_t buffer[I2C_READ_MAX];
   uint8_t read_count=0;
+  uint8_t head;
 
   if (ENABLE_MEASURE_I2C) ave_i2c->setStart();
 
@@ -1027,6 +1646,40 @@ void receiveEvent(int16_t howMany) {
 
   if (0 < read_count) {
 
+    // queue the command for the main loop, in order
+    head = cmd_head;
+    if (((head + 1) & (CMD_FIFO_MAX - 1)) == cmd_tail) {
+      cmd_overflow++;
+    } else {
+      if (read_count > CMD_LEN_MAX) read_count = CMD_LEN_MAX;
+      memcpy(cmd_fifo[head].buffer,buffer,read_count);
+      cmd_fifo[head].len = read_count;
+      cmd_head = (head + 1) & (CMD_FIFO_MAX - 1);
+    }
+
+    if ((ENABLE_MEASURE_UPDATE) && (REQUEST_INCREMENT == (char) buffer[0])) {
+      ave_update->setStop();
+      ave_update->setStart();
+    }
+  }
+
+  if (ENABLE_MEASURE_I2C) ave_i2c->setStop();
+}
+
+/* Execute the queued commands, from the main loop */
+void command_loop() {
+  uint8_t tail;
+
+  while (cmd_tail != cmd_head) {
+    tail = cmd_tail;
+    command_execute(cmd_fifo[tail].buffer,cmd_fifo[tail].len);
+    cmd_tail = (tail + 1) & (CMD_FIFO_MAX - 1);
+  }
+}
+
+void command_execute(uint8_t *buffer, uint8_t read_count) {
+
+  if (0 < read_count) {
     // Stop motion
     if (REQUEST_STOP == (char) buffer[0]) {
       rocket_group.request_action(ACTION_STOP);
@@ -1067,18 +1720,17 @@ void receiveEvent(int16_t howMany) {
 
     // Next move increment
     if (REQUEST_INCREMENT == (char) buffer[0]) {
-      int16_t req_step_increment_nw,req_step_increment_ne,req_step_increment_sw,req_step_increment_se;
-      motors[MOTOR_NW].request_value = (((int16_t) buffer[1]) << 8) | ((int16_t) buffer[2]);
-      motors[MOTOR_NE].request_value = (((int16_t) buffer[3]) << 8) | ((int16_t) buffer[4]);
-      motors[MOTOR_SW].request_value = (((int16_t) buffer[5]) << 8) | ((int16_t) buffer[6]);
-      motors[MOTOR_SE].request_value = (((int16_t) buffer[7]) << 8) | ((int16_t) buffer[8]);
+      // signed 16-bit increments, larger moves arrive as several increments
+      motors[MOTOR_NW].request_value = (int16_t) ((((uint16_t) buffer[1]) << 8) | ((uint16_t) buffer[2]));
+      motors[MOTOR_NE].request_value = (int16_t) ((((uint16_t) buffer[3]) << 8) | ((uint16_t) buffer[4]));
+      motors[MOTOR_SW].request_value = (int16_t) ((((uint16_t) buffer[5]) << 8) | ((uint16_t) buffer[6]));
+      motors[MOTOR_SE].request_value = (int16_t) ((((uint16_t) buffer[7]) << 8) | ((uint16_t) buffer[8]));
+      if (11 <= read_count) {
+        // the controller's frame period (mSec), absent from older controllers
+        rocket_group.request_frame(((((uint32_t) buffer[9]) << 8) | ((uint32_t) buffer[10])) * 1000L);
+      }
       rocket_group.request_speed(MOTOR_SPEED_AUTO);
       rocket_group.request_action(ACTION_INCREMENT);
-
-      if (ENABLE_MEASURE_UPDATE) {
-        ave_update->setStop();
-        ave_update->setStart();
-      }
     }
 
     // set up a specific motor location and/or destination
@@ -1090,96 +1742,132 @@ void receiveEvent(int16_t howMany) {
 
     // set up a specific motor location and/or destination
     if (REQUEST_ROCKET_LOC == (char) buffer[0]){
-      motors[MOTOR_NW].request_value = (((uint16_t) buffer[1]) << 8) | ((uint16_t) buffer[2]);
-      motors[MOTOR_NE].request_value = (((uint16_t) buffer[3]) << 8) | ((uint16_t) buffer[4]);
-      motors[MOTOR_SW].request_value = (((uint16_t) buffer[5]) << 8) | ((uint16_t) buffer[6]);
-      motors[MOTOR_SE].request_value = (((uint16_t) buffer[7]) << 8) | ((uint16_t) buffer[8]);
+      // unsigned 16-bit positions, up to 65535 microsteps
+      motors[MOTOR_NW].request_value = (uint16_t) ((((uint16_t) buffer[1]) << 8) | ((uint16_t) buffer[2]));
+      motors[MOTOR_NE].request_value = (uint16_t) ((((uint16_t) buffer[3]) << 8) | ((uint16_t) buffer[4]));
+      motors[MOTOR_SW].request_value = (uint16_t) ((((uint16_t) buffer[5]) << 8) | ((uint16_t) buffer[6]));
+      motors[MOTOR_SE].request_value = (uint16_t) ((((uint16_t) buffer[7]) << 8) | ((uint16_t) buffer[8]));
     }
 
-    // Set next request mode
-    if ('?' == (char) buffer[0]) {
-      request_command = buffer[1];
-      if (verbose > 2) {
-        Serial.print("*** I2C Next Request Mode=");
-        Serial.println((char) request_command);
-      }
-    }
+    // dispatch each command before the next, so that none is overwritten
+    if (ACTION_NONE != rocket_group.pending_action) action_dispatcher(&rocket_group);
+    if (ACTION_NONE != ground_group.pending_action) action_dispatcher(&ground_group);
+  }
+
+  if (verbose > 2) display_cmnd(read_count,read_count,buffer);
+}
+
+void status_put16(uint8_t *buffer, uint8_t offset, uint16_t value) {
+  buffer[offset  ] = (value >>  8) & 0x00ff;
+  buffer[offset+1] = (value      ) & 0x00ff;
+}
 
+/* remaining milliseconds of a group's move, including its queued segment (16-bit) */
+uint16_t status_remain(MotorControllerGroup *motor_group) {
+  uint32_t dda_steps,microseconds_per_step,next_total,next_microseconds_per_step;
+  uint32_t time_remain;
+
+  // the step interrupt may start the next segment, so take a consistent copy
+  next_total = 0;
+  next_microseconds_per_step = 0;
+  noInterrupts();
+  dda_steps = motor_group->dda_steps;
+  microseconds_per_step = motor_group->microseconds_per_step;
+  if (motor_group->next_valid) {
+    next_total = motor_group->next_total;
+    next_microseconds_per_step = motor_group->next_microseconds_per_step;
   }
+  interrupts();
 
-  if (ENABLE_MEASURE_I2C) ave_i2c->setStop();
-  if (verbose > 2) display_cmnd(howMany,read_count,buffer);
+  time_remain = (dda_steps * microseconds_per_step) / 1000L;
+  time_remain += (next_total * next_microseconds_per_step) / 1000L;
+  if (time_remain > 32000) time_remain = 32000; /* keep it to 16-bits */
+  return (uint16_t) time_remain;
 }
 
-void requestEvent() {
+/* Prebuild the status frame, from the main loop, all but the locations and the checksum */
+void status_build() {
   uint8_t i;
-  uint8_t buffer[20];
-  int16_t step_compare = MOTOR_DEST_MAX / 2;
-  int16_t step_diff;
-  int16_t step_diff_max = 0L;
-  int32_t time_remain = 0L;
-
-  if (REQUEST_MOVE_STATUS == request_command) {
-    // compute average percent of location differences
-    for (i=0;i<MOTOR_MAX;i++) {
-      step_diff = abs(motors[i].step_location - motors[i].step_destination);
-      if (step_diff_max < step_diff) step_diff_max = step_diff;
-    }
-    //compare this value to half of MOTOR_DEST_MAX, get percent close
-    if (step_diff > step_compare) {
-      step_compare=0;
-    } else {
-       step_compare = ((step_compare - step_diff) * 100L)/step_compare;
-    }
-    buffer[0] = (uint8_t) step_compare;
-    Wire.write(buffer[0]); // respond with message of 1 byte
-  } else if (REQUEST_POSITION == request_command) {
-    buffer[ 0]= (motors[MOTOR_NW].step_location >>  8) & 0x00ffL;
-    buffer[ 1]= (motors[MOTOR_NW].step_location      ) & 0x00ffL;
-
-    buffer[ 2]= (motors[MOTOR_NE].step_location >>  8) & 0x00ffL;
-    buffer[ 3]= (motors[MOTOR_NE].step_location      ) & 0x00ffL;
-
-    buffer[ 4]= (motors[MOTOR_SW].step_location >>  8) & 0x00ffL;
-    buffer[ 5]= (motors[MOTOR_SW].step_location      ) & 0x00ffL;
-
-    buffer[ 6]= (motors[MOTOR_SE].step_location >>  8) & 0x00ffL;
-    buffer[ 7]= (motors[MOTOR_SE].step_location      ) & 0x00ffL;
-
-    Wire.write(buffer,8);
-  } else if (REQUEST_TIME_STATUS == request_command) {
-    // current move's remaining microseconds
-    int32_t steps_max = 0L;
-    int32_t steps_speed = 0L;
-    for (i=0;i<MOTOR_MAX;i++) {
-      if (steps_max < motors[i].remaining_steps()) {
-        steps_max = motors[i].remaining_steps();
-        steps_speed = motors[i].microseconds_per_step;
-      }
-    }
-    if (0L == steps_max) {
-      time_remain = 0L;
-    } else {
-      time_remain = steps_max;
-      time_remain *= (int32_t) steps_speed;
-      time_remain /= 1000L; /* convert to milliseconds */
-      if (time_remain > 32000) time_remain = 32000; /* keep it to 16-bits */
+  uint8_t buffer[STATUS_LEN];
+  uint8_t flags = 0;
+  uint8_t tail;
+  int32_t step_compare = (MOTOR_DEST_MAX * MOTOR_MICRO_A) / 2;
+  int32_t step_location,step_destination;
+  int32_t step_diff;
+  int32_t step_diff_max = 0L;
+  uint16_t ground_moving = 0;
+  uint16_t rocket_errors,ground_errors,overflow;
+
+  // every command taken from the FIFO so far has been dispatched into the state below
+  tail = cmd_tail;
+
+  // progress: the largest location difference, compared to half of MOTOR_DEST_MAX
+  memset(buffer,0,STATUS_LEN);
+  for (i=0;i<MOTOR_MAX;i++) {
+    noInterrupts();
+    step_location = motors[i].step_location;
+    step_destination = motors[i].step_destination;
+    interrupts();
+    step_diff = abs(step_location - step_destination);
+    if (step_diff_max < step_diff) step_diff_max = step_diff;
+    if ((i >= MOTOR_00) && (0 != step_diff)) ground_moving |= 1 << (i - MOTOR_00);
+    if (i <= MOTOR_SE) {
+      status_put16(buffer,STATUS_DESTINATION + (i * 2),(uint16_t) (step_destination + motors[i].next_delta));
     }
-    buffer[ 0]= (time_remain >>  8) & 0x00ffL;
-    buffer[ 1]= (time_remain      ) & 0x00ffL;
-    Wire.write(buffer,2);
-  } else if (REQUEST_SPEED_LIMIT == request_command) {
-    // minimum micro seconds per step
-    buffer[ 0]= (rocket_group.max_speed >>  8) & 0x00ffL;
-    buffer[ 1]= (rocket_group.max_speed      ) & 0x00ffL;
-    buffer[ 2]= (ground_group.max_speed >>  8) & 0x00ffL;
-    buffer[ 3]= (ground_group.max_speed      ) & 0x00ffL;
-    Wire.write(buffer,4);
+  }
+  if (rocket_group.next_valid) step_diff_max = step_compare; // more to come
+  if (step_diff_max > step_compare) {
+    step_compare=0;
   } else {
-    // unknown request state
-    buffer[0] = (uint8_t) '?';
-    Wire.write(1); // respond with message of 1 byte
+    step_compare = ((step_compare - step_diff_max) * 100L)/step_compare;
   }
 
+  if (rocket_group.power_on)    flags |= STATUS_FLAG_ROCKET_POWER;
+  if (ground_group.power_on)    flags |= STATUS_FLAG_GROUND_POWER;
+  if (rocket_group.dda_steps)   flags |= STATUS_FLAG_ROCKET_MOVING;
+  if (ground_group.dda_steps)   flags |= STATUS_FLAG_GROUND_MOVING;
+  if (rocket_group.next_valid)  flags |= STATUS_FLAG_ROCKET_NEXT;
+
+  noInterrupts();
+  rocket_errors = rocket_group.time_step_errors;
+  ground_errors = ground_group.time_step_errors;
+  overflow = cmd_overflow;
+  interrupts();
+
+  buffer[STATUS_PROGRESS] = (uint8_t) step_compare;
+  buffer[STATUS_VERSION_OFFSET] = STATUS_VERSION;
+  buffer[STATUS_FLAGS] = flags;
+  status_put16(buffer,STATUS_ROCKET_REMAIN,status_remain(&rocket_group));
+  status_put16(buffer,STATUS_GROUND_REMAIN,status_remain(&ground_group));
+  status_put16(buffer,STATUS_ROCKET_ERRORS,rocket_errors);
+  status_put16(buffer,STATUS_GROUND_ERRORS,ground_errors);
+  status_put16(buffer,STATUS_GROUND_MOVING,ground_moving);
+  buffer[STATUS_CMD_OVERFLOW] = (overflow > 255) ? 255 : (uint8_t) overflow;
+
+  // publish it whole, the request interrupt never sees a half built frame
+  noInterrupts();
+  memcpy(status_frame,buffer,STATUS_LEN);
+  status_cmd_tail = tail;
+  interrupts();
 }
 
+/* Send the prebuilt status frame, with the current locations, from the request interrupt */
+void requestEvent() {
+  uint8_t i;
+  uint8_t buffer[STATUS_LEN];
+  uint8_t sum = 0;
+
+  memcpy(buffer,status_frame,STATUS_LEN);
+  buffer[STATUS_SEQUENCE] = status_sequence++;
+  if (cmd_head != status_cmd_tail) buffer[STATUS_FLAGS] |= STATUS_FLAG_CMD_PENDING;
+  for (i=MOTOR_NW;i<=MOTOR_SE;i++) {
+    status_put16(buffer,STATUS_LOCATION + (i * 2),(uint16_t) motors[i].step_location);
+  }
+
+  for (i=0;i<STATUS_CHECKSUM;i++) {
+    sum += buffer[i];
+  }
+  buffer[STATUS_CHECKSUM] = (uint8_t) (0 - sum);
+
+  Wire.write(buffer,STATUS_LEN);
+}